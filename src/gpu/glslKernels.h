@@ -20,45 +20,12 @@ const std::string glsl_vertex(R"V0G0N(
     }
 )V0G0N");
 
-// --- Full kernel --- //
-const std::string glsl_process(R"V0G0N(
-
-    // Input from vertex shader
-    in vec2 texCoord;
+// --- Input sampling --- //
+// Where a fragment reads the input, shared by the full
+// kernel and the tiled render tests
+const std::string glsl_sampling(R"V0G0N(
 
-    // Uniforms
     uniform sampler2D inputTexture;     // Input image (imgIn)
-    uniform vec4 baseColor;             // Base color RGB values
-    uniform vec4 blackPoint;
-    uniform vec4 whitePoint;
-    uniform vec4 G_blackpoint;
-    uniform vec4 G_whitepoint;
-    uniform vec4 G_lift;
-    uniform vec4 G_gain;
-    uniform vec4 G_mult;
-    uniform vec4 G_offset;
-    uniform vec4 G_gamma;
-    uniform vec3 G_matrixR;
-    uniform vec3 G_matrixG;
-    uniform vec3 G_matrixB;
-    uniform float G_temp;
-    uniform float G_tint;
-    uniform float G_sat;
-    uniform float G_sharpen;
-    uniform float G_sharpenRadius;
-    uniform vec2  G_curveW[16]; // Master/luminance curve
-    uniform int   G_curveW_n;
-    uniform vec2  G_curveR[16]; // Red channel curve
-    uniform int   G_curveR_n;
-    uniform vec2  G_curveG[16]; // Green channel curve
-    uniform int   G_curveG_n;
-    uniform vec2  G_curveB[16]; // Blue channel curve
-    uniform int   G_curveB_n;
-    uniform int bypass;
-    uniform int gradeBypass;
-    uniform int secEnable; // 1 = wb, 2 = tone, 4 = curves, 8 = matrix
-    uniform int showClip;
-    uniform int channelView;
     // For Cropping
     uniform vec2 imageCropMin;  // Top-left corner of crop rectangle
     uniform vec2 imageCropMax;  // Bottom-right corner of crop rectangle
@@ -66,14 +33,9 @@ const std::string glsl_process(R"V0G0N(
     uniform bool cropEnabled;  // Whether to apply crop
     uniform bool cropVisible;  // Whether to apply crop
     uniform vec2 imageSize;  // Original image dimensions
-    uniform int proxyPass;
-
-    // Output
-    //out vec4 fragColor;
-    //out vec4 fragColorSm;
-
-    layout(location = 0) out vec4 fragColor;
-    //layout(location = 1) out vec4 fragColorSm;
+    // For tiled renders (see tilePlan.h), 0,0,1,1 otherwise
+    uniform vec4 outputTile;    // This viewport's offset and size in output UV
+    uniform vec4 inputTile;     // Input texture's offset in image UV, and image/texture size
 
     // Calculate UV coordinates for cropped and rotated region
     vec2 getCroppedRotatedUV(vec2 uv) {
@@ -122,6 +84,69 @@ const std::string glsl_process(R"V0G0N(
         return finalUV;
     }
 
+    // The input pixel under this fragment, false if the
+    // crop or rotation puts it outside the image
+    bool sampleInput(vec2 uv, out vec4 pixel) {
+        vec2 sampleUV = outputTile.xy + uv * outputTile.zw;
+        if (cropEnabled || cropVisible) {
+            sampleUV = getCroppedRotatedUV(sampleUV);
+
+            // Check if we're outside the valid texture bounds
+            if (sampleUV.x < 0.0 || sampleUV.x > 1.0 ||
+                sampleUV.y < 0.0 || sampleUV.y > 1.0) {
+                return false;
+            }
+        }
+        pixel = texture(inputTexture, (sampleUV - inputTile.xy) * inputTile.zw);
+        return true;
+    }
+)V0G0N");
+
+// --- Full kernel --- //
+const std::string glsl_process = glsl_sampling + R"V0G0N(
+
+    // Input from vertex shader
+    in vec2 texCoord;
+
+    // Uniforms
+    uniform vec4 baseColor;             // Base color RGB values
+    uniform vec4 blackPoint;
+    uniform vec4 whitePoint;
+    uniform vec4 G_blackpoint;
+    uniform vec4 G_whitepoint;
+    uniform vec4 G_lift;
+    uniform vec4 G_gain;
+    uniform vec4 G_mult;
+    uniform vec4 G_offset;
+    uniform vec4 G_gamma;
+    uniform vec3 G_matrixR;
+    uniform vec3 G_matrixG;
+    uniform vec3 G_matrixB;
+    uniform float G_temp;
+    uniform float G_tint;
+    uniform float G_sat;
+    uniform float G_sharpen;
+    uniform float G_sharpenRadius;
+    // Compiled tone curves, W/R/G/B in the x/y/z/w lanes (see curveLUT.h)
+    uniform vec4  G_curveKnots[16];   // Control point x
+    uniform vec4  G_curveInvDx[15];   // 1 / segment width
+    uniform vec4  G_curveCoef[60];    // Cubic per segment, [channel * 15 + segment]
+    uniform vec4  G_curveExtrap[4];   // slopeLo, slopeHi, yLo, yHi per channel
+    uniform ivec4 G_curveN;           // Control point count per channel
+    uniform int bypass;
+    uniform int gradeBypass;
+    uniform int secEnable; // 1 = wb, 2 = tone, 4 = curves, 8 = matrix
+    uniform int showClip;
+    uniform int channelView;
+    uniform int proxyPass;
+
+    // Output
+    //out vec4 fragColor;
+    //out vec4 fragColorSm;
+
+    layout(location = 0) out vec4 fragColor;
+    //layout(location = 1) out vec4 fragColorSm;
+
     //---LUMA---//
     float luma(vec4 inputPixel)
     {
@@ -164,63 +189,30 @@ const std::string glsl_process(R"V0G0N(
 
     // --- Tone Curve Evaluation -----------------------------------------------
     // Monotone cubic Hermite spline through n control points (2 … 16).
-    // Each point is (input_x, output_y) with both axes in [0, 1].
-    // Tangents use the non-uniform Catmull-Rom formula, then clamped via
-    // the Fritsch-Carlson condition so the curve never overshoots.
-    float evalCurve(vec2 pts[16], int n, float v) {
-        // --- Linear extrapolation below black point ---
-        if (v < pts[0].x) {
-            float dx0 = max(pts[1].x - pts[0].x, 0.0001);
-            float s0  = (pts[1].y - pts[0].y) / dx0;
-            return pts[0].y + s0 * (v - pts[0].x);
-        }
-
-        // --- Linear extrapolation above white point ---
-        if (v > pts[n - 1].x) {
-            float dxN = max(pts[n-1].x - pts[n-2].x, 0.0001);
-            float sN  = (pts[n-1].y - pts[n-2].y) / dxN;
-            return pts[n-1].y + sN * (v - pts[n-1].x);
-        }
+    // The slopes are solved on the CPU (compileCurve), so each segment is
+    // a plain cubic in u = (v - x[seg]) / dx. Outside the control points
+    // the curve is extended linearly.
+    // ch: 0 = W, 1 = R, 2 = G, 3 = B
+    float evalCurve(int ch, float v) {
+        int n = G_curveN[ch];
+        if (n < 2) return v;
+
+        vec4 ex = G_curveExtrap[ch];
+        float x0 = G_curveKnots[0][ch];
+        float xN = G_curveKnots[n - 1][ch];
+        // --- Linear extrapolation below black / above white point ---
+        if (v < x0) return ex.z + ex.x * (v - x0);
+        if (v > xN) return ex.w + ex.y * (v - xN);
 
         // Find the segment [seg, seg+1] that contains v
         int seg = n - 2;
         for (int i = 0; i < n - 1; i++) {
-            if (v < pts[i + 1].x) { seg = i; break; }
-        }
-        int pprev = max(seg - 1, 0);
-        int pnext = min(seg + 2, n - 1);
-
-        vec2 pa = pts[seg],    pb = pts[seg + 1];
-        vec2 pp = pts[pprev],  pn = pts[pnext];
-
-        float dx = pb.x - pa.x;
-        if (dx < 0.0001) return pa.y;
-
-        // Non-uniform Catmull-Rom slopes (in output/input units)
-        float dxPrev = max(pb.x - pp.x, 0.0001);
-        float dxNext = max(pn.x - pa.x, 0.0001);
-        float m0 = (pb.y - pp.y) / dxPrev;
-        float m1 = (pn.y - pa.y) / dxNext;
-
-        // Fritsch-Carlson monotonicity: clamp slope ratio to [-3, 3]
-        float delta = (pb.y - pa.y) / dx;
-        if (abs(delta) < 0.0001) {
-            m0 = 0.0; m1 = 0.0;
-        } else {
-            m0 = clamp(m0 / delta, -3.0, 3.0) * delta;
-            m1 = clamp(m1 / delta, -3.0, 3.0) * delta;
+            if (v < G_curveKnots[i + 1][ch]) { seg = i; break; }
         }
 
-        // Cubic Hermite basis
-        float u  = (v - pa.x) / dx;
-        float u2 = u  * u;
-        float u3 = u2 * u;
-        float h00 =  2.0*u3 - 3.0*u2 + 1.0;
-        float h10 =      u3 - 2.0*u2 + u;
-        float h01 = -2.0*u3 + 3.0*u2;
-        float h11 =      u3 -     u2;
-
-        return h00*pa.y + h10*dx*m0 + h01*pb.y + h11*dx*m1;
+        vec4 k = G_curveCoef[ch * 15 + seg];
+        float u = (v - G_curveKnots[seg][ch]) * G_curveInvDx[seg][ch];
+        return k.x + u * (k.y + u * (k.z + u * k.w));
     }
 
     vec4 imgProcess(vec4 inputPixel) {
@@ -299,21 +291,13 @@ const std::string glsl_process(R"V0G0N(
 
     void main()
     {
-        vec2 sampleUV = texCoord;
-        if (cropEnabled || cropVisible) {
-            sampleUV = getCroppedRotatedUV(texCoord);
-
-            // Check if we're outside the valid texture bounds
-            if (sampleUV.x < 0.0 || sampleUV.x > 1.0 ||
-                sampleUV.y < 0.0 || sampleUV.y > 1.0) {
-                // Output black for areas outside the image
-                fragColor = vec4(0.0, 0.0, 0.0, 1.0);
-                //fragColorSm = fragColor;
-                return;
-            }
+        vec4 inputPixel;
+        if (!sampleInput(texCoord, inputPixel)) {
+            // Output black for areas outside the image
+            fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+            //fragColorSm = fragColor;
+            return;
         }
-
-        vec4 inputPixel = texture(inputTexture, sampleUV);
         vec4 gradedPixel = imgProcess(inputPixel);
         gradedPixel.w = 1.0f;
         vec4 outPixel = OCIOFUNC(gradedPixel);
@@ -322,13 +306,13 @@ const std::string glsl_process(R"V0G0N(
         // CURVES - Do in final ODT space for better feel
         if ((secEnable & 4) != 0) {
             // RGB Curves
-            outPixel.x = evalCurve(G_curveR, G_curveR_n, outPixel.x);
-            outPixel.y = evalCurve(G_curveG, G_curveG_n, outPixel.y);
-            outPixel.z = evalCurve(G_curveB, G_curveB_n, outPixel.z);
+            outPixel.x = evalCurve(1, outPixel.x);
+            outPixel.y = evalCurve(2, outPixel.y);
+            outPixel.z = evalCurve(3, outPixel.z);
             // Master (W/luminance) curve applied after per-channel RGB
-            outPixel.x = evalCurve(G_curveW, G_curveW_n, outPixel.x);
-            outPixel.y = evalCurve(G_curveW, G_curveW_n, outPixel.y);
-            outPixel.z = evalCurve(G_curveW, G_curveW_n, outPixel.z);
+            outPixel.x = evalCurve(0, outPixel.x);
+            outPixel.y = evalCurve(0, outPixel.y);
+            outPixel.z = evalCurve(0, outPixel.z);
         }
         outPixel = bypass == 1 || gradeBypass == 1 ? ODTPixel : outPixel;
 
@@ -365,5 +349,34 @@ const std::string glsl_process(R"V0G0N(
             fragColor = soloColor;
 
     }
+)V0G0N";
+
+// --- Histogram --- //
+const std::string glsl_histogram(R"V0G0N(
+    #version 330 core
+
+    out vec4 fragColor;
+
+    uniform sampler1D histBins;     // Bar heights in pixels, R/G/B/luma
+    uniform float intensity;
+    uniform int histWidth;
+    uniform int histHeight;
+
+    void main()
+    {
+        // One bin per column, bars grow up from the last row
+        int bin = int(gl_FragCoord.x) * 512 / histWidth;
+        vec4 bar = texelFetch(histBins, bin, 0);
+        float fromBottom = float(histHeight) - floor(gl_FragCoord.y);
+        bvec4 lit = greaterThanEqual(bar, vec4(fromBottom));
+
+        // Luma in white under additive R, G, B
+        vec3 color = vec3(0.06);
+        if (lit.w)
+            color = vec3(intensity);
+        else if (any(lit.xyz))
+            color = vec3(lit.xyz) * (200.0 / 255.0) * intensity;
+        fragColor = vec4(color, 1.0);
+    }
 )V0G0N");
 #endif
@@ -20,8 +20,26 @@ openglGPU::openglGPU() {
 
 openglGPU::~openglGPU() {
 
-    glDeleteProgram(m_shaderProgram);
+    // Exports waiting on a readback still get their pixels
+    m_transfer.finish();
+    m_transfer.release();
+    // Programs and their LUT textures go with the cache
+    m_activeShader.reset();
+    m_programCache.clear();
+    deleteInputTex(m_inputTexCache.clear());
+    glDeleteTextures(1, &m_inputTexture);
+    glDeleteTextures(1, &m_tileInTex);
+    glDeleteTextures(1, &m_tileOutTex);
+    glDeleteFramebuffers(1, &m_tileFBO);
     glDeleteFramebuffers(1, &m_smallFBO);
+    glDeleteProgram(m_histProgram);
+    glDeleteFramebuffers(1, &m_histFBO);
+    glDeleteTextures(1, &m_histBinTex);
+    glDeleteTextures(2, m_histoTex);
+    unmapHistReadback();
+    glDeleteBuffers(2, m_histPBO);
+    if (m_histFence)
+        glDeleteSync(m_histFence);
 
 }
 
@@ -39,7 +57,7 @@ bool openglGPU::initialize(ocioSetting &ocioSet) {
     }
 
     // Create shaders
-    if (!createShaders(ocioSet)) {
+    if (!useShaders(ocioSet)) {
         LOG_ERROR("Failed to create shaders");
         return false;
     }
@@ -47,18 +65,21 @@ bool openglGPU::initialize(ocioSetting &ocioSet) {
     // Setup geometry
     setupGeometry();
 
-    // Setup Histogram Texture
-    glGenTextures(1, &m_histoTex);
-    glBindTexture(GL_TEXTURE_2D, m_histoTex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, HISTWIDTH, HISTHEIGHT,
-                 0, GL_RGBA, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // Setup Histogram Textures, shown and being drawn
+    glGenTextures(2, m_histoTex);
+    for (GLuint tex : m_histoTex) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, HISTWIDTH, HISTHEIGHT,
+                     0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
 
-    // Set up out histogram buffer
-    m_histPixels = new float[HISTWIDTH * HISTHEIGHT * 4];
+    // Histogram is drawn into it from the bin counts
+    if (!createHistShader())
+        LOG_WARN("Histogram shader unavailable, histogram will not update");
 
     // Persistent FBO used for the proxy blit every render
     glGenFramebuffers(1, &m_smallFBO);
@@ -113,14 +134,11 @@ void openglGPU::cacheUniformLocations() {
     m_uniforms.G_matrixB = glGetUniformLocation(m_shaderProgram, "G_matrixB");
     m_uniforms.G_sharpen = glGetUniformLocation(m_shaderProgram, "G_sharpen");
     m_uniforms.G_sharpenRadius = glGetUniformLocation(m_shaderProgram, "G_sharpenRadius");
-    m_uniforms.G_curveW   = glGetUniformLocation(m_shaderProgram, "G_curveW[0]");
-    m_uniforms.G_curveW_n = glGetUniformLocation(m_shaderProgram, "G_curveW_n");
-    m_uniforms.G_curveR   = glGetUniformLocation(m_shaderProgram, "G_curveR[0]");
-    m_uniforms.G_curveR_n = glGetUniformLocation(m_shaderProgram, "G_curveR_n");
-    m_uniforms.G_curveG   = glGetUniformLocation(m_shaderProgram, "G_curveG[0]");
-    m_uniforms.G_curveG_n = glGetUniformLocation(m_shaderProgram, "G_curveG_n");
-    m_uniforms.G_curveB   = glGetUniformLocation(m_shaderProgram, "G_curveB[0]");
-    m_uniforms.G_curveB_n = glGetUniformLocation(m_shaderProgram, "G_curveB_n");
+    m_uniforms.G_curveKnots  = glGetUniformLocation(m_shaderProgram, "G_curveKnots[0]");
+    m_uniforms.G_curveInvDx  = glGetUniformLocation(m_shaderProgram, "G_curveInvDx[0]");
+    m_uniforms.G_curveCoef   = glGetUniformLocation(m_shaderProgram, "G_curveCoef[0]");
+    m_uniforms.G_curveExtrap = glGetUniformLocation(m_shaderProgram, "G_curveExtrap[0]");
+    m_uniforms.G_curveN      = glGetUniformLocation(m_shaderProgram, "G_curveN");
     m_uniforms.bypass = glGetUniformLocation(m_shaderProgram, "bypass");
     m_uniforms.gradeBypass = glGetUniformLocation(m_shaderProgram, "gradeBypass");
     m_uniforms.secEnable = glGetUniformLocation(m_shaderProgram, "secEnable");
@@ -133,6 +151,8 @@ void openglGPU::cacheUniformLocations() {
     m_uniforms.cropEnabled = glGetUniformLocation(m_shaderProgram, "cropEnabled");
     m_uniforms.cropVisible = glGetUniformLocation(m_shaderProgram, "cropVisible");
     m_uniforms.imageSize = glGetUniformLocation(m_shaderProgram, "imageSize");
+    m_uniforms.outputTile = glGetUniformLocation(m_shaderProgram, "outputTile");
+    m_uniforms.inputTile = glGetUniformLocation(m_shaderProgram, "inputTile");
     m_uniforms.proxyPass = glGetUniformLocation(m_shaderProgram, "proxyPass");
 }
 
@@ -195,58 +215,6 @@ GLuint openglGPU::compileShader(const std::string& source, GLenum type) {
     return shader;
 }
 
-bool openglGPU::createShaders(ocioSetting& ocioSet) {
-
-    // Get OCIO Context
-    OCIO::GpuShaderDescRcPtr gpuDesc = ocioProc.getGLDesc(ocioSet);
-
-    if (!gpuDesc) {
-        LOG_ERROR("Unable to get OCIO GPU Context!");
-        checkError("OCIO GPU Description");
-        return false;
-    }
-
-    if (m_ocioBuilder && m_prevOCIO != ocioSet) {
-        // Clear cached uniform locations
-        memset(&m_uniforms, -1, sizeof(m_uniforms));
-    }
-
-    m_ocioBuilder = OCIO::OpenGLBuilder::Create(gpuDesc);
-
-    checkError("OCIO Processor Creation");
-
-    m_ocioBuilder->allocateAllTextures(1);
-    checkError("OCIO Texture Allocation");
-
-    std::string ocioKernText = glsl_process;
-    auto nPos = ocioKernText.find("OCIOFUNC");
-    if (nPos != std::string::npos) {
-        auto nSize = std::string("OCIOFUNC").size();
-        std::string kernFunc = gpuDesc->getFunctionName();
-        ocioKernText.erase(ocioKernText.begin() + nPos, ocioKernText.begin() + nPos + nSize);
-        ocioKernText.insert(nPos, kernFunc);
-    } else {
-        LOG_ERROR("Corrupted GLSL shaders!");
-        return false;
-    }
-
-    GLuint vertexShader = compileShader(glsl_vertex, GL_VERTEX_SHADER);
-    checkError("Vertex Shader Compilation");
-
-    try {
-        // Build the fragment shader program.
-        m_ocioBuilder->buildProgram(ocioKernText.c_str(), false, vertexShader);
-    } catch (OCIO::Exception& e) {
-        LOG_ERROR("Unable to build shaders: {}", e.what());
-    }
-
-    m_shaderProgram = m_ocioBuilder->getProgramHandle();
-    cacheUniformLocations();
-    m_prevOCIO = ocioSet;
-
-    return true;
-}
-
 bool openglGPU::bufferCheck(image* _image)
 {
     if (!_image)
@@ -255,10 +223,6 @@ bool openglGPU::bufferCheck(image* _image)
     unsigned int nWidth = _image->fullIm ? _image->rawWidth : _image->width;
     unsigned int nHeight = _image->fullIm ? _image->rawHeight : _image->height;
 
-    // Store original dimensions for shader
-    unsigned int originalWidth = nWidth;
-    unsigned int originalHeight = nHeight;
-
     // Calculate cropped dimensions if crop is enabled
     if (_image->imgParam.cropEnable) {
         // Calculate crop rectangle dimensions
@@ -273,27 +237,6 @@ bool openglGPU::bufferCheck(image* _image)
     if (nWidth != m_width || nHeight != m_height) {
         LOG_INFO("Resizing Buffers from {}x{} to {}x{}", m_width, m_height, nWidth, nHeight);
 
-        // Create input texture (always use original dimensions)
-        if (m_inputTexture == 0 || glIsTexture(m_inputTexture) == GL_FALSE) {
-            glGenTextures(1, &m_inputTexture);
-            checkError("Generating Input Texture");
-        }
-        glBindTexture(GL_TEXTURE_2D, m_inputTexture);
-        while(glGetError() != GL_NO_ERROR){} // Clear errors
-
-        // Input texture should always be original size
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, originalWidth, originalHeight,
-                     0, GL_RGBA, GL_FLOAT, nullptr);
-        activeInputBytes = originalWidth * originalHeight * 4 * sizeof(float);
-        checkError("Allocating Input Texture");
-        if (m_status.error)
-            return false;
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        checkError("Setting Input Texture Parameters");
-
         m_width = nWidth;
         m_height = nHeight;
     }
@@ -363,40 +306,7 @@ bool openglGPU::bufferCheck(image* _image)
     glBindTexture(GL_TEXTURE_2D, 0);*/
 
     // Create small output texture
-    float scaleFactor = appPrefs.prefs.proxyRes;
-    if (_image->glTextureSm == 0 || !glIsTexture(_image->glTextureSm)) {
-        glGenTextures(1, (GLuint*)&_image->glTextureSm);
-        glBindTexture(GL_TEXTURE_2D, _image->glTextureSm);
-        int smWidth = std::max(1, (int)((float)nWidth * scaleFactor));
-        int smHeight = std::max(1, (int)((float)nHeight * scaleFactor));
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, smWidth, smHeight,
-                     0, GL_RGBA, GL_FLOAT, nullptr);
-        _image->glSmBufSize = (smWidth * smHeight * 4 * sizeof(uint8_t));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        checkError("Creating Small Output Texture");
-    } else {
-        glBindTexture(GL_TEXTURE_2D, _image->glTextureSm);
-        int oWidth, oHeight;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &oWidth);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &oHeight);
-        checkError("Querying Small Output Texture");
-        int smWidth = std::max(1, (int)((float)nWidth * scaleFactor));
-        int smHeight = std::max(1, (int)((float)nHeight * scaleFactor));
-        if (oWidth != smWidth || oHeight != smHeight) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, smWidth, smHeight,
-                         0, GL_RGBA, GL_FLOAT, nullptr);
-            _image->glSmBufSize = (smWidth * smHeight * 4 * sizeof(uint8_t));
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            checkError("Resizing Small Output Texture");
-        }
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    proxyTexture(_image, nWidth, nHeight);
 
     if (m_framebuffer == 0) {
         glGenFramebuffers(1, &m_framebuffer);
@@ -445,13 +355,174 @@ bool openglGPU::bufferCheck(image* _image)
     return true;
 }
 
+//--- Clear Image Buffer ---//
+/*
+    Drop the image's resident input texture
+*/
 void openglGPU::clearImBuffer(image* img) {
-/*if (glIsTexture(img->glTexture)) {
-        glDeleteTextures(1, (GLuint*)&img->glTexture);
+    if (!img)
+        return;
+    GLuint tex = (GLuint)img->glTexture;
+    const inputTexEntry* entry = m_inputTexCache.peek(tex);
+    inputTexEntry dropped;
+    if (entry && entry->owner == img && m_inputTexCache.erase(tex, dropped))
+        deleteInputTex({dropped});
+    img->glTexture = 0;
+    img->glBufSize = 0;
+    if (img->procImgData)
+        m_transfer.cancel(img->procImgData, img->procBufSize);
+}
+
+//--- Check Input Texture ---//
+/*
+    Forget an input texture the cache has
+    since evicted, so the image stops counting
+    it in its VRAM usage
+*/
+void openglGPU::checkInputTex(image* img) {
+    if (!img || !img->glTexture)
+        return;
+    const inputTexEntry* entry = m_inputTexCache.peek((GLuint)img->glTexture);
+    if (!entry || entry->owner != img) {
         img->glTexture = 0;
         img->glBufSize = 0;
-    }*/
+    }
+}
+
+//--- Input Texture ---//
+/*
+    The input texture for this render. Proxies
+    stay resident per image within the VRAM
+    budget, so going back to a recent frame is
+    no upload at all. Full resolution passes
+    use a one-off texture outside the cache.
+    Returns 0 if it could not be allocated.
+*/
+GLuint openglGPU::inputTexture(image* _image) {
+    if (!_image->rawImgData)
+        return 0;
+    unsigned int width = _image->fullIm ? _image->rawWidth : _image->width;
+    unsigned int height = _image->fullIm ? _image->rawHeight : _image->height;
+    uint64_t bytes = (uint64_t)width * height * 4 * sizeof(float);
+
+    auto allocate = [&](GLuint& tex) {
+        if (tex == 0 || glIsTexture(tex) == GL_FALSE)
+            glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        while(glGetError() != GL_NO_ERROR){} // Clear errors
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height,
+                     0, GL_RGBA, GL_FLOAT, nullptr);
+        checkError("Allocating Input Texture");
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return !m_status.error;
+    };
+
+    if (_image->fullIm) {
+        if (!allocate(m_inputTexture))
+            return 0;
+        activeInputBytes = bytes;
+        if (!copyToTex(m_inputTexture, width, height, _image->rawImgData))
+            return 0;
+        return m_inputTexture;
+    }
+
+    deleteInputTex(m_inputTexCache.setBudget((uint64_t)std::max(appPrefs.prefs.inputTexVram, 0) << 20));
+
+    // The name on the image may since have been deleted and
+    // reused by another image, so the entry has to be its own
+    inputTexEntry* entry = m_inputTexCache.find((GLuint)_image->glTexture);
+    bool owned = entry && entry->owner == _image;
+    bool current = owned && entry->gen == _image->rawGen &&
+                   entry->width == width && entry->height == height;
+    if (current && !_image->imgRst)
+        return entry->tex;
+
+    GLuint tex = 0;
+    if (current) {
+        tex = entry->tex;
+    } else {
+        // Its texture is from an older buffer
+        inputTexEntry stale;
+        if (owned && m_inputTexCache.erase((GLuint)_image->glTexture, stale))
+            deleteInputTex({stale});
+
+        if (!allocate(tex)) {
+            glDeleteTextures(1, &tex);
+            _image->glTexture = 0;
+            _image->glBufSize = 0;
+            return 0;
+        }
+        inputTexEntry fresh;
+        fresh.tex = tex;
+        fresh.owner = _image;
+        fresh.gen = _image->rawGen;
+        fresh.width = width;
+        fresh.height = height;
+        deleteInputTex(m_inputTexCache.insert(tex, fresh, bytes));
+        _image->glTexture = tex;
+        _image->glBufSize = bytes;
+    }
+
+    if (!copyToTex(tex, width, height, _image->rawImgData))
+        return 0;
+    checkError("Copying Image to Input Texture");
+    _image->imgRst = false;
+    return tex;
+}
+
+void openglGPU::deleteInputTex(const std::vector<inputTexEntry>& evicted) {
+    for (const auto& entry : evicted)
+        glDeleteTextures(1, &entry.tex);
 }
+
+//--- Proxy Texture ---//
+/*
+    Make sure the image's proxy (glTextureSm)
+    is the proxy resolution of an output this
+    size, (re)allocating it if not
+*/
+bool openglGPU::proxyTexture(image* _image, unsigned int nWidth, unsigned int nHeight) {
+    float scaleFactor = appPrefs.prefs.proxyRes;
+    if (_image->glTextureSm == 0 || !glIsTexture(_image->glTextureSm)) {
+        glGenTextures(1, (GLuint*)&_image->glTextureSm);
+        glBindTexture(GL_TEXTURE_2D, _image->glTextureSm);
+        int smWidth = std::max(1, (int)((float)nWidth * scaleFactor));
+        int smHeight = std::max(1, (int)((float)nHeight * scaleFactor));
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, smWidth, smHeight,
+                     0, GL_RGBA, GL_FLOAT, nullptr);
+        _image->glSmBufSize = (smWidth * smHeight * 4 * sizeof(uint8_t));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        checkError("Creating Small Output Texture");
+    } else {
+        glBindTexture(GL_TEXTURE_2D, _image->glTextureSm);
+        int oWidth, oHeight;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &oWidth);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &oHeight);
+        checkError("Querying Small Output Texture");
+        int smWidth = std::max(1, (int)((float)nWidth * scaleFactor));
+        int smHeight = std::max(1, (int)((float)nHeight * scaleFactor));
+        if (oWidth != smWidth || oHeight != smHeight) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, smWidth, smHeight,
+                         0, GL_RGBA, GL_FLOAT, nullptr);
+            _image->glSmBufSize = (smWidth * smHeight * 4 * sizeof(uint8_t));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            checkError("Resizing Small Output Texture");
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return !m_status.error;
+}
+
 void openglGPU::clearSmBuffer(image* img) {
     if (glIsTexture(img->glTextureSm)) {
         glDeleteTextures(1, (GLuint*)&img->glTextureSm);
@@ -480,14 +551,14 @@ void openglGPU::updateUniforms(renderParams params) {
     glUniform1f(m_uniforms.G_sat, params.saturation);
     glUniform1f(m_uniforms.G_sharpen, params.sharpen);
     glUniform1f(m_uniforms.G_sharpenRadius, params.sharpenRadius);
-    glUniform2fv(m_uniforms.G_curveW, params.curveW_n, params.curveW);
-    glUniform1i (m_uniforms.G_curveW_n, params.curveW_n);
-    glUniform2fv(m_uniforms.G_curveR, params.curveR_n, params.curveR);
-    glUniform1i (m_uniforms.G_curveR_n, params.curveR_n);
-    glUniform2fv(m_uniforms.G_curveG, params.curveG_n, params.curveG);
-    glUniform1i (m_uniforms.G_curveG_n, params.curveG_n);
-    glUniform2fv(m_uniforms.G_curveB, params.curveB_n, params.curveB);
-    glUniform1i (m_uniforms.G_curveB_n, params.curveB_n);
+    // Curves are only re-solved when their points change
+    if (m_curveCache.update(params))
+        packCurveUniforms(m_curveCache.luts(), m_curveUniforms);
+    glUniform4fv(m_uniforms.G_curveKnots, CURVE_MAX_PTS, &m_curveUniforms.knots[0][0]);
+    glUniform4fv(m_uniforms.G_curveInvDx, CURVE_MAX_SEGS, &m_curveUniforms.invDx[0][0]);
+    glUniform4fv(m_uniforms.G_curveCoef, CURVE_COUNT * CURVE_MAX_SEGS, &m_curveUniforms.coef[0][0]);
+    glUniform4fv(m_uniforms.G_curveExtrap, CURVE_COUNT, &m_curveUniforms.extrap[0][0]);
+    glUniform4iv(m_uniforms.G_curveN, 1, m_curveUniforms.n);
     glUniform1i(m_uniforms.bypass, params.bypass);
     glUniform1i(m_uniforms.gradeBypass, params.gradeBypass);
     glUniform1i(m_uniforms.secEnable, params.secEnable);
@@ -506,23 +577,31 @@ void openglGPU::updateUniforms(renderParams params) {
 
     // Pass original image dimensions
     glUniform2f(m_uniforms.imageSize, params.width, params.height);
+
+    // The whole image in one pass, renderTiled overrides these
+    glUniform4f(m_uniforms.outputTile, 0.0f, 0.0f, 1.0f, 1.0f);
+    glUniform4f(m_uniforms.inputTile, 0.0f, 0.0f, 1.0f, 1.0f);
 }
 
 //--- Add To Render Queue ---//
 /*
-    Add an image to the queue to be rendered
+    Add an image to the queue to be rendered,
+    replacing what it already has waiting in
+    the same priority class. The ticket settles
+    once the pixels are in place (or it fails,
+    or is removed from the queue).
 */
-void openglGPU::addToRender(image *_image, renderType type, ocioSetting ocioSet) {
+renderTicketPtr openglGPU::addToRender(image *_image, renderType type, ocioSetting ocioSet) {
 
+    auto ticket = std::make_shared<renderTicket>();
     if (_image) {
-        m_queueLock.lock();
+        std::lock_guard<std::mutex> lock(m_queueLock);
         _image->inRndQueue = true;
-        if (type == r_sdt || type == r_blr)
-            m_renderQueue.push_front(gpuQueue(_image, type, ocioSet));
-        else
-            m_renderQueue.push_back(gpuQueue(_image, type, ocioSet));
-        m_queueLock.unlock();
+        m_renderQueue.push(gpuQueue(_image, type, ocioSet, ticket));
+    } else {
+        ticket->fail("No image to render");
     }
+    return ticket;
 
 }
 
@@ -533,104 +612,106 @@ void openglGPU::addToRender(image *_image, renderType type, ocioSetting ocioSet)
 bool openglGPU::isInQueue(image* _image) {
     if (!_image)
         return false;
-    m_queueLock.lock();
-    std::deque<gpuQueue> searchQueue = m_renderQueue;
-    m_queueLock.unlock();
-    while (!searchQueue.empty()) {
-        if (_image == searchQueue.front()._img)
-            return true;
-        searchQueue.pop_front();
-    }
-    return false;
+    std::lock_guard<std::mutex> lock(m_queueLock);
+    return m_renderQueue.contains(_image);
 }
 
 //--- Remove From Queue ---//
 /*
     Remove all instances of the image
-    from the render queue
+    from the render queue, cancelling
+    their tickets
 */
 void openglGPU::removeFromQueue(image* _image) {
     if (!_image)
         return;
-    m_queueLock.lock();
-    for (int i = 0; i < m_renderQueue.size(); i++){
-        if (m_renderQueue[i]._img == _image) {
-            m_renderQueue.erase(m_renderQueue.begin() + i);
-        }
-    }
-    m_queueLock.unlock();
+    std::lock_guard<std::mutex> lock(m_queueLock);
+    m_renderQueue.remove(_image);
 }
 
 //--- Process Queue ---//
 /*
-    Loop through checking to see if there is a new item in the
-    queue to be rendered. If a single image/type/OCIO Set
-    is sent to the queue multiple times in a row, ignore
-    all but the last instance (before a new image). This
-    prevents the rendering of the same image multiple times
-    when unneccessary.
+    Render from the queue, most urgent first,
+    until this frame's budget is spent. There is
+    always at least one render a frame, so an
+    idle GPU gets through several thumbnails
+    and a busy one still makes progress. A full
+    resolution render is a frame on its own.
+    Thumbnails go in batches that keep drawing
+    until the budget is spent.
+
+    The budget is on submission time, the GPU
+    side runs on after this returns.
 */
 void openglGPU::processQueue() {
 
-
-        // While we've enabled the queue
-        if (m_renderQueue.size() > 0) {
-            m_rendering = true;
-            // If there are items in the queue
+        auto start = std::chrono::steady_clock::now();
+        auto budget = std::chrono::milliseconds(std::max(appPrefs.prefs.renderBudgetMs, 0));
+        bool rendered = false;
+        gpuQueue job(nullptr, r_sdt, ocioSetting());
+        while (true) {
             m_queueLock.lock();
-            image* img = m_renderQueue.front()._img;
-            renderType type = m_renderQueue.front()._type;
-            ocioSetting ocioSet = m_renderQueue.front()._ocioSet;
-            while (m_renderQueue.size() > 0 &&
-                m_renderQueue.front()._img == img &&
-                m_renderQueue.front()._type == type &&
-                m_renderQueue.front()._ocioSet == ocioSet) {
-                // Removing duplicates to only run a single
-                // instance of this image through the render
-                m_renderQueue.pop_front();
-            }
+            bool next = m_renderQueue.pop(job);
             m_queueLock.unlock();
-            switch (type) {
+            if (!next)
+                break;
+            rendered = true;
+            switch (job._type) {
+                case r_bg:
+                    // The image in the display texture needs the full render to refresh it
+                    if (job._img && !job._img->fullIm && job._img != m_dispBufIm) {
+                        renderThumbnails(job, start + budget);
+                        break;
+                    }
+                    [[fallthrough]];
                 case r_sdt:
                 case r_full:
-                case r_bg:
-                    renderImage(img, ocioSet);
+                    renderImage(job._img, job._ocioSet, job._ticket);
                     break;
                 case r_blr:
                     //renderBlurPass(img);
+                    if (job._ticket)
+                        job._ticket->complete();
                     break;
             }
-
-        }
-        else {
-            m_rendering = false;
+            if (job._type == r_full || std::chrono::steady_clock::now() - start >= budget)
+                break;
         }
+        m_rendering = rendered;
+        m_transfer.poll();
+        pumpHistogram();
 
 
 
 }
 
-void openglGPU::renderImage(image* _image, ocioSetting ocioSet) {
-    if (!_image)
+void openglGPU::renderImage(image* _image, ocioSetting ocioSet, renderTicketPtr ticket) {
+    auto fail = [&ticket](const std::string& error) {
+        if (ticket)
+            ticket->fail(error);
+    };
+    if (!_image) {
+        fail("No image to render");
         return;
-    if (!_image->imageLoaded)
-        return; //We don't have our buffers yet
-    if (!_image->rawImgData)
+    }
+    if (!_image->imageLoaded || !_image->rawImgData) {
+        fail("Image buffers not loaded"); //We don't have our buffers yet
         return;
+    }
 
     int32_t maxTextureSize = 0; // Check image dimensions against max texture size
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
-    if (
-        (_image->fullIm && appPrefs.prefs.cpuRender && !_image->cpuRender) ||
-        (_image->fullIm && (_image->rawWidth > maxTextureSize || _image->rawHeight > maxTextureSize))
-        ) {
-            LOG_INFO("Image too large for GPU. Sending to CPU for processing");
-        // Send the CPU render to another thread to not block the UI
-        std::thread cpuRender = std::thread([_image, ocioSet]{
-            _image->processCPU(ocioSet);
-            });
-        cpuRender.detach();
-
+    if (_image->fullIm && appPrefs.prefs.cpuRender && !_image->cpuRender) {
+        renderOnCPU(_image, ocioSet, ticket);
+        return;
+    }
+    if (_image->fullIm && !_image->cpuRender &&
+        (_image->rawWidth > maxTextureSize || _image->rawHeight > maxTextureSize)) {
+        if (renderTiled(_image, ocioSet, ticket, maxTextureSize))
+            return;
+        LOG_INFO("Image too large for GPU. Sending to CPU for processing");
+        clearError();
+        renderOnCPU(_image, ocioSet, ticket);
         return;
     }
 
@@ -644,10 +725,7 @@ void openglGPU::renderImage(image* _image, ocioSetting ocioSet) {
     if (!bufferCheck(_image)) {
         if (_image->fullIm && !_image->cpuRender) {
             LOG_ERROR("Could not allocate buffers! Falling back to CPU processing for {}", _image->srcFilename);
-            std::thread cpuRender = std::thread([_image, ocioSet]{
-                _image->processCPU(ocioSet);
-                });
-            cpuRender.detach();
+            renderOnCPU(_image, ocioSet, ticket);
             clearError();
             return;
         } else {
@@ -656,33 +734,32 @@ void openglGPU::renderImage(image* _image, ocioSetting ocioSet) {
 
     }
 
-    // OCIO Check
-    if (m_prevOCIO != ocioSet || m_prevIm != _image || _image->fullIm || _image->imgRst) {
-        if (!createShaders(ocioSet)){
-            if (_image->fullIm && !_image->cpuRender) {
-                LOG_ERROR("Could not compile shaders! Falling back to CPU processing");
-                // Send the CPU render to another thread to not block the UI
-                std::thread cpuRender = std::thread([_image, ocioSet]{
-                    _image->processCPU(ocioSet);
-                    });
-                cpuRender.detach();
-                return;
-            } else {
-                LOG_ERROR("Could not compile shaders!");
-            }
+    // OCIO Check, the program is only built
+    // when no cached one matches the settings
+    if (!useShaders(ocioSet)) {
+        if (_image->fullIm && !_image->cpuRender) {
+            LOG_ERROR("Could not compile shaders! Falling back to CPU processing");
+            renderOnCPU(_image, ocioSet, ticket);
             return;
+        } else {
+            LOG_ERROR("Could not compile shaders!");
+            fail("Could not compile shaders");
         }
-        // Always use original dimensions for input texture
-        unsigned int inputWidth = _image->fullIm ? _image->rawWidth : _image->width;
-        unsigned int inputHeight = _image->fullIm ? _image->rawHeight : _image->height;
+        return;
+    }
 
-        if (!copyToTex(m_inputTexture, inputWidth, inputHeight, _image->rawImgData)) {
+    // Input texture, uploaded only if this image isn't resident
+    GLuint inputTex = inputTexture(_image);
+    if (!inputTex) {
+        if (_image->fullIm && !_image->cpuRender) {
+            LOG_ERROR("Could not upload input texture! Falling back to CPU processing for {}", _image->srcFilename);
+            renderOnCPU(_image, ocioSet, ticket);
+            clearError();
+        } else {
             LOG_ERROR("Skipping image render {}, no input data!", _image->srcFilename);
-            return;
+            fail("Could not upload input texture");
         }
-        checkError("Copying Image to Input Texture");
-        m_prevIm = _image;
-        _image->imgRst = false;
+        return;
     }
 
     // Calculate output dimensions based on crop settings
@@ -719,13 +796,12 @@ void openglGPU::renderImage(image* _image, ocioSetting ocioSet) {
 
     // Bind input texture to texture unit 0
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_inputTexture);
+    glBindTexture(GL_TEXTURE_2D, inputTex);
     glUniform1i(m_uniforms.inputTexture, 0);
     checkError("Binding Input Texture");
 
     // OCIO textures should be on units 1, 2, 3
-    m_ocioBuilder->useAllTextures();
-    m_ocioBuilder->useAllUniforms();
+    bindShaderTextures();
     checkError("Setting OCIO Textures");
 
     // Render full-screen quad
@@ -767,21 +843,38 @@ void openglGPU::renderImage(image* _image, ocioSetting ocioSet) {
     // Set the rendered image pointer
     m_dispBufIm = _image;
 
-    // Copy Completed Image
+    // Copy Completed Image, it lands over the next frames
+    // and the exporter waiting on renderReady hears then
     if (_image->fullIm) {
         _image->allocProcBuf();
-        copyFromTexFull(m_displayTexture, outputWidth, outputHeight, _image->procImgData);
+        m_transfer.readback(m_displayTexture, outputWidth, outputHeight, _image->procImgData,
+                            [_image, ticket](bool ok) {
+                                if (ok)
+                                    _image->renderReady = true;
+                                if (!ticket)
+                                    return;
+                                if (ok)
+                                    ticket->complete();
+                                else
+                                    ticket->fail("Full resolution readback failed");
+                            });
         checkError("Copying Full Image for write");
-        _image->renderReady = true;
+        // The full resolution input isn't needed again,
+        // GL keeps it alive until the render has read it
+        glDeleteTextures(1, &m_inputTexture);
+        m_inputTexture = 0;
+        activeInputBytes = 0;
         //glDeleteTextures(1, (GLuint*)&_image->glTexture);
         //_image->glTexture = 0;
+    } else if (ticket) {
+        ticket->complete();
     }
 
     if (!isInQueue(_image))
         _image->inRndQueue = false;
 
     if (_image->visible && !_image->fullIm)
-        procHistIm(_image);
+        procHistIm(_image, _renderParams, ocioSet);
     _image->reloading = false;
 
     auto end = std::chrono::steady_clock::now();
@@ -802,25 +895,326 @@ void openglGPU::renderImage(image* _image, ocioSetting ocioSet) {
     return;
 }
 
+//--- Render Thumbnails ---//
+/*
+    Background renders only fill the proxy
+    (glTextureSm), so they skip the display
+    pass and draw straight into it at proxy
+    size. The FBO, quad and OCIO textures are
+    bound once for the batch, after that each
+    thumbnail is its uniforms, an attach and a
+    draw. Inputs come from the resident proxy
+    input textures, a roll already on the GPU
+    uploads nothing.
+
+    Keeps taking thumbnails off the queue until
+    the frame's deadline, or something more
+    urgent is queued. The first one always
+    renders.
+*/
+void openglGPU::renderThumbnails(gpuQueue first, std::chrono::steady_clock::time_point deadline) {
+    auto start = std::chrono::steady_clock::now();
+    while(glGetError() != GL_NO_ERROR){} // Clear any errors from previous
 
-bool openglGPU::copyToTex(GLuint textureID, int width, int height, float* rgbaData) {
-    if (!rgbaData) {
-        LOG_ERROR("No image data for render!");
+    GLuint program = 0;     // Bound state, 0 when it needs setting up again
+    std::vector<std::pair<image*, ocioSetting>> histogram;
+    size_t drawn = 0;
+    gpuQueue job = first;
+    while (true) {
+        image* _image = job._img;
+        auto fail = [&job](const std::string& error) {
+            if (job._ticket)
+                job._ticket->fail(error);
+        };
+
+        if (!_image || !_image->imageLoaded || !_image->rawImgData) {
+            fail("Image buffers not loaded");
+        } else if (_image->fullIm || _image == m_dispBufIm) {
+            // Not a thumbnail after all, or the one the viewer shows
+            // from the display texture. Either leaves nothing bound.
+            renderImage(_image, job._ocioSet, job._ticket);
+            program = 0;
+        } else if (!useShaders(job._ocioSet)) {
+            LOG_ERROR("Could not compile shaders!");
+            fail("Could not compile shaders");
+        } else {
+            // Uploads and allocations bind on the active unit,
+            // keep them off the OCIO textures
+            glActiveTexture(GL_TEXTURE0);
+            GLuint inputTex = inputTexture(_image);
+
+            unsigned int outputWidth = _image->width;
+            unsigned int outputHeight = _image->height;
+            if (_image->imgParam.cropEnable) {
+                outputWidth = std::max(1u, (unsigned int)((_image->imgParam.imageCropMaxX - _image->imgParam.imageCropMinX) * outputWidth));
+                outputHeight = std::max(1u, (unsigned int)((_image->imgParam.imageCropMaxY - _image->imgParam.imageCropMinY) * outputHeight));
+            }
+            int smallWidth = std::max(1, (int)((float)outputWidth * appPrefs.prefs.proxyRes));
+            int smallHeight = std::max(1, (int)((float)outputHeight * appPrefs.prefs.proxyRes));
+
+            if (!inputTex || !proxyTexture(_image, outputWidth, outputHeight)) {
+                LOG_ERROR("Skipping thumbnail render {}, no input data!", _image->srcFilename);
+                fail("Could not upload input texture");
+                clearError();
+            } else {
+                if (program != m_shaderProgram) {
+                    glBindFramebuffer(GL_FRAMEBUFFER, m_smallFBO);
+                    GLenum smallBuf = GL_COLOR_ATTACHMENT0;
+                    glDrawBuffers(1, &smallBuf);
+                    glUseProgram(m_shaderProgram);
+                    bindShaderTextures();
+                    glBindVertexArray(m_vertexArray);
+                    program = m_shaderProgram;
+                }
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, _image->glTextureSm, 0);
+                renderParams _renderParams = img_to_param(_image);
+                updateUniforms(_renderParams);
+                glUniform1i(m_uniforms.proxyPass, 1);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, inputTex);
+
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+                    glViewport(0, 0, smallWidth, smallHeight);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                }
+                checkError("Thumbnail Render");
+
+                if (m_status.error) {
+                    fail(m_status.errString);
+                    clearError();
+                } else {
+                    _image->dispW = outputWidth;
+                    _image->dispH = outputHeight;
+                    _image->rndrW = outputWidth;
+                    _image->rndrH = outputHeight;
+                    if (_image->visible)
+                        histogram.push_back({_image, job._ocioSet});
+                    if (job._ticket)
+                        job._ticket->complete();
+                    drawn++;
+                }
+                _image->reloading = false;
+            }
+        }
+        if (_image && !isInQueue(_image))
+            _image->inRndQueue = false;
+
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+        std::lock_guard<std::mutex> lock(m_queueLock);
+        if (!m_renderQueue.pop(p_background, job))
+            break;
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    checkError("Unbind");
+
+    // The active image can be queued as a thumbnail too
+    for (auto& [_image, ocioSet] : histogram)
+        procHistIm(_image, img_to_param(_image), ocioSet);
+
+    auto dur = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("Rendered {} thumbnails in {}us", drawn, dur.count());
+}
+
+//--- Render Tiled ---//
+/*
+    Full resolution renders past the texture limit
+    go through the same kernel a tile at a time.
+    Each output tile gets the input rectangle its
+    pixels sample from (with an apron, so bilinear
+    taps at the seams read real neighbours, not a
+    clamped edge), and the tile uniforms place its
+    viewport and input texture in full image UVs,
+    so every pixel sees what it would in one pass.
+    The tiles' readbacks land straight in the
+    processed buffer, the ticket settles once the
+    last one is in.
+
+    False if it couldn't start, nothing is
+    queued or settled then.
+*/
+bool openglGPU::renderTiled(image* _image, ocioSetting ocioSet, renderTicketPtr ticket, int maxTextureSize) {
+    auto start = std::chrono::steady_clock::now();
+    while(glGetError() != GL_NO_ERROR){} // Clear any errors from previous
+
+    renderParams _renderParams = img_to_param(_image);
+    tileMapping map;
+    map.width = _renderParams.width;
+    map.height = _renderParams.height;
+    map.outWidth = map.width;
+    map.outHeight = map.height;
+    if (_image->imgParam.cropEnable) {
+        map.outWidth = std::max(1u, (unsigned int)((_image->imgParam.imageCropMaxX - _image->imgParam.imageCropMinX) * map.width));
+        map.outHeight = std::max(1u, (unsigned int)((_image->imgParam.imageCropMaxY - _image->imgParam.imageCropMinY) * map.height));
+    }
+    map.cropEnabled = _renderParams.cropEnable;
+    map.cropVisible = _renderParams.cropVisible;
+    map.cropMin[0] = _renderParams.imageCropMinX;
+    map.cropMin[1] = _renderParams.imageCropMinY;
+    map.cropMax[0] = _renderParams.imageCropMaxX;
+    map.cropMax[1] = _renderParams.imageCropMaxY;
+    map.rotation = _renderParams.arbitraryRotation * M_PI / 180.0f;
+
+    std::vector<renderTile> tiles = planRenderTiles(map, maxTextureSize);
+    if (tiles.empty() || !useShaders(ocioSet))
+        return false;
+    if (m_tileFBO == 0)
+        glGenFramebuffers(1, &m_tileFBO);
+
+    _image->allocProcBuf();
+    LOG_INFO("Rendering {} in {} tiles", _image->srcFilename, tiles.size());
+
+    // Settled by the last tile to land
+    struct tileProgress {
+        size_t remaining;
+        bool ok = true;
+    };
+    auto progress = std::make_shared<tileProgress>();
+    progress->remaining = tiles.size();
+    auto tileDone = [_image, ticket, progress](bool ok) {
+        progress->ok = progress->ok && ok;
+        if (--progress->remaining > 0)
+            return;
+        if (progress->ok)
+            _image->renderReady = true;
+        if (!ticket)
+            return;
+        if (progress->ok)
+            ticket->complete();
+        else
+            ticket->fail("Tiled readback failed");
+    };
+
+    glUseProgram(m_shaderProgram);
+    updateUniforms(_renderParams);
+    glUniform1i(m_uniforms.inputTexture, 0);
+    glUniform1i(m_uniforms.proxyPass, 0);
+    bindShaderTextures();
+    glBindVertexArray(m_vertexArray);
+    checkError("Tiled Render Setup");
+
+    size_t queued = 0;
+    for (const auto& tile : tiles) {
+        const float* src = _image->rawImgData + ((size_t)tile.inY * map.width + tile.inX) * 4;
+        if (!tileTexture(m_tileInTex, GL_RGBA32F, tile.inW, tile.inH) ||
+            !m_transfer.upload(m_tileInTex, tile.inW, tile.inH, src, map.width) ||
+            !tileTexture(m_tileOutTex, GL_RGBA16F, tile.outW, tile.outH))
+            break;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_tileFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_tileOutTex, 0);
+        GLenum drawBuf = GL_COLOR_ATTACHMENT0;
+        glDrawBuffers(1, &drawBuf);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            break;
+        glViewport(0, 0, tile.outW, tile.outH);
+
+        float outputTile[4], inputTile[4];
+        renderTileUniforms(map, tile, outputTile, inputTile);
+        glUniform4fv(m_uniforms.outputTile, 1, outputTile);
+        glUniform4fv(m_uniforms.inputTile, 1, inputTile);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_tileInTex);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        checkError("Tiled Render");
+        if (m_status.error)
+            break;
+
+        // Straight into place in the processed buffer
+        float* dst = _image->procImgData + ((size_t)tile.outY * map.outWidth + tile.outX) * 4;
+        m_transfer.readback(m_tileOutTex, tile.outW, tile.outH, dst, tileDone, map.outWidth);
+        queued++;
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    // GL keeps them until the queued work is done with them
+    glDeleteTextures(1, &m_tileInTex);
+    glDeleteTextures(1, &m_tileOutTex);
+    m_tileInTex = 0;
+    m_tileOutTex = 0;
+
+    if (queued < tiles.size()) {
+        // The ones already queued still land, but the
+        // render as a whole falls back to the CPU
+        LOG_ERROR("Tiled render of {} stopped at tile {} of {}", _image->srcFilename, queued, tiles.size());
+        m_transfer.finish();
         return false;
     }
-    glBindTexture(GL_TEXTURE_2D, textureID);
 
-    // Upload the data to the existing texture
-    glTexSubImage2D(GL_TEXTURE_2D, 0,          // target, level
-                    0, 0,                      // xoffset, yoffset
-                    width, height,             // width, height
-                    GL_RGBA,                   // format
-                    GL_FLOAT,                  // type
-                    rgbaData);                 // data pointer
+    _image->rndrW = map.outWidth;
+    _image->rndrH = map.outHeight;
+    if (!isInQueue(_image))
+        _image->inRndQueue = false;
+    _image->reloading = false;
 
-    checkError("Copying Texture");
+    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("Queued {} tiles of {} in {}ms", tiles.size(), _image->srcFilename, dur.count());
+    return true;
+}
 
+//--- Tile Texture ---//
+/*
+    (Re)allocate a tiled render texture to exactly
+    the tile, so clamping at the image edges
+    matches a single pass
+*/
+bool openglGPU::tileTexture(GLuint& tex, GLenum format, unsigned int width, unsigned int height) {
+    if (tex == 0)
+        glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    GLint curW = 0, curH = 0, curFormat = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &curW);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &curH);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &curFormat);
+    if ((unsigned int)curW != width || (unsigned int)curH != height || (GLenum)curFormat != format) {
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
+    checkError("Allocating Tile Texture");
+    return !m_status.error;
+}
+
+//--- Render On CPU ---//
+/*
+    Send the CPU render to another thread to
+    not block the UI, the ticket hears how
+    it went
+*/
+void openglGPU::renderOnCPU(image* _image, ocioSetting ocioSet, renderTicketPtr ticket) {
+    std::thread cpuRender = std::thread([_image, ocioSet, ticket]{
+        try {
+            _image->processCPU(ocioSet, ticket);
+        } catch (const std::exception& e) {
+            LOG_ERROR("CPU render of {} failed: {}", _image->srcFilename, e.what());
+            _image->cpuRender = false;
+            if (ticket)
+                ticket->fail(e.what());
+        }
+    });
+    cpuRender.detach();
+}
+
+bool openglGPU::copyToTex(GLuint textureID, int width, int height, float* rgbaData) {
+    // Streamed through the pixel buffer ring
+    if (!m_transfer.upload(textureID, width, height, rgbaData))
+        return false;
+    checkError("Copying Texture");
     return true;
 }
 void openglGPU::copyFromTexFull(GLuint textureID, int width, int height, float* rgbaData) {
@@ -836,14 +1230,21 @@ void openglGPU::copyFromTexFull(GLuint textureID, int width, int height, float*
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void openglGPU::getHistTexture(image* _img, float*& pixels, int &width, int &height) {
+//--- Read Histogram Texture ---//
+/*
+    Start a copy of the proxy texture into the
+    next pixel pack buffer and fence it. Nothing
+    waits on it here, pumpHistogram maps it once
+    the fence has passed.
+*/
+bool openglGPU::readHistTexture(image* _img, int &width, int &height) {
     if (!_img) {
         LOG_WARN("No image for histogram processing!");
-        return;
+        return false;
     }
     if (glIsTexture(_img->glTextureSm) == GL_FALSE) {
         LOG_WARN("Image doesn't have an active GL Texture yet!");
-        return;
+        return false;
     }
     int gWidth = 0;
     int gHeight = 0;
@@ -851,43 +1252,38 @@ void openglGPU::getHistTexture(image* _img, float*& pixels, int &width, int &hei
     // Use MipMap 0 (1x res)
     glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &gWidth);
     glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &gHeight);
-
-    if (gWidth * gHeight * 4 > m_histBufSize || !pixels) {
-        m_histBufSize = gWidth * gHeight * 4;
-        if (pixels)
-            delete [] pixels;
-        pixels = new float[m_histBufSize];
+    if (gWidth < 1 || gHeight < 1) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return false;
     }
 
-    // Read texture data directly
-    glGetTexImage(GL_TEXTURE_2D,    // target
-                  0,                // level
-                  GL_RGBA,          // format
-                  GL_FLOAT,         // type
-                  pixels);          // pixels
-
-    width = gWidth;
-    height = gHeight;
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
-
-void openglGPU::setHistTexture(float* pixels) {
-    if (!pixels) {
-        LOG_WARN("No Histogram Pixels!");
-        return;
+    int buf = m_histPBONext;
+    m_histPBONext ^= 1;
+    // Can't pack into it while the pool still reads it
+    if (buf == m_histMappedBuf)
+        unmapHistReadback();
+    uint64_t bytes = (uint64_t)gWidth * gHeight * 4 * sizeof(float);
+    if (m_histPBO[buf] == 0)
+        glGenBuffers(1, &m_histPBO[buf]);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_histPBO[buf]);
+    if (bytes > m_histPBOSize[buf]) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        m_histPBOSize[buf] = bytes;
     }
-    glBindTexture(GL_TEXTURE_2D, m_histoTex);
 
-    // Upload the data to the existing texture
-    glTexSubImage2D(GL_TEXTURE_2D, 0,          // target, level
-                    0, 0,                      // xoffset, yoffset
-                    HISTWIDTH, HISTHEIGHT,             // width, height
-                    GL_RGBA,                   // format
-                    GL_FLOAT,                  // type
-                    pixels);                 // data pointer
+    // With a pack buffer bound this only queues the copy
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, nullptr);
 
-    checkError("Copying Histogram");
+    if (m_histFence)
+        glDeleteSync(m_histFence);
+    m_histFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
+    checkError("Histogram Readback");
+
+    width = gWidth;
+    height = gHeight;
+    return true;
 }
+
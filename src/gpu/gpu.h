@@ -2,9 +2,15 @@
 #define _gpu_h
 
 #include "image.h"
+#include "curveLUT.h"
 #include "structs.h"
 #include "gpuStructs.h"
 #include "ocioProcessor.h"
+#include "histogramKernel.h"
+#include "residencyCache.h"
+#include "pixelTransfer.h"
+#include "renderQueue.h"
+#include "tilePlan.h"
 #include <OpenColorIO/oglapphelpers/glsl.h>
 
 #include <GL/glew.h>
@@ -15,9 +21,14 @@
 #include <vector>
 #include <chrono>
 #include <deque>
+#include <future>
+#include <memory>
+#include <utility>
 
 #define HISTWIDTH 512
 #define HISTHEIGHT 256
+#define HIST_SETTLE_MS 250      // quiet time before a sampled histogram is redone in full
+#define GPU_PROGRAM_CACHE 8     // display programs kept, one per OCIO setting
 
 struct gpuStat {
     bool error = false;
@@ -25,6 +36,15 @@ struct gpuStat {
     int errorCode = 0;
 };
 
+// A proxy's input texture, resident between renders
+struct inputTexEntry {
+    GLuint tex = 0;
+    const void* owner = nullptr;    // Compared, never followed
+    uint64_t gen = 0;               // The owner's rawGen when uploaded
+    unsigned int width = 0;
+    unsigned int height = 0;
+};
+
 struct histFrame {
     float* imgData = nullptr;
     float* histData = nullptr;
@@ -36,18 +56,42 @@ struct histFrame {
     bool set = false;
 };
 
+// One histogram pass: the proxy texture readback,
+// the spans to bin and how many pixels to sample
+struct histJob {
+    uint64_t gen = 0;           // Dropped if a newer request came in
+    uint64_t key = 0;
+    int width = 0;
+    int height = 0;
+    size_t samples = 0;         // 0 bins every pixel
+    std::vector<rowSpan> spans;
+    std::shared_ptr<std::vector<float>> pixels;
+};
+
+// Binned on the pool, picked up by the GL thread
+struct histResult {
+    std::mutex lock;
+    bool ready = false;
+    uint64_t gen = 0;
+    uint64_t key = 0;
+    bool partial = false;
+    HistogramData histogram;
+};
+
 class openglGPU {
     public:
         openglGPU();
         ~openglGPU();
 
-        void addToRender(image* _image, renderType type, ocioSetting ocioSet);
+        renderTicketPtr addToRender(image* _image, renderType type, ocioSetting ocioSet);
         bool initialize(ocioSetting &ocioSet);
         bool isInQueue(image* _image);
         void removeFromQueue(image* _image);
         void processQueue();
         void clearImBuffer(image* img);
         void clearSmBuffer(image* img);
+        void checkInputTex(image* img);
+        const residencyCache<GLuint, inputTexEntry>& inputTexCache() { return m_inputTexCache; }
         void copyFromTexFull(GLuint textureID, int width, int height, float* rgbaData);
 
 
@@ -55,14 +99,14 @@ class openglGPU {
         void clearError();
         std::string getError();
 
-        long long unsigned int histoTex(){return m_histoTex;}
+        long long unsigned int histoTex(){return m_histoTex[m_histFront];}
         long long unsigned int dispTex(){return m_displayTexture;}
 
-        uint64_t activeBytes(){return histoBytes + activeInputBytes + activeDisplayBytes + cleanActiveBytes;}
+        uint64_t activeBytes(){return histoBytes + activeInputBytes + activeDisplayBytes + cleanActiveBytes + m_transfer.pendingBytes();}
         image* dispBufIm(){return m_dispBufIm;}
 
         bool m_rendering = false;
-        const int64_t histoBytes = (HISTWIDTH * HISTHEIGHT * 4 * 4);
+        const int64_t histoBytes = (HISTWIDTH * HISTHEIGHT * 4 * 4) * 2;
         uint64_t activeInputBytes = 0;
         uint64_t activeDisplayBytes = 0;
         uint64_t cleanActiveBytes = 0;
@@ -70,25 +114,44 @@ class openglGPU {
     private:
         gpuStat m_status;
         bool m_initialized = false;
-        std::deque<gpuQueue> m_renderQueue;
+        renderQueue m_renderQueue;
         std::mutex m_queueLock;
 
-        image* m_prevIm;
-        image* m_dispBufIm;
+        image* m_dispBufIm = nullptr;
+
+        // Proxy input textures, within appPrefs inputTexVram
+        residencyCache<GLuint, inputTexEntry> m_inputTexCache{(uint64_t)1024 << 20};
+
+        // Uploads and full resolution readbacks
+        pixelTransfer m_transfer;
 
-        ocioSetting m_prevOCIO;
+        // Tone curves, recompiled only when the points change
+        curveCache m_curveCache;
+        curveUniforms m_curveUniforms;
 
         unsigned int m_width = 0;
         unsigned int m_height = 0;
 
         // Histogram
-        uint64_t m_histBufSize = 0;
-        float* m_histPixels = nullptr;
-        float* m_imgPixels = nullptr;
+        histogramCache m_histCache;
+        uint64_t m_histKey = 0;     // What the histogram texture shows
+        float m_histInt = -1.0f;
+        uint64_t m_histGen = 0;     // Bumped by every request
+        std::chrono::steady_clock::time_point m_histLast;
+
+        histJob m_histRead;         // Readback in flight
+        GLsync m_histFence = nullptr;
+        histJob m_histRefresh;      // Sampled pass owed a full one
+        bool m_histRefreshPending = false;
+        std::shared_ptr<histResult> m_histResult = std::make_shared<histResult>();
 
         // histogram.cpp
-        void procHistIm(image* img);
-        void updateHistPixels(image* img, float* imgPixels, float* histPixels, int width, int height, float intensityMultiplier);
+        void procHistIm(image* img, const renderParams& params, const ocioSetting& ocioSet);
+        void pumpHistogram();
+        void submitHistJob(histJob job, const void* mapped = nullptr);
+        void unmapHistReadback();
+        void drawHistogram(const HistogramData& histogram, uint64_t key);
+        bool createHistShader();
 
         // gpu.cpp
         void checkError(std::string location);
@@ -99,24 +162,49 @@ class openglGPU {
         void setupGeometry();
 
         GLuint compileShader(const std::string& source, GLenum type);
-        bool createShaders(ocioSetting& ocioSet);
 
-        void renderImage(image* _image, ocioSetting ocioSet);
+        // shaderCache.cpp
+        struct shaderProgram;
+        bool useShaders(ocioSetting& ocioSet);
+        std::shared_ptr<shaderProgram> createShaders(ocioSetting& ocioSet);
+        bool loadProgramBinary(shaderProgram& shader, const OCIO::GpuShaderDescRcPtr& gpuDesc, const std::string& path);
+        void saveProgramBinary(GLuint program, const std::string& path);
+        bool programBinarySupported();
+        void pruneProgramBinaries(uint64_t driver);
+        void bindShaderTextures();
+
+        void renderImage(image* _image, ocioSetting ocioSet, renderTicketPtr ticket = nullptr);
+        void renderOnCPU(image* _image, ocioSetting ocioSet, renderTicketPtr ticket);
+        bool renderTiled(image* _image, ocioSetting ocioSet, renderTicketPtr ticket, int maxTextureSize);
+        bool tileTexture(GLuint& tex, GLenum format, unsigned int width, unsigned int height);
+        void renderThumbnails(gpuQueue first, std::chrono::steady_clock::time_point deadline);
+        bool proxyTexture(image* _image, unsigned int width, unsigned int height);
 
         bool copyToTex(GLuint textureID, int width, int height, float* rgbaData);
+        GLuint inputTexture(image* _image);
+        void deleteInputTex(const std::vector<inputTexEntry>& evicted);
 
-        void getHistTexture(image* _img, float*& pixels, int &width, int &height);
-        void setHistTexture(float* pixels);
+        bool readHistTexture(image* _img, int &width, int &height);
 
     private:
-        OCIO::OpenGLBuilderRcPtr m_ocioBuilder;
-
         GLuint m_framebuffer = 0;
         GLuint m_smallFBO    = 0;
-        GLuint m_inputTexture = 0;
+        GLuint m_inputTexture = 0;     // Full resolution passes only
         GLuint m_displayTexture = 0;
         GLuint m_cleanOutTex = 0;
-        GLuint m_histoTex = 0;
+        GLuint m_tileInTex = 0;         // Tiled renders, one tile at a time
+        GLuint m_tileOutTex = 0;
+        GLuint m_tileFBO = 0;
+        GLuint m_histoTex[2] = {0, 0};     // Drawn into the back one, then swapped
+        int m_histFront = 0;
+        GLuint m_histPBO[2] = {0, 0};       // Readbacks alternate between these
+        uint64_t m_histPBOSize[2] = {0, 0};
+        int m_histPBONext = 0;
+        int m_histMappedBuf = -1;           // Mapped while the pool copies out of it
+        std::future<void> m_histCopy;       // Ready once that copy is done
+        GLuint m_histBinTex = 0;
+        GLuint m_histFBO = 0;
+        GLuint m_histProgram = 0;
 
         GLuint m_vertexArray = 0;
         GLuint m_vertexBuffer = 0;
@@ -144,10 +232,11 @@ class openglGPU {
                 GLint G_matrixB;
                 GLint G_sharpen;
                 GLint G_sharpenRadius;
-                GLint G_curveW;   GLint G_curveW_n;
-                GLint G_curveR;   GLint G_curveR_n;
-                GLint G_curveG;   GLint G_curveG_n;
-                GLint G_curveB;   GLint G_curveB_n;
+                GLint G_curveKnots;
+                GLint G_curveInvDx;
+                GLint G_curveCoef;
+                GLint G_curveExtrap;
+                GLint G_curveN;
                 GLint bypass;
                 GLint gradeBypass;
                 GLint secEnable;
@@ -160,8 +249,41 @@ class openglGPU {
                 GLint cropEnabled;
                 GLint cropVisible;
                 GLint imageSize;
+                GLint outputTile;
+                GLint inputTile;
                 GLint proxyPass;
         } m_uniforms;
+
+        //--- Shader Program ---//
+        /*
+            The display program for one set of OCIO
+            settings, with its LUT textures and uniform
+            locations. Built by the OCIO helper, or read
+            back from the disk cache, in which case the
+            program and textures are owned here.
+        */
+        struct shaderProgram {
+                OCIO::OpenGLBuilderRcPtr builder;
+                GLuint program = 0;
+                bool ownsProgram = false;
+                std::vector<std::pair<GLenum, GLuint>> textures;   // On units 1 and up
+                UniformLocations uniforms;
+
+                ~shaderProgram();
+        };
+
+        // Keyed like the CPU processors, on what changes the shader text
+        lruCache<processorKey, std::shared_ptr<shaderProgram>, processorKeyHash> m_programCache{GPU_PROGRAM_CACHE};
+        std::shared_ptr<shaderProgram> m_activeShader;
+        int m_binaryFormats = -1;       // Program binary formats the driver offers, -1 unchecked
+        bool m_binariesPruned = false;  // Shader cache folder cleaned up this run
+
+        struct HistUniformLocations {
+                GLint histBins = -1;
+                GLint intensity = -1;
+                GLint histWidth = -1;
+                GLint histHeight = -1;
+        } m_histUniforms;
 };
 
 
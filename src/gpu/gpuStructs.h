@@ -3,6 +3,7 @@
 
 #include "image.h"
 #include "structs.h"
+#include "renderTicket.h"
 
 
 struct gpuTimer {
@@ -21,12 +22,14 @@ struct gpuQueue {
     image* _img;
     renderType _type;
     ocioSetting _ocioSet;
+    renderTicketPtr _ticket;
 
 
-    gpuQueue(image* img, renderType type, ocioSetting ocioSet)
+    gpuQueue(image* img, renderType type, ocioSetting ocioSet, renderTicketPtr ticket = nullptr)
     {_img = img;
     _type = type;
-    _ocioSet = ocioSet;}
+    _ocioSet = ocioSet;
+    _ticket = ticket;}
 
 
 };
@@ -1,312 +1,341 @@
 #include "gpu.h"
+#include "histogramKernel.h"
 #include "utils.h"
+#include "glslKernels.h"
+#include "threadPool.h"
+#include <cstring>
+#include <future>
+#include <new>
+
+//--- Histogram Key ---//
+/*
+    Hash of everything that changes the pixels
+    the histogram is binned from: the image and its
+    buffers, the render parameters, the OCIO
+    transform, the proxy scale and the crop box
+*/
+static uint64_t histKey(image* img, const renderParams& params, const ocioSetting& ocioSet) {
+    uint64_t key = hashBytes(&img, sizeof(img));
+    key = hashBytes(&img->rawImgData, sizeof(img->rawImgData), key);
+    key = hashBytes(&img->glTextureSm, sizeof(img->glTextureSm), key);
+    key = hashBytes(&params, sizeof(params), key);
+
+    int ocioVals[7] = {ocioSet.ocioConfig, ocioSet.colorspace, ocioSet.display, ocioSet.view,
+                       ocioSet.inverse, ocioSet.useDisplay, ocioSet.gamutComp};
+    key = hashBytes(ocioVals, sizeof(ocioVals), key);
+    key = hashBytes(&ocioSet.texture[0], sizeof(ocioSet.texture[0]), key);
+
+    key = hashBytes(&appPrefs.prefs.proxyRes, sizeof(appPrefs.prefs.proxyRes), key);
+    key = hashBytes(img->imgParam.cropBoxX, sizeof(img->imgParam.cropBoxX), key);
+    key = hashBytes(img->imgParam.cropBoxY, sizeof(img->imgParam.cropBoxY), key);
+    key = hashBytes(&img->imgParam.cropEnable, sizeof(img->imgParam.cropEnable), key);
+    return key;
+}
 
 //--- Process Image ---//
 /*
     Process the histogram based on
-    the provided image
+    the provided image. A histogram already
+    shown, or in the cache, is only redrawn.
+    Otherwise a readback is started and
+    pumpHistogram takes it from there.
+    While renders keep arriving inside the
+    settle time, at most histSamples pixels
+    are binned, the full pass follows once
+    they stop.
  */
-void openglGPU::procHistIm(image* img) {
+void openglGPU::procHistIm(image* img, const renderParams& params, const ocioSetting& ocioSet) {
     if (!img) {
         LOG_WARN("Cannot process histogram, bad pointers!");
         return;
     }
-    int hWidth = 0;
-    int hHeight = 0;
-    getHistTexture(img, m_imgPixels, hWidth, hHeight);
-    updateHistPixels(img, m_imgPixels, m_histPixels, hWidth, hHeight, appPrefs.prefs.histInt);
-    setHistTexture(m_histPixels);
-    return;
-
-}
-
-//--- Calculate Histogram from RGBA ---//
-void calculateHistogramFromRGBA(const float *rgba_buffer, int width,
-                                int height, HistogramData &histogram,
-                                const unsigned int* xPoints, const unsigned int* yPoints, bool cropped) {
-    if (!rgba_buffer || !xPoints || !yPoints) {
+    uint64_t key = histKey(img, params, ocioSet);
+    // Already showing (or binning) this one, and nothing newer is
+    // in flight. Leaves a sampled pass's pending refresh alone.
+    bool newerInFlight = m_histRead.gen == m_histGen && m_histRead.key != key;
+    if (!img->reloading && !newerInFlight &&
+        key == m_histKey && appPrefs.prefs.histInt == m_histInt)
         return;
-    }
-
-    // Clear histogram data
-    histogram = HistogramData();
-
-    const int pixel_count = width * height;
-    int num_threads = std::thread::hardware_concurrency();
-    num_threads = num_threads < 1 || num_threads > THREAD_LIMIT ? 2 : num_threads;
-    const int pixels_per_thread = pixel_count / num_threads;
-
-    // Create thread-local histograms to avoid contention
-    std::vector<HistogramData> thread_histograms(num_threads);
-    std::vector<std::thread> threads;
 
-    // Launch threads
-    for (int t = 0; t < num_threads; ++t) {
-        threads.emplace_back([&, t]() {
-            int start = t * pixels_per_thread;
-            int end = (t == num_threads - 1) ? pixel_count : (t + 1) * pixels_per_thread;
+    auto now = std::chrono::steady_clock::now();
+    bool settling = now - m_histLast < std::chrono::milliseconds(HIST_SETTLE_MS);
+    m_histLast = now;
 
-            // Use local variables to reduce memory access
-            std::array<int, 512> local_r_hist{};
-            std::array<int, 512> local_g_hist{};
-            std::array<int, 512> local_b_hist{};
-            std::array<int, 512> local_lum_hist{};
-
-            // Process pixels in this thread's range
-            for (int i = start; i < end; ++i) {
-                const int idx = i * 4;
-                int y = i / width;
-                int x = i % width;
-                if (!cropped && !isPointInBox(x, y, xPoints, yPoints))
-                    continue;
-
-                // Convert float values (0.0-1.0) to 8-bit values (0-255)
-                float r_f = std::clamp(rgba_buffer[idx], 0.0f, 1.0f);
-                float g_f = std::clamp(rgba_buffer[idx + 1], 0.0f, 1.0f);
-                float b_f = std::clamp(rgba_buffer[idx + 2], 0.0f, 1.0f);
-
-                uint8_t r = static_cast<uint8_t>(r_f * 255.0f + 0.5f);
-                uint8_t g = static_cast<uint8_t>(g_f * 255.0f + 0.5f);
-                uint8_t b = static_cast<uint8_t>(b_f * 255.0f + 0.5f);
-
-                // For 512 bins, each 8-bit value maps to 2 bins
-                // This ensures smooth distribution without gaps
-                int r_bin_low = r * 2;
-                int r_bin_high = std::min(511, r * 2 + 1);
-                int g_bin_low = g * 2;
-                int g_bin_high = std::min(511, g * 2 + 1);
-                int b_bin_low = b * 2;
-                int b_bin_high = std::min(511, b * 2 + 1);
-
-                // Count RGB values in both bins for smooth interpolation
-                local_r_hist[r_bin_low]++;
-                local_r_hist[r_bin_high]++;
-                local_g_hist[g_bin_low]++;
-                local_g_hist[g_bin_high]++;
-                local_b_hist[b_bin_low]++;
-                local_b_hist[b_bin_high]++;
-
-                // Calculate luminance with ITU-R BT.709 standard coefficients
-                float luminance_f = 0.2126f * r_f + 0.7152f * g_f + 0.0722f * b_f;
-                int luminance = static_cast<int>(luminance_f * 255.0f + 0.5f);
-
-                // Map luminance to two bins
-                int lum_bin_low = luminance * 2;
-                int lum_bin_high = std::min(511, luminance * 2 + 1);
-
-                local_lum_hist[lum_bin_low]++;
-                local_lum_hist[lum_bin_high]++;
-            }
-
-            // Copy local histograms to thread histogram
-            thread_histograms[t].r_hist = local_r_hist;
-            thread_histograms[t].g_hist = local_g_hist;
-            thread_histograms[t].b_hist = local_b_hist;
-            thread_histograms[t].luminance_hist = local_lum_hist;
-        });
-    }
+    // Anything still in flight is for an older render
+    m_histGen++;
+    m_histRefreshPending = false;
 
-    // Wait for all threads to complete
-    for (auto &thread : threads) {
-        thread.join();
-    }
-
-    // Combine thread-local histograms using SIMD-friendly pattern
-    for (const auto &thread_hist : thread_histograms) {
-        for (int i = 0; i < 512; i += 4) { // Process 4 bins at a time
-            histogram.r_hist[i] += thread_hist.r_hist[i];
-            histogram.r_hist[i+1] += thread_hist.r_hist[i+1];
-            histogram.r_hist[i+2] += thread_hist.r_hist[i+2];
-            histogram.r_hist[i+3] += thread_hist.r_hist[i+3];
-
-            histogram.g_hist[i] += thread_hist.g_hist[i];
-            histogram.g_hist[i+1] += thread_hist.g_hist[i+1];
-            histogram.g_hist[i+2] += thread_hist.g_hist[i+2];
-            histogram.g_hist[i+3] += thread_hist.g_hist[i+3];
-
-            histogram.b_hist[i] += thread_hist.b_hist[i];
-            histogram.b_hist[i+1] += thread_hist.b_hist[i+1];
-            histogram.b_hist[i+2] += thread_hist.b_hist[i+2];
-            histogram.b_hist[i+3] += thread_hist.b_hist[i+3];
-
-            histogram.luminance_hist[i] += thread_hist.luminance_hist[i];
-            histogram.luminance_hist[i+1] += thread_hist.luminance_hist[i+1];
-            histogram.luminance_hist[i+2] += thread_hist.luminance_hist[i+2];
-            histogram.luminance_hist[i+3] += thread_hist.luminance_hist[i+3];
+    // A reload can reuse the old buffer address, so don't trust the cache
+    if (!img->reloading) {
+        HistogramData cached;
+        if (m_histCache.find(key, cached)) {
+            drawHistogram(cached, key);
+            return;
         }
     }
-}
 
-//--- Update Histogram to Float Buffer ---//
-void openglGPU::updateHistPixels(image* img, float* imgPixels, float* histPixels, int width, int height, float intensityMultiplier) {
-
-    if (!img || !imgPixels || !histPixels) {
+    int hWidth = 0;
+    int hHeight = 0;
+    if (!readHistTexture(img, hWidth, hHeight))
         return;
-    }
-    // Clamp intensity multiplier to valid range
-    intensityMultiplier = std::clamp(intensityMultiplier, 0.0f, 1.0f);
 
-    // Clear to dark gray background (0.06 in float = ~15/255)
-    const float bg_color = 0.06f;
-    for (int y = 0; y < HISTHEIGHT; ++y) {
-        for (int x = 0; x < HISTWIDTH; ++x) {
-            int idx = (y * HISTWIDTH + x) * 4;
-            histPixels[idx + 0] = bg_color; // R
-            histPixels[idx + 1] = bg_color; // G
-            histPixels[idx + 2] = bg_color; // B
-            histPixels[idx + 3] = 1.0f;     // A
-        }
+    unsigned int cropBoxX[4];
+    unsigned int cropBoxY[4];
+    for (int i = 0; i < 4; i++) {
+        cropBoxX[i] = img->imgParam.cropBoxX[i] * hWidth;
+        cropBoxY[i] = img->imgParam.cropBoxY[i] * hHeight;
     }
+    m_histRead.gen = m_histGen;
+    m_histRead.key = key;
+    m_histRead.width = hWidth;
+    m_histRead.height = hHeight;
+    m_histRead.samples = settling ? std::max(appPrefs.prefs.histSamples, 0) : 0;
+    histogramSpans(hWidth, hHeight, cropBoxX, cropBoxY, img->imgParam.cropEnable, m_histRead.spans);
+}
 
-    unsigned int cropBoxX[4];
-        unsigned int cropBoxY[4];
-        for (int i = 0; i < 4; i++) {
-            cropBoxX[i] = img->imgParam.cropBoxX[i] * width;
-            cropBoxY[i] = img->imgParam.cropBoxY[i] * height;
+//--- Pump Histogram ---//
+/*
+    Called every frame. Maps a finished readback
+    and hands it to the pool, which copies it out
+    before binning, so this thread only maps and
+    unmaps. Shows a finished histogram if no
+    newer request has superseded it, and queues
+    the full pass behind a sampled one once
+    renders have settled.
+*/
+void openglGPU::pumpHistogram() {
+    if (m_histCopy.valid() && m_histCopy.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        unmapHistReadback();
+
+    if (m_histFence) {
+        GLenum state = glClientWaitSync(m_histFence, 0, 0);
+        if (state == GL_ALREADY_SIGNALED || state == GL_CONDITION_SATISFIED) {
+            glDeleteSync(m_histFence);
+            m_histFence = nullptr;
+            int buf = m_histPBONext ^ 1;    // The one last written
+            if (m_histRead.gen == m_histGen) {
+                if (buf == m_histMappedBuf)
+                    unmapHistReadback();
+                size_t bytes = (size_t)m_histRead.width * m_histRead.height * 4 * sizeof(float);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, m_histPBO[buf]);
+                const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                if (mapped) {
+                    m_histMappedBuf = buf;
+                    // Filled on the pool, a sampled pass's refresh bins it again
+                    m_histRead.pixels = std::make_shared<std::vector<float>>();
+                    submitHistJob(m_histRead, mapped);
+                }
+                checkError("Mapping Histogram Readback");
+            }
+        } else if (state == GL_WAIT_FAILED) {
+            glDeleteSync(m_histFence);
+            m_histFence = nullptr;
         }
+    }
 
-
-    // Calculate histogram
+    histJob done;
+    bool partial = false;
     HistogramData histogram;
-    calculateHistogramFromRGBA(imgPixels, width, height,
-                              histogram, cropBoxX, cropBoxY,
-                              img->imgParam.cropEnable);
-
-    // Find max values for scaling
-    int max_r = *std::max_element(histogram.r_hist.begin(), histogram.r_hist.end());
-    int max_g = *std::max_element(histogram.g_hist.begin(), histogram.g_hist.end());
-    int max_b = *std::max_element(histogram.b_hist.begin(), histogram.b_hist.end());
-    int max_lum = *std::max_element(histogram.luminance_hist.begin(), histogram.luminance_hist.end());
-
-    // Calculate percentile-based maximum to reduce spike impact
-    auto calculatePercentileMax = [](const std::array<int, 512>& hist, float percentile = 98.0f) -> int {
-        std::vector<int> sorted_values;
-        for (int val : hist) {
-            if (val > 0) sorted_values.push_back(val);
+    {
+        std::lock_guard<std::mutex> lock(m_histResult->lock);
+        if (m_histResult->ready) {
+            m_histResult->ready = false;
+            done.gen = m_histResult->gen;
+            done.key = m_histResult->key;
+            partial = m_histResult->partial;
+            histogram = m_histResult->histogram;
         }
-        if (sorted_values.empty()) return 1;
-
-        std::sort(sorted_values.begin(), sorted_values.end());
-        int idx = static_cast<int>(sorted_values.size() * (percentile / 100.0f));
-        if (idx >= sorted_values.size()) idx = sorted_values.size() - 1;
-
-        return sorted_values[idx];
-    };
-
-    // Use percentile-based maximum with a minimum floor to prevent over-scaling
-    int percentile_max_r = calculatePercentileMax(histogram.r_hist);
-    int percentile_max_g = calculatePercentileMax(histogram.g_hist);
-    int percentile_max_b = calculatePercentileMax(histogram.b_hist);
-    int percentile_max_lum = calculatePercentileMax(histogram.luminance_hist);
-
-    // Apply logarithmic dampening to extreme values
-    auto dampenMax = [](int max_val, int percentile_val) -> int {
-        if (max_val > percentile_val * 3) {
-            return percentile_val + static_cast<int>(std::log(max_val - percentile_val + 1) * percentile_val * 0.5);
-        }
-        return max_val;
-    };
-
-    max_r = dampenMax(max_r, percentile_max_r);
-    max_g = dampenMax(max_g, percentile_max_g);
-    max_b = dampenMax(max_b, percentile_max_b);
-    max_lum = dampenMax(max_lum, percentile_max_lum);
-
-    // Ensure minimum scaling to prevent division by zero
-    if (max_r == 0) max_r = 1;
-    if (max_g == 0) max_g = 1;
-    if (max_b == 0) max_b = 1;
-    if (max_lum == 0) max_lum = 1;
-
-    // Calculate base intensities with multiplier applied (convert to float)
-    const float red_intensity = (200.0f / 255.0f) * intensityMultiplier;
-    const float green_intensity = (200.0f / 255.0f) * intensityMultiplier;
-    const float blue_intensity = (200.0f / 255.0f) * intensityMultiplier;
-    const float white_intensity = intensityMultiplier; // 1.0 * multiplier
-
-    // Scale histogram width to match buffer width
-    float x_scale = static_cast<float>(HISTWIDTH) / 512.0f;
-
-    // Draw histogram with 512 bins scaled to histogram width
-    for (int bin = 0; bin < 512; ++bin) {
-        // Map bin to x coordinate(s)
-        int x_start = static_cast<int>(bin * x_scale);
-        int x_end = static_cast<int>((bin + 1) * x_scale);
-        if (x_end >= HISTWIDTH) x_end = HISTWIDTH - 1;
-
-        // Calculate heights with channel-specific scaling
-        int r_height = (histogram.r_hist[bin] * (HISTHEIGHT - 10)) / max_r;
-        int g_height = (histogram.g_hist[bin] * (HISTHEIGHT - 10)) / max_g;
-        int b_height = (histogram.b_hist[bin] * (HISTHEIGHT - 10)) / max_b;
-        int lum_height = (histogram.luminance_hist[bin] * (HISTHEIGHT - 10)) / max_lum;
+    }
+    if (done.gen != 0 && done.gen == m_histGen) {
+        if (!partial)
+            m_histCache.insert(done.key, histogram);
+        drawHistogram(histogram, done.key);
+        m_histRefreshPending = partial;
+    }
 
-        // Apply minimum visibility threshold
-        if (histogram.r_hist[bin] > 0 && r_height < 2) r_height = 2;
-        if (histogram.g_hist[bin] > 0 && g_height < 2) g_height = 2;
-        if (histogram.b_hist[bin] > 0 && b_height < 2) b_height = 2;
-        if (histogram.luminance_hist[bin] > 0 && lum_height < 2) lum_height = 2;
+    // Bin the whole of the sampled readback once renders stop
+    if (m_histRefreshPending && m_histRefresh.gen == m_histGen &&
+        std::chrono::steady_clock::now() - m_histLast >= std::chrono::milliseconds(HIST_SETTLE_MS)) {
+        m_histRefreshPending = false;
+        histJob full = m_histRefresh;
+        full.samples = 0;
+        submitHistJob(std::move(full));
+    }
+}
 
-        // Draw for all x coordinates this bin maps to
-        for (int x = x_start; x <= x_end; ++x) {
-            if (x >= HISTWIDTH) break;
+//--- Submit Histogram Job ---//
+/*
+    Bin on the pool. With a mapped readback the
+    job first copies it into its pixels and says
+    so through m_histCopy, so the buffer can be
+    unmapped while it bins. A result for an older
+    request than the one already waiting is
+    thrown away.
+*/
+void openglGPU::submitHistJob(histJob job, const void* mapped) {
+    if (job.samples > 0)
+        m_histRefresh = job;
+
+    std::shared_ptr<std::promise<void>> copied;
+    if (mapped) {
+        copied = std::make_shared<std::promise<void>>();
+        m_histCopy = copied->get_future();
+    }
 
-            // Draw luminance histogram in white (lowest layer)
-            for (int y = HISTHEIGHT - 1; y >= HISTHEIGHT - lum_height && y >= 0; --y) {
-                int idx = (y * HISTWIDTH + x) * 4;
-                histPixels[idx + 0] = white_intensity; // R
-                histPixels[idx + 1] = white_intensity; // G
-                histPixels[idx + 2] = white_intensity; // B
-                histPixels[idx + 3] = 1.0f;           // A
+    auto work = [slot = m_histResult, job = std::move(job), mapped, copied]() {
+        if (mapped) {
+            size_t count = (size_t)job.width * job.height * 4;
+            try {
+                job.pixels->resize(count);
+                std::memcpy(job.pixels->data(), mapped, count * sizeof(float));
+            } catch (const std::bad_alloc&) {
+                job.pixels->clear();
             }
+            copied->set_value();
+            if (job.pixels->empty()) {
+                LOG_WARN("Unable to allocate the histogram readback");
+                return;
+            }
+        }
 
-            // Draw RGB histograms with proper additive blending
-            for (int y = HISTHEIGHT - 1; y >= 0; --y) {
-                int idx = (y * HISTWIDTH + x) * 4;
-
-                // Skip if it's already white (luminance)
-                if (histPixels[idx + 0] == white_intensity &&
-                    histPixels[idx + 1] == white_intensity &&
-                    histPixels[idx + 2] == white_intensity) continue;
-
-                // Extract current color components
-                float current_r = histPixels[idx + 0];
-                float current_g = histPixels[idx + 1];
-                float current_b = histPixels[idx + 2];
-
-                // Determine what to add based on histogram heights
-                float add_r = 0, add_g = 0, add_b = 0;
-
-                if (y >= HISTHEIGHT - r_height) {
-                    add_r = red_intensity;
-                }
-                if (y >= HISTHEIGHT - g_height) {
-                    add_g = green_intensity;
-                }
-                if (y >= HISTHEIGHT - b_height) {
-                    add_b = blue_intensity;
-                }
+        HistogramData histogram;
+        if (job.samples > 0)
+            binHistogramSampled(job.pixels->data(), job.width, job.spans.data(),
+                                job.spans.size(), job.samples, histogram);
+        else
+            binHistogramSpans(job.pixels->data(), job.width, job.spans.data(),
+                              job.spans.size(), histogram);
+
+        std::lock_guard<std::mutex> lock(slot->lock);
+        if (slot->ready && slot->gen > job.gen)
+            return;
+        slot->ready = true;
+        slot->gen = job.gen;
+        slot->key = job.key;
+        slot->partial = job.samples > 0;
+        slot->histogram = histogram;
+    };
+    if (tPool)
+        tPool->submit(work);
+    else
+        work();
+}
 
-                // Mix colors additively
-                if (add_r > 0 || add_g > 0 || add_b > 0) {
-                    // Remove background and add new colors
-                    if (current_r == bg_color && current_g == bg_color && current_b == bg_color) {
-                        // If it's background, start fresh
-                        current_r = 0;
-                        current_g = 0;
-                        current_b = 0;
-                    }
+//--- Unmap Histogram Readback ---//
+/*
+    Release the readback buffer the pool was
+    copying out of, waiting for the copy if it
+    is still running
+*/
+void openglGPU::unmapHistReadback() {
+    if (m_histMappedBuf < 0)
+        return;
+    if (m_histCopy.valid())
+        m_histCopy.wait();
+    m_histCopy = std::future<void>();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_histPBO[m_histMappedBuf]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_histMappedBuf = -1;
+}
 
-                    current_r = std::min(1.0f, current_r + add_r);
-                    current_g = std::min(1.0f, current_g + add_g);
-                    current_b = std::min(1.0f, current_b + add_b);
+//--- Draw Histogram ---//
+/*
+    Upload the 512 bar heights and let the
+    histogram shader fill the display texture,
+    rather than drawing every pixel here
+ */
+void openglGPU::drawHistogram(const HistogramData& histogram, uint64_t key) {
+    if (!m_histProgram) {
+        LOG_WARN("No histogram shader!");
+        return;
+    }
+    float heights[512 * 4];
+    histogramBarHeights(histogram, HISTHEIGHT - 10, heights);
+
+    glBindTexture(GL_TEXTURE_1D, m_histBinTex);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 512, GL_RGBA, GL_FLOAT, heights);
+    checkError("Uploading Histogram Bins");
+
+    // Draw into the hidden texture, then show it
+    int back = m_histFront ^ 1;
+    glBindFramebuffer(GL_FRAMEBUFFER, m_histFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_histoTex[back], 0);
+    glViewport(0, 0, HISTWIDTH, HISTHEIGHT);
+    glUseProgram(m_histProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(m_histUniforms.histBins, 0);
+    glUniform1f(m_histUniforms.intensity, std::clamp(appPrefs.prefs.histInt, 0.0f, 1.0f));
+    glUniform1i(m_histUniforms.histWidth, HISTWIDTH);
+    glUniform1i(m_histUniforms.histHeight, HISTHEIGHT);
+
+    glBindVertexArray(m_vertexArray);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    checkError("Drawing Histogram");
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    m_histFront = back;
+    m_histKey = key;
+    m_histInt = appPrefs.prefs.histInt;
+}
 
-                    // Update pixel
-                    histPixels[idx + 0] = current_r;
-                    histPixels[idx + 1] = current_g;
-                    histPixels[idx + 2] = current_b;
-                    histPixels[idx + 3] = 1.0f;
-                }
-            }
-        }
+//--- Create Histogram Shader ---//
+/*
+    Program, bin texture and framebuffer
+    for drawing into the histogram texture
+ */
+bool openglGPU::createHistShader() {
+    GLuint vertexShader = compileShader(glsl_vertex, GL_VERTEX_SHADER);
+    GLuint fragShader = compileShader(glsl_histogram, GL_FRAGMENT_SHADER);
+    if (!vertexShader || !fragShader) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragShader);
+        return false;
+    }
+    m_histProgram = glCreateProgram();
+    glAttachShader(m_histProgram, vertexShader);
+    glAttachShader(m_histProgram, fragShader);
+    glLinkProgram(m_histProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragShader);
+
+    GLint success;
+    glGetProgramiv(m_histProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(m_histProgram, 512, nullptr, infoLog);
+        LOG_ERROR("Histogram shader link failed: {}", infoLog);
+        glDeleteProgram(m_histProgram);
+        m_histProgram = 0;
+        return false;
+    }
+    m_histUniforms.histBins = glGetUniformLocation(m_histProgram, "histBins");
+    m_histUniforms.intensity = glGetUniformLocation(m_histProgram, "intensity");
+    m_histUniforms.histWidth = glGetUniformLocation(m_histProgram, "histWidth");
+    m_histUniforms.histHeight = glGetUniformLocation(m_histProgram, "histHeight");
+
+    glGenTextures(1, &m_histBinTex);
+    glBindTexture(GL_TEXTURE_1D, m_histBinTex);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA32F, 512, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    glGenFramebuffers(1, &m_histFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_histFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_histoTex[0], 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    checkError("Creating Histogram Shader");
+    if (!complete) {
+        LOG_ERROR("Histogram framebuffer incomplete");
+        return false;
     }
+    return true;
 }
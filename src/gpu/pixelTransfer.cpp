@@ -0,0 +1,311 @@
+#include "pixelTransfer.h"
+#include "logger.h"
+#include "threadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define PIXEL_COPY_GRAIN (1 << 20)              // bytes per pool chunk
+#define PIXEL_WAIT_NS 1000000000ull             // one fence wait while blocking
+
+//--- Parallel Copy ---//
+/*
+    Mapped buffers are uncached on some drivers,
+    so big copies in and out of them are spread
+    over the pool in megabyte chunks
+*/
+static void parallelCopy(void* dst, const void* src, uint64_t bytes) {
+    size_t chunks = (size_t)((bytes + PIXEL_COPY_GRAIN - 1) / PIXEL_COPY_GRAIN);
+    parallelFor(0, chunks, 1, [&](size_t c0, size_t c1) {
+        uint64_t start = (uint64_t)c0 * PIXEL_COPY_GRAIN;
+        uint64_t end = std::min<uint64_t>((uint64_t)c1 * PIXEL_COPY_GRAIN, bytes);
+        std::memcpy((char*)dst + start, (const char*)src + start, end - start);
+    });
+}
+
+// Rows of rowBytes, strided differently on each side
+static void parallelCopyRows(char* dst, uint64_t dstPitch, const char* src, uint64_t srcPitch,
+                             uint64_t rowBytes, size_t rows) {
+    if (dstPitch == rowBytes && srcPitch == rowBytes) {
+        parallelCopy(dst, src, rowBytes * rows);
+        return;
+    }
+    size_t grain = std::max<size_t>(1, PIXEL_COPY_GRAIN / std::max<uint64_t>(rowBytes, 1));
+    parallelFor(0, rows, grain, [&](size_t r0, size_t r1) {
+        for (size_t r = r0; r < r1; r++)
+            std::memcpy(dst + r * dstPitch, src + r * srcPitch, rowBytes);
+    });
+}
+
+pixelTransfer::pixelTransfer(int slots, uint64_t slotBytes) :
+    m_slots(std::max(slots, 1)), m_slotBytes(std::max<uint64_t>(slotBytes, 1)) {}
+
+pixelTransfer::~pixelTransfer() {
+    release();
+}
+
+//--- Upload ---//
+/*
+    A band of rows per ring slot. Waiting on the
+    slot's fence only blocks if the driver is
+    still reading the band from a full lap ago.
+    If a buffer can't be mapped, that band goes
+    up from client memory instead.
+*/
+bool pixelTransfer::upload(GLuint textureID, int width, int height, const float* rgbaData,
+                           int rowLength) {
+    if (!rgbaData) {
+        LOG_ERROR("No image data for render!");
+        return false;
+    }
+    if (width < 1 || height < 1)
+        return false;
+
+    uint64_t rowBytes = (uint64_t)width * 4 * sizeof(float);
+    uint64_t srcPitch = (uint64_t)std::max(rowLength, width) * 4 * sizeof(float);
+    int bandRows = (int)std::clamp<uint64_t>(m_slotBytes / rowBytes, 1, (uint64_t)height);
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    for (int y = 0; y < height; y += bandRows) {
+        int rows = std::min(bandRows, height - y);
+        uint64_t bytes = rows * rowBytes;
+        const char* src = (const char*)rgbaData + y * srcPitch;
+
+        uploadSlot& slot = m_slots[m_nextSlot];
+        m_nextSlot = (m_nextSlot + 1) % (int)m_slots.size();
+        if (slot.fence) {
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, PIXEL_WAIT_NS);
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.pbo == 0)
+            glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        if (bytes > slot.size) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            slot.size = bytes;
+        }
+
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped) {
+            parallelCopyRows((char*)mapped, rowBytes, src, srcPitch, rowBytes, rows);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            // Sourced from the bound buffer, so this only queues the copy
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RGBA, GL_FLOAT, nullptr);
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength > width ? rowLength : 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RGBA, GL_FLOAT, src);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+//--- Readback ---//
+/*
+    Queue the copy into a pack buffer sized for
+    this image and fence it. If the buffer can't
+    be had, read straight back the old way and
+    report done right away.
+*/
+bool pixelTransfer::readback(GLuint textureID, int width, int height, float* rgbaData,
+                             std::function<void(bool)> done, int rowLength) {
+    if (!rgbaData || width < 1 || height < 1)
+        return false;
+
+    // Whoever waited on the one this replaces hears with this one
+    for (auto it = m_reads.begin(); it != m_reads.end();) {
+        if (it->dst != rgbaData) {
+            ++it;
+            continue;
+        }
+        auto replaced = std::move(it->done);
+        dropJob(*it);
+        it = m_reads.erase(it);
+        if (replaced && done) {
+            done = [newer = std::move(done), replaced = std::move(replaced)](bool ok) {
+                newer(ok);
+                replaced(ok);
+            };
+        } else if (replaced) {
+            done = std::move(replaced);
+        }
+    }
+
+    readJob job;
+    job.bytes = (uint64_t)width * height * 4 * sizeof(float);
+    job.dst = rgbaData;
+    job.width = width;
+    job.height = height;
+    job.rowLength = std::max(rowLength, width);
+    job.done = std::move(done);
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glGenBuffers(1, &job.pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, job.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, job.bytes, nullptr, GL_STREAM_READ);
+    if (glGetError() != GL_NO_ERROR) {
+        LOG_WARN("Could not allocate {} byte readback buffer, reading back directly", job.bytes);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteBuffers(1, &job.pbo);
+        glPixelStorei(GL_PACK_ROW_LENGTH, job.rowLength > width ? job.rowLength : 0);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, rgbaData);
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        if (job.done)
+            job.done(true);
+        return true;
+    }
+
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, nullptr);
+    job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    // Get the fence to the GPU, poll() doesn't flush
+    glFlush();
+
+    m_reads.push_back(std::move(job));
+    return true;
+}
+
+//--- Advance ---//
+/*
+    Fence passed -> map and start the copy out.
+    Copy finished -> unmap, free and call done.
+    Without wait, each step only happens if it
+    can without blocking.
+*/
+bool pixelTransfer::advance(readJob& job, bool wait) {
+    if (!job.mapped) {
+        GLenum state = glClientWaitSync(job.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                        wait ? PIXEL_WAIT_NS : 0);
+        while (wait && state == GL_TIMEOUT_EXPIRED)
+            state = glClientWaitSync(job.fence, 0, PIXEL_WAIT_NS);
+        if (state == GL_TIMEOUT_EXPIRED)
+            return false;
+        // A failed wait still gets mapped, mapping syncs on its own
+        if (state == GL_WAIT_FAILED)
+            LOG_WARN("Readback fence wait failed");
+        glDeleteSync(job.fence);
+        job.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, job.pbo);
+        job.mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, job.bytes, GL_MAP_READ_BIT);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (!job.mapped) {
+            LOG_ERROR("Could not map {} byte readback buffer", job.bytes);
+            auto done = std::move(job.done);
+            dropJob(job);
+            if (done)
+                done(false);
+            return true;
+        }
+
+        char* dst = (char*)job.dst;
+        const char* src = (const char*)job.mapped;
+        uint64_t rowBytes = (uint64_t)job.width * 4 * sizeof(float);
+        uint64_t dstPitch = (uint64_t)job.rowLength * 4 * sizeof(float);
+        size_t rows = job.height;
+        auto copy = [dst, dstPitch, src, rowBytes, rows] {
+            parallelCopyRows(dst, dstPitch, src, rowBytes, rowBytes, rows);
+        };
+        if (tPool && !wait)
+            job.copy = tPool->submit(copy);
+        else
+            copy();
+    }
+
+    if (job.copy.valid()) {
+        if (!wait && job.copy.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+        job.copy.get();
+    }
+
+    auto done = std::move(job.done);
+    dropJob(job);
+    if (done)
+        done(true);
+    return true;
+}
+
+void pixelTransfer::dropJob(readJob& job) {
+    if (job.copy.valid())
+        job.copy.wait();
+    if (job.mapped) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, job.pbo);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        job.mapped = nullptr;
+    }
+    if (job.fence) {
+        glDeleteSync(job.fence);
+        job.fence = nullptr;
+    }
+    if (job.pbo) {
+        glDeleteBuffers(1, &job.pbo);
+        job.pbo = 0;
+    }
+}
+
+void pixelTransfer::poll() {
+    for (auto it = m_reads.begin(); it != m_reads.end();) {
+        if (advance(*it, false))
+            it = m_reads.erase(it);
+        else
+            ++it;
+    }
+}
+
+void pixelTransfer::finish() {
+    while (!m_reads.empty()) {
+        advance(m_reads.front(), true);
+        m_reads.pop_front();
+    }
+}
+
+void pixelTransfer::cancel(const float* rgbaData, uint64_t bytes) {
+    const char* lo = (const char*)rgbaData;
+    for (auto it = m_reads.begin(); it != m_reads.end();) {
+        const char* dst = (const char*)it->dst;
+        if (dst == lo || (bytes && dst > lo && dst < lo + bytes)) {
+            auto done = std::move(it->done);
+            dropJob(*it);
+            it = m_reads.erase(it);
+            if (done)
+                done(false);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void pixelTransfer::release() {
+    while (!m_reads.empty()) {
+        auto done = std::move(m_reads.front().done);
+        dropJob(m_reads.front());
+        m_reads.pop_front();
+        if (done)
+            done(false);
+    }
+    for (auto& slot : m_slots) {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        if (slot.pbo)
+            glDeleteBuffers(1, &slot.pbo);
+        slot = uploadSlot();
+    }
+    m_nextSlot = 0;
+}
+
+uint64_t pixelTransfer::pendingBytes() const {
+    uint64_t bytes = 0;
+    for (const auto& job : m_reads)
+        bytes += job.bytes;
+    return bytes;
+}
@@ -0,0 +1,100 @@
+#ifndef _pixeltransfer_h
+#define _pixeltransfer_h
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <vector>
+
+#define PBO_RING_SLOTS 3
+#define PBO_SLOT_BYTES (16 << 20)   // per upload slot, a band of rows at a time
+
+//--- Pixel Transfer ---//
+/*
+    Moves RGBA float images between client memory
+    and textures through pixel buffer objects, so
+    neither direction stalls the GL thread.
+
+    Uploads go through a small ring of unpack
+    buffers, a band of rows per slot. Each band is
+    fenced, and a slot is only refilled once the
+    driver has finished pulling the last band out
+    of it, so the copy into the buffer overlaps the
+    transfer of the band before it.
+
+    Readbacks are queued into a pack buffer of
+    their own and fenced. poll() (once a frame)
+    picks up the ones whose fence has passed, copies
+    them out on the pool and then calls their done
+    callback with true, which is how the waiting
+    side hears the pixels are in place. A readback
+    that is cancelled or can't be mapped calls it
+    with false.
+
+    Everything here, done callbacks included, runs
+    on the thread that owns the GL context.
+*/
+class pixelTransfer {
+    public:
+        explicit pixelTransfer(int slots = PBO_RING_SLOTS, uint64_t slotBytes = PBO_SLOT_BYTES);
+        ~pixelTransfer();
+
+        // Copy width x height RGBA floats into level 0 of the texture,
+        // rows rowLength pixels apart in rgbaData (0 for width)
+        bool upload(GLuint textureID, int width, int height, const float* rgbaData,
+                    int rowLength = 0);
+
+        // Queue a copy of level 0 into rgbaData, which has to stay
+        // valid until done is called. Replaces a pending readback
+        // into the same buffer, whose callback then goes with this one.
+        // Rows land rowLength pixels apart (0 for width).
+        bool readback(GLuint textureID, int width, int height, float* rgbaData,
+                      std::function<void(bool)> done, int rowLength = 0);
+
+        // Finish what is ready without waiting on the GPU
+        void poll();
+        // Block until every readback has landed
+        void finish();
+        // Drop pending readbacks, their callbacks hear false. With
+        // bytes, every one landing inside that buffer (tiled renders).
+        void cancel(const float* rgbaData, uint64_t bytes = 0);
+        // Free the buffers, the context has to still be current
+        void release();
+
+        size_t pending() const { return m_reads.size(); }
+        uint64_t pendingBytes() const;
+
+    private:
+        struct uploadSlot {
+            GLuint pbo = 0;
+            uint64_t size = 0;
+            GLsync fence = nullptr;
+        };
+
+        struct readJob {
+            GLuint pbo = 0;
+            GLsync fence = nullptr;
+            uint64_t bytes = 0;
+            float* dst = nullptr;
+            int width = 0;
+            int height = 0;
+            int rowLength = 0;
+            const void* mapped = nullptr;
+            std::future<void> copy;
+            std::function<void(bool)> done;
+        };
+
+        // Step a job along, true once it has completed
+        bool advance(readJob& job, bool wait);
+        // Free the job's buffer, fence and mapping, no callback
+        void dropJob(readJob& job);
+
+        std::vector<uploadSlot> m_slots;
+        int m_nextSlot = 0;
+        uint64_t m_slotBytes;
+        std::list<readJob> m_reads;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "renderQueue.h"
+
+renderPriority renderPriorityOf(renderType type) {
+    switch (type) {
+        case r_full:
+            return p_export;
+        case r_bg:
+            return p_background;
+        case r_sdt:
+        case r_blr:
+        default:
+            return p_interactive;
+    }
+}
+
+// The surviving request's ticket, with the folded one chained on
+static renderTicketPtr foldTicket(const renderTicketPtr& keep, const renderTicketPtr& folded) {
+    if (!keep)
+        return folded;
+    keep->chain(folded);
+    return keep;
+}
+
+void renderQueue::push(const gpuQueue& job) {
+    if (!job._img)
+        return;
+    gpuQueue queued = job;
+    renderPriority priority = renderPriorityOf(job._type);
+    if (priority == p_interactive) {
+        renderTicketPtr covered;
+        if (erase(job._img, p_background, covered))
+            queued._ticket = foldTicket(queued._ticket, covered);
+    } else if (priority == p_background) {
+        auto cover = m_slots.find({job._img, p_interactive});
+        if (cover != m_slots.end()) {
+            cover->second->_ticket = foldTicket(cover->second->_ticket, job._ticket);
+            return;
+        }
+    }
+
+    auto slot = m_slots.find({job._img, priority});
+    if (slot != m_slots.end()) {
+        // Latest wins, in the old one's place
+        queued._ticket = foldTicket(queued._ticket, slot->second->_ticket);
+        *slot->second = queued;
+        return;
+    }
+    m_fifo[priority].push_back(queued);
+    m_slots[{job._img, priority}] = std::prev(m_fifo[priority].end());
+}
+
+bool renderQueue::pop(gpuQueue& job) {
+    for (int priority = 0; priority < p_count; priority++) {
+        if (m_fifo[priority].empty())
+            continue;
+        job = m_fifo[priority].front();
+        m_slots.erase({job._img, priority});
+        m_fifo[priority].pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool renderQueue::pop(renderPriority priority, gpuQueue& job) {
+    for (int urgent = 0; urgent < priority; urgent++) {
+        if (!m_fifo[urgent].empty())
+            return false;
+    }
+    if (m_fifo[priority].empty())
+        return false;
+    job = m_fifo[priority].front();
+    m_slots.erase({job._img, priority});
+    m_fifo[priority].pop_front();
+    return true;
+}
+
+bool renderQueue::contains(const image* img) const {
+    for (int priority = 0; priority < p_count; priority++) {
+        if (m_slots.count({img, priority}))
+            return true;
+    }
+    return false;
+}
+
+void renderQueue::remove(const image* img) {
+    for (int priority = 0; priority < p_count; priority++) {
+        renderTicketPtr ticket;
+        if (erase(img, priority, ticket) && ticket)
+            ticket->cancel();
+    }
+}
+
+void renderQueue::clear() {
+    for (auto& fifo : m_fifo) {
+        cancelAll(fifo);
+        fifo.clear();
+    }
+    m_slots.clear();
+}
+
+bool renderQueue::erase(const image* img, int priority, renderTicketPtr& ticket) {
+    auto slot = m_slots.find({img, priority});
+    if (slot == m_slots.end())
+        return false;
+    ticket = slot->second->_ticket;
+    m_fifo[priority].erase(slot->second);
+    m_slots.erase(slot);
+    return true;
+}
+
+void renderQueue::cancelAll(const jobList& jobs) {
+    for (const auto& job : jobs) {
+        if (job._ticket)
+            job._ticket->cancel();
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef _renderqueue_h
+#define _renderqueue_h
+
+#include "gpuStructs.h"
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+// Served in this order, whatever order they came in
+enum renderPriority {
+    p_interactive = 0,      // The viewer, edits in progress
+    p_export = 1,           // Full resolution renders an export waits on
+    p_background = 2,       // Thumbnails
+    p_count = 3
+};
+
+renderPriority renderPriorityOf(renderType type);
+
+//--- Render Queue ---//
+/*
+    A FIFO per priority class, with a mailbox per
+    image and class: queueing an image that is
+    already waiting only swaps in the newer
+    request, it keeps its place in line and is
+    rendered once.
+
+    An interactive request stands in for a
+    background one for the same image, so that
+    one is dropped (or never queued).
+
+    Tickets of requests folded into another are
+    chained onto its ticket, those of requests
+    removed from the queue are cancelled.
+
+    Lookups and removal by image are constant
+    time. Not thread-safe, the GPU holds its
+    queue lock around it.
+*/
+class renderQueue {
+    public:
+        void push(const gpuQueue& job);
+        // Next job by priority, false when empty.
+        // Its ticket is the caller's to settle.
+        bool pop(gpuQueue& job);
+        // Next job of one class, only while nothing
+        // more urgent is waiting (batched thumbnails)
+        bool pop(renderPriority priority, gpuQueue& job);
+        bool contains(const image* img) const;
+        void remove(const image* img);
+        void clear();
+
+        size_t size() const { return m_slots.size(); }
+        bool empty() const { return m_slots.empty(); }
+        size_t size(renderPriority priority) const { return m_fifo[priority].size(); }
+
+    private:
+        using jobList = std::list<gpuQueue>;
+
+        struct slotKey {
+            const image* img;
+            int priority;
+            bool operator==(const slotKey& other) const {
+                return img == other.img && priority == other.priority;
+            }
+        };
+        struct slotKeyHash {
+            size_t operator()(const slotKey& key) const {
+                return std::hash<const image*>()(key.img) * 31 + key.priority;
+            }
+        };
+
+        // Take a queued job out, its ticket is left to the caller
+        bool erase(const image* img, int priority, renderTicketPtr& ticket);
+        void cancelAll(const jobList& jobs);
+
+        jobList m_fifo[p_count];
+        std::unordered_map<slotKey, jobList::iterator, slotKeyHash> m_slots;
+};
+
+#endif
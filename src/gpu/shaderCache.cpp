@@ -0,0 +1,379 @@
+#include "gpu.h"
+#include "glslKernels.h"
+#include "ocioProcessor.h"
+#include "preferences.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#define PROGRAM_BINARY_MAGIC 0x42505646u   // "FVPB"
+#define PROGRAM_BINARY_MAX_FILES 64         // binaries kept on disk for the current driver
+
+struct programBinaryHeader {
+    uint32_t magic = PROGRAM_BINARY_MAGIC;
+    uint32_t format = 0;
+    uint32_t length = 0;
+};
+
+// Named driver_program so other drivers' binaries can be found and pruned
+static std::string programBinaryPath(uint64_t driver, uint64_t hash) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%016llx_%016llx.bin",
+                  (unsigned long long)driver, (unsigned long long)hash);
+    return (std::filesystem::path(appPrefs.getShaderCacheDir()) / name).string();
+}
+
+// Same filtering and wrap the OCIO helper gives its LUTs
+static void setLutParameters(GLenum target, OCIO::Interpolation interpolation) {
+    GLint filter = interpolation == OCIO::INTERP_NEAREST ? GL_NEAREST : GL_LINEAR;
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+openglGPU::shaderProgram::~shaderProgram() {
+    // The OCIO helper cleans up after itself
+    for (auto& tex : textures)
+        glDeleteTextures(1, &tex.second);
+    if (ownsProgram && program)
+        glDeleteProgram(program);
+}
+
+//--- Use Shaders ---//
+/*
+    Make the display program for these OCIO
+    settings current, building it only if it
+    is not cached. Switching images with the
+    same settings is just a lookup.
+*/
+bool openglGPU::useShaders(ocioSetting& ocioSet) {
+    processorKey key;
+    key.config = ocioProc.selectedConfig;
+    key.colorspace = ocioSet.colorspace;
+    key.display = ocioSet.display;
+    key.view = ocioSet.view;
+    key.inverse = ocioSet.inverse;
+    key.useDisplay = ocioSet.useDisplay;
+
+    std::shared_ptr<shaderProgram> shader;
+    if (!m_programCache.find(key, shader)) {
+        shader = createShaders(ocioSet);
+        if (!shader)
+            return false;
+        m_programCache.insert(key, shader);
+    }
+    if (shader != m_activeShader) {
+        m_activeShader = shader;
+        m_shaderProgram = shader->program;
+        m_uniforms = shader->uniforms;
+    }
+    return true;
+}
+
+//--- Create Shaders ---//
+/*
+    Build the display program for the given
+    OCIO settings. With the disk cache on, a
+    program linked on an earlier run is read
+    back instead of compiled, and a new one is
+    saved once linked.
+*/
+std::shared_ptr<openglGPU::shaderProgram> openglGPU::createShaders(ocioSetting& ocioSet) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Get OCIO Context
+    OCIO::GpuShaderDescRcPtr gpuDesc = ocioProc.getGLDesc(ocioSet);
+
+    if (!gpuDesc) {
+        LOG_ERROR("Unable to get OCIO GPU Context!");
+        checkError("OCIO GPU Description");
+        return nullptr;
+    }
+
+    std::string ocioKernText = glsl_process;
+    auto nPos = ocioKernText.find("OCIOFUNC");
+    if (nPos != std::string::npos) {
+        auto nSize = std::string("OCIOFUNC").size();
+        std::string kernFunc = gpuDesc->getFunctionName();
+        ocioKernText.erase(ocioKernText.begin() + nPos, ocioKernText.begin() + nPos + nSize);
+        ocioKernText.insert(nPos, kernFunc);
+    } else {
+        LOG_ERROR("Corrupted GLSL shaders!");
+        return nullptr;
+    }
+
+    // Binaries only load on the driver that made them
+    uint64_t driver = hashBytes(nullptr, 0);
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const char* str = (const char*)glGetString(name);
+        if (str)
+            driver = hashBytes(str, std::strlen(str), driver);
+    }
+    uint64_t hash = driver;
+    std::string ocioText = gpuDesc->getShaderText();
+    std::string vertText = glsl_vertex;
+    hash = hashBytes(ocioText.data(), ocioText.size(), hash);
+    hash = hashBytes(ocioKernText.data(), ocioKernText.size(), hash);
+    hash = hashBytes(vertText.data(), vertText.size(), hash);
+
+    // Dynamic properties are set through the helper, which
+    // only knows programs it linked itself
+    bool diskCache = appPrefs.prefs.shaderDiskCache && programBinarySupported() &&
+                     gpuDesc->getNumUniforms() == 0;
+
+    std::string binaryPath;
+    if (diskCache) {
+        if (!m_binariesPruned)
+            pruneProgramBinaries(driver);
+        binaryPath = programBinaryPath(driver, hash);
+    }
+
+    auto shader = std::make_shared<shaderProgram>();
+    bool fromDisk = diskCache && loadProgramBinary(*shader, gpuDesc, binaryPath);
+    if (!fromDisk) {
+        shader->builder = OCIO::OpenGLBuilder::Create(gpuDesc);
+        checkError("OCIO Processor Creation");
+
+        shader->builder->allocateAllTextures(1);
+        checkError("OCIO Texture Allocation");
+
+        GLuint vertexShader = compileShader(glsl_vertex, GL_VERTEX_SHADER);
+        checkError("Vertex Shader Compilation");
+
+        try {
+            // Build the fragment shader program.
+            shader->builder->buildProgram(ocioKernText.c_str(), false, vertexShader);
+        } catch (OCIO::Exception& e) {
+            LOG_ERROR("Unable to build shaders: {}", e.what());
+            return nullptr;
+        }
+        shader->program = shader->builder->getProgramHandle();
+        if (!shader->program)
+            return nullptr;
+        if (diskCache)
+            saveProgramBinary(shader->program, binaryPath);
+    }
+
+    m_shaderProgram = shader->program;
+    memset(&m_uniforms, -1, sizeof(m_uniforms));
+    cacheUniformLocations();
+    shader->uniforms = m_uniforms;
+
+    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("{} display shader in {}ms", fromDisk ? "Loaded cached" : "Built", dur.count());
+    return shader;
+}
+
+//--- Program Binary Supported ---//
+/*
+    Whether the driver can hand back linked
+    programs, checked once
+*/
+bool openglGPU::programBinarySupported() {
+    if (m_binaryFormats < 0) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        while (glGetError() != GL_NO_ERROR) {}  // Older contexts don't know the query
+        m_binaryFormats = formats;
+        if (formats < 1)
+            LOG_INFO("No program binary formats, display shaders won't be cached on disk");
+    }
+    return m_binaryFormats > 0;
+}
+
+//--- Load Program Binary ---//
+/*
+    Read a saved program and set it up the way
+    the OCIO helper would: the LUT textures on
+    units from 1, 3D ones first, with samplers
+    pointed at them. A binary the driver turns
+    down is deleted so it gets rebuilt.
+*/
+bool openglGPU::loadProgramBinary(shaderProgram& shader, const OCIO::GpuShaderDescRcPtr& gpuDesc,
+                                  const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    programBinaryHeader header;
+    file.read((char*)&header, sizeof(header));
+    std::vector<char> binary;
+    if (file && header.magic == PROGRAM_BINARY_MAGIC && header.length > 0) {
+        binary.resize(header.length);
+        file.read(binary.data(), binary.size());
+    }
+    if (!file || binary.empty()) {
+        LOG_WARN("Discarding unreadable shader cache {}", path);
+        file.close();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+    file.close();
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // Usually a driver update
+        LOG_INFO("Shader cache {} is stale, rebuilding", path);
+        glDeleteProgram(program);
+        while (glGetError() != GL_NO_ERROR) {}
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+    shader.program = program;
+    shader.ownsProgram = true;
+
+    glUseProgram(program);
+    GLint unit = 1;
+    for (unsigned i = 0; i < gpuDesc->getNum3DTextures(); i++, unit++) {
+        const char* textureName = nullptr;
+        const char* samplerName = nullptr;
+        unsigned edgeLen = 0;
+        OCIO::Interpolation interpolation = OCIO::INTERP_LINEAR;
+        const float* values = nullptr;
+        gpuDesc->get3DTexture(i, textureName, samplerName, edgeLen, interpolation);
+        gpuDesc->get3DTextureValues(i, values);
+
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_3D, tex);
+        setLutParameters(GL_TEXTURE_3D, interpolation);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB32F, edgeLen, edgeLen, edgeLen,
+                     0, GL_RGB, GL_FLOAT, values);
+        shader.textures.emplace_back(GL_TEXTURE_3D, tex);
+        glUniform1i(glGetUniformLocation(program, samplerName), unit);
+    }
+    for (unsigned i = 0; i < gpuDesc->getNumTextures(); i++, unit++) {
+        const char* textureName = nullptr;
+        const char* samplerName = nullptr;
+        unsigned width = 0, height = 0;
+        OCIO::GpuShaderDesc::TextureType channel = OCIO::GpuShaderDesc::TEXTURE_RGB_CHANNEL;
+        OCIO::GpuShaderDesc::TextureDimensions dimensions = OCIO::GpuShaderDesc::TEXTURE_1D;
+        OCIO::Interpolation interpolation = OCIO::INTERP_LINEAR;
+        const float* values = nullptr;
+        gpuDesc->getTexture(i, textureName, samplerName, width, height, channel, dimensions, interpolation);
+        gpuDesc->getTextureValues(i, values);
+
+        bool red = channel == OCIO::GpuShaderDesc::TEXTURE_RED_CHANNEL;
+        GLenum target = dimensions == OCIO::GpuShaderDesc::TEXTURE_1D ? GL_TEXTURE_1D : GL_TEXTURE_2D;
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, tex);
+        setLutParameters(target, interpolation);
+        if (target == GL_TEXTURE_1D)
+            glTexImage1D(GL_TEXTURE_1D, 0, red ? GL_R32F : GL_RGB32F, width,
+                         0, red ? GL_RED : GL_RGB, GL_FLOAT, values);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, red ? GL_R32F : GL_RGB32F, width, height,
+                         0, red ? GL_RED : GL_RGB, GL_FLOAT, values);
+        shader.textures.emplace_back(target, tex);
+        glUniform1i(glGetUniformLocation(program, samplerName), unit);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(0);
+    checkError("Loading Cached Shader");
+    return true;
+}
+
+//--- Save Program Binary ---//
+/*
+    Write a freshly linked program out for the
+    next run. Failing here only costs a compile
+    next time.
+*/
+void openglGPU::saveProgramBinary(GLuint program, const std::string& path) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        while (glGetError() != GL_NO_ERROR) {}
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (glGetError() != GL_NO_ERROR || written <= 0)
+        return;
+
+    programBinaryHeader header;
+    header.format = format;
+    header.length = (uint32_t)written;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), written);
+    if (!file)
+        LOG_WARN("Unable to write shader cache {}", path);
+}
+
+//--- Prune Program Binaries ---//
+/*
+    Run once before the first cache lookup. Binaries
+    from any other driver (or the old unprefixed
+    names) can never load again, so they go. Of the
+    rest only the most recently written are kept.
+*/
+void openglGPU::pruneProgramBinaries(uint64_t driver) {
+    m_binariesPruned = true;
+    char prefix[24];
+    std::snprintf(prefix, sizeof(prefix), "%016llx_", (unsigned long long)driver);
+
+    std::error_code ec;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> current;
+    int removed = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(appPrefs.getShaderCacheDir(), ec)) {
+        const std::filesystem::path& path = entry.path();
+        if (!entry.is_regular_file(ec) || path.extension() != ".bin")
+            continue;
+        if (path.filename().string().rfind(prefix, 0) == 0) {
+            current.emplace_back(entry.last_write_time(ec), path);
+            continue;
+        }
+        if (std::filesystem::remove(path, ec))
+            removed++;
+    }
+
+    if (current.size() > PROGRAM_BINARY_MAX_FILES) {
+        // Newest first
+        std::sort(current.begin(), current.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first;
+        });
+        for (size_t i = PROGRAM_BINARY_MAX_FILES; i < current.size(); i++)
+            if (std::filesystem::remove(current[i].second, ec))
+                removed++;
+    }
+    if (removed > 0)
+        LOG_INFO("Pruned {} stale display shaders from the disk cache", removed);
+}
+
+//--- Bind Shader Textures ---//
+/*
+    Bind the active program's LUT textures
+    (and any OCIO uniforms) for a draw
+*/
+void openglGPU::bindShaderTextures() {
+    if (!m_activeShader)
+        return;
+    if (m_activeShader->builder) {
+        m_activeShader->builder->useAllTextures();
+        m_activeShader->builder->useAllUniforms();
+        return;
+    }
+    for (size_t i = 0; i < m_activeShader->textures.size(); i++) {
+        glActiveTexture(GL_TEXTURE1 + (GLenum)i);
+        glBindTexture(m_activeShader->textures[i].first, m_activeShader->textures[i].second);
+    }
+}
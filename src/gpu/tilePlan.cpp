@@ -0,0 +1,119 @@
+#include "tilePlan.h"
+#include <algorithm>
+#include <cmath>
+
+//--- Map Output UV ---//
+/*
+    The same steps as the kernel: into the crop
+    rectangle, then rotated about the image
+    centre in pixel-square space
+*/
+void mapOutputUV(const tileMapping& map, float u, float v, float& su, float& sv) {
+    if (!map.cropEnabled && !map.cropVisible) {
+        su = u;
+        sv = v;
+        return;
+    }
+    float wu = u;
+    float wv = v;
+    if (map.cropEnabled) {
+        wu = map.cropMin[0] + (map.cropMax[0] - map.cropMin[0]) * u;
+        wv = map.cropMin[1] + (map.cropMax[1] - map.cropMin[1]) * v;
+    }
+    float aspect = (float)map.width / (float)map.height;
+    float cx = (wu - 0.5f) * aspect;
+    float cy = wv - 0.5f;
+    float cosR = std::cos(map.rotation);
+    float sinR = std::sin(map.rotation);
+    su = (cx * cosR - cy * sinR) / aspect + 0.5f;
+    sv = cx * sinR + cy * cosR + 0.5f;
+}
+
+// Input texels [lo, hi) under a UV span plus the apron, inside [0, size).
+// The slack keeps float noise on whole texels from taking in one more.
+static void inputSpan(float uvMin, float uvMax, unsigned int size, unsigned int apron,
+                      unsigned int& lo, unsigned int& hi) {
+    double a = std::floor((double)uvMin * size + 1e-3) - apron;
+    double b = std::ceil((double)uvMax * size - 1e-3) + apron;
+    a = std::clamp(a, 0.0, (double)size);
+    b = std::clamp(b, 0.0, (double)size);
+    if (b <= a) {
+        // Off the image entirely, the kernel never samples it
+        a = std::min(a, (double)size - 1.0);
+        b = a + 1.0;
+    }
+    lo = (unsigned int)a;
+    hi = (unsigned int)b;
+}
+
+//--- Plan Render Tiles ---//
+/*
+    The mapping is affine, so the four corners of
+    an output tile bound everything it samples.
+    A rotation can make that footprint wider than
+    the tile, if one comes out past the texture
+    limit the tiles are halved and planned again.
+*/
+std::vector<renderTile> planRenderTiles(const tileMapping& map, unsigned int maxTexture,
+                                        unsigned int tileSize, unsigned int apron) {
+    std::vector<renderTile> tiles;
+    if (map.width == 0 || map.height == 0 || map.outWidth == 0 || map.outHeight == 0)
+        return tiles;
+
+    for (unsigned int size = std::min(tileSize, maxTexture); size > 0; size /= 2) {
+        tiles.clear();
+        bool fits = true;
+        for (unsigned int oy = 0; oy < map.outHeight && fits; oy += size) {
+            for (unsigned int ox = 0; ox < map.outWidth && fits; ox += size) {
+                renderTile tile;
+                tile.outX = ox;
+                tile.outY = oy;
+                tile.outW = std::min(size, map.outWidth - ox);
+                tile.outH = std::min(size, map.outHeight - oy);
+
+                float uMin = 1e30f, uMax = -1e30f, vMin = 1e30f, vMax = -1e30f;
+                for (unsigned int cx : {ox, ox + tile.outW}) {
+                    for (unsigned int cy : {oy, oy + tile.outH}) {
+                        float su, sv;
+                        mapOutputUV(map, (float)cx / map.outWidth, (float)cy / map.outHeight, su, sv);
+                        uMin = std::min(uMin, su);
+                        uMax = std::max(uMax, su);
+                        vMin = std::min(vMin, sv);
+                        vMax = std::max(vMax, sv);
+                    }
+                }
+                unsigned int x0, x1, y0, y1;
+                inputSpan(uMin, uMax, map.width, apron, x0, x1);
+                inputSpan(vMin, vMax, map.height, apron, y0, y1);
+                tile.inX = x0;
+                tile.inY = y0;
+                tile.inW = x1 - x0;
+                tile.inH = y1 - y0;
+                fits = tile.inW <= maxTexture && tile.inH <= maxTexture;
+                tiles.push_back(tile);
+            }
+        }
+        if (fits)
+            return tiles;
+    }
+    tiles.clear();
+    return tiles;
+}
+
+//--- Render Tile Uniforms ---//
+/*
+    outputTile places the tile's viewport in the
+    full output, inputTile takes full image UVs
+    into the tile's input texture
+*/
+void renderTileUniforms(const tileMapping& map, const renderTile& tile,
+                        float outputTile[4], float inputTile[4]) {
+    outputTile[0] = (float)((double)tile.outX / map.outWidth);
+    outputTile[1] = (float)((double)tile.outY / map.outHeight);
+    outputTile[2] = (float)((double)tile.outW / map.outWidth);
+    outputTile[3] = (float)((double)tile.outH / map.outHeight);
+    inputTile[0] = (float)((double)tile.inX / map.width);
+    inputTile[1] = (float)((double)tile.inY / map.height);
+    inputTile[2] = (float)((double)map.width / tile.inW);
+    inputTile[3] = (float)((double)map.height / tile.inH);
+}
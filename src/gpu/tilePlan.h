@@ -0,0 +1,48 @@
+#ifndef _tileplan_h
+#define _tileplan_h
+
+#include <vector>
+
+#define GPU_TILE_SIZE 4096      // output tile edge for renders past the texture limit
+#define GPU_TILE_APRON 2        // input texels kept around a tile's footprint
+
+// How output pixels land on the input,
+// mirroring getCroppedRotatedUV in the kernel
+struct tileMapping {
+    unsigned int width = 0;         // Input
+    unsigned int height = 0;
+    unsigned int outWidth = 0;      // Output, the crop size if cropping
+    unsigned int outHeight = 0;
+    bool cropEnabled = false;
+    bool cropVisible = false;
+    float cropMin[2] = {0.0f, 0.0f};
+    float cropMax[2] = {1.0f, 1.0f};
+    float rotation = 0.0f;          // Radians
+};
+
+// One output tile and the input rectangle it samples
+struct renderTile {
+    unsigned int outX = 0;
+    unsigned int outY = 0;
+    unsigned int outW = 0;
+    unsigned int outH = 0;
+    unsigned int inX = 0;
+    unsigned int inY = 0;
+    unsigned int inW = 0;
+    unsigned int inH = 0;
+};
+
+// Output UV (0-1 over the output) to input UV, may land outside 0-1
+void mapOutputUV(const tileMapping& map, float u, float v, float& su, float& sv);
+
+// Output tiles of at most tileSize, each with an input rectangle
+// no larger than maxTexture, apron included. Empty if none fits.
+std::vector<renderTile> planRenderTiles(const tileMapping& map, unsigned int maxTexture,
+                                        unsigned int tileSize = GPU_TILE_SIZE,
+                                        unsigned int apron = GPU_TILE_APRON);
+
+// The kernel's outputTile and inputTile uniforms for a tile
+void renderTileUniforms(const tileMapping& map, const renderTile& tile,
+                        float outputTile[4], float inputTile[4]);
+
+#endif
@@ -0,0 +1,141 @@
+#include "analysisBatch.h"
+#include "image.h"
+#include "logger.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+analysisBatch::~analysisBatch() {
+    cancel();
+    wait();
+}
+
+//--- Analysis Bytes ---//
+/*
+    Matches what the buffers allocate. The tmp
+    buffer is the only addition when the image
+    is loaded, a reload also brings back the raw,
+    proc and display buffers.
+*/
+uint64_t analysisBatch::analysisBytes(const image& img) {
+    uint64_t rawPixels = (uint64_t)img.rawWidth * img.rawHeight;
+    uint64_t pixels = (uint64_t)img.width * img.height;
+    uint64_t tmpPixels = std::max({rawPixels, pixels, (uint64_t)img.rndrW * img.rndrH});
+    uint64_t bytes = tmpPixels * 4 * sizeof(float);
+    if (!img.imageLoaded) {
+        bytes += rawPixels * 4 * sizeof(float);                      // raw
+        bytes += std::max(rawPixels, pixels) * 4 * sizeof(float);    // proc
+        bytes += pixels * 4;                                         // display
+    }
+    return bytes;
+}
+
+float analysisBatch::progress() const {
+    size_t t = m_total;
+    return t == 0 ? 1.0f : (float)m_completed / (float)t;
+}
+
+//--- Start ---//
+/*
+    Order the images and hand them to the
+    scheduling thread
+*/
+bool analysisBatch::start(const std::vector<image*>& images, uint64_t ramBudget, analyseFn analyse) {
+    if (m_running)
+        return false;
+    if (m_thread.joinable())
+        m_thread.join();
+
+    std::vector<entry> order;
+    order.reserve(images.size());
+    for (image* img : images) {
+        if (img)
+            order.push_back({img, analysisBytes(*img)});
+    }
+    // Loaded images first, otherwise keep the caller's priority
+    std::stable_partition(order.begin(), order.end(),
+        [](const entry& e) { return e.img->imageLoaded; });
+
+    m_cancel = false;
+    m_total = order.size();
+    m_completed = 0;
+    m_failed = 0;
+    m_peak = 0;
+    m_running = true;
+    m_thread = std::thread(&analysisBatch::schedule, this, std::move(order),
+                           std::max<uint64_t>(ramBudget, 1), std::move(analyse));
+    return true;
+}
+
+void analysisBatch::cancel() {
+    m_cancel = true;
+    m_cv.notify_all();
+}
+
+void analysisBatch::wait() {
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+//--- Schedule ---//
+/*
+    Admit images while they fit in the budget,
+    then wait for the running ones to finish
+*/
+void analysisBatch::schedule(std::vector<entry> order, uint64_t ramBudget, analyseFn analyse) {
+    auto start = std::chrono::steady_clock::now();
+    LOG_INFO("Batch analysis: {} images, {}MB budget", order.size(), ramBudget >> 20);
+
+    for (const entry& e : order) {
+        // Anything over the whole budget runs on its own
+        uint64_t cost = std::min(e.bytes, ramBudget);
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_cv.wait(lock, [&] { return m_cancel || m_inFlight + cost <= ramBudget; });
+            if (m_cancel)
+                break;
+            m_inFlight += cost;
+            m_active++;
+            m_peak = std::max<uint64_t>(m_peak, m_inFlight);
+        }
+
+        auto job = [this, img = e.img, cost, &analyse]() {
+            // A throw (bad_alloc on a reload) counts as a failure,
+            // the bookkeeping below has to run for schedule to finish
+            bool analysed = false;
+            try {
+                analysed = analyse(img);
+            } catch (const std::exception& ex) {
+                LOG_ERROR("Batch analysis of {} threw: {}", img->srcFilename, ex.what());
+            } catch (...) {
+                LOG_ERROR("Batch analysis of {} threw", img->srcFilename);
+            }
+            if (!analysed) {
+                LOG_WARN("Batch analysis failed for {}", img->srcFilename);
+                m_failed++;
+            }
+            m_completed++;
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_inFlight -= cost;
+            m_active--;
+            m_cv.notify_all();
+        };
+        if (tPool)
+            tPool->submit(job);
+        else
+            job();
+    }
+
+    // analyse is borrowed by the jobs, so wait for every one of them
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_cv.wait(lock, [&] { return m_active == 0; });
+    }
+
+    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("Batch analysis {}: {} of {} images in {}ms, {} failed, peak {}MB",
+             m_cancel ? "cancelled" : "finished", m_completed.load(), m_total.load(),
+             dur.count(), m_failed.load(), m_peak.load() >> 20);
+    m_running = false;
+}
@@ -0,0 +1,78 @@
+#ifndef _analysisbatch_h
+#define _analysisbatch_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct image;
+
+//--- Batch Analysis ---//
+/*
+    Runs the analysis over many images on the
+    shared pool. Each image is admitted once its
+    estimated buffer bytes fit in the remaining
+    budget, so a 72 frame roll doesn't reload
+    every buffer at once. An image larger than the
+    whole budget is admitted when nothing else is
+    running.
+
+    Images that already have their buffers loaded
+    are started first. Unloaded ones follow in the
+    order they were given, and the analyse function
+    loads them when their turn comes.
+
+    Cancelling stops new images from being admitted.
+    Images already running are left to finish.
+*/
+class analysisBatch {
+    public:
+    // Returns false if the image could not be analysed
+    using analyseFn = std::function<bool(image* img)>;
+
+    analysisBatch() = default;
+    ~analysisBatch();
+
+    // False if a batch is already running
+    bool start(const std::vector<image*>& images, uint64_t ramBudget, analyseFn analyse);
+    void cancel();
+    void wait();
+
+    bool running() const { return m_running; }
+    bool cancelled() const { return m_cancel; }
+    size_t total() const { return m_total; }
+    size_t completed() const { return m_completed; }
+    size_t failed() const { return m_failed; }
+    float progress() const;
+    uint64_t peakBytes() const { return m_peak; }
+
+    // Buffer bytes the analysis adds for this image, including
+    // the reload when its buffers are not in memory
+    static uint64_t analysisBytes(const image& img);
+
+    private:
+    struct entry {
+        image* img;
+        uint64_t bytes;
+    };
+    void schedule(std::vector<entry> order, uint64_t ramBudget, analyseFn analyse);
+
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    uint64_t m_inFlight = 0;
+    size_t m_active = 0;
+
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_cancel{false};
+    std::atomic<size_t> m_total{0};
+    std::atomic<size_t> m_completed{0};
+    std::atomic<size_t> m_failed{0};
+    std::atomic<uint64_t> m_peak{0};
+};
+
+#endif
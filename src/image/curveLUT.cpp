@@ -0,0 +1,140 @@
+#include "curveLUT.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//--- Compile Curve ---//
+/*
+    Solve the spline from evalCurve once per
+    control point set. curve is interleaved x,y.
+*/
+void compileCurve(const float* curve, int n, compiledCurve& out) {
+    out = compiledCurve();
+    n = std::min(n, CURVE_MAX_PTS);
+    out.n = n;
+    if (n < 2)
+        return;
+
+    auto px = [&](int i) { return curve[i * 2];     };
+    auto py = [&](int i) { return curve[i * 2 + 1]; };
+
+    for (int i = 0; i < n; i++) {
+        out.x[i] = px(i);
+        if (i > 0 && px(i) < px(i - 1))
+            out.sorted = false;
+    }
+
+    // Extrapolation
+    out.yLo = py(0);
+    out.slopeLo = (py(1) - py(0)) / std::max(px(1) - px(0), 0.0001f);
+    out.yHi = py(n - 1);
+    out.slopeHi = (py(n-1) - py(n-2)) / std::max(px(n-1) - px(n-2), 0.0001f);
+
+    for (int seg = 0; seg < n - 1; seg++) {
+        int pprev = std::max(seg - 1, 0);
+        int pnext = std::min(seg + 2, n - 1);
+
+        float pax = px(seg),    pay = py(seg);
+        float pbx = px(seg+1),  pby = py(seg+1);
+        float* k = out.coef[seg];
+
+        float dx = pbx - pax;
+        if (dx < 0.0001f) {
+            // Degenerate segment holds its start value
+            k[0] = pay;
+            out.invDx[seg] = 0.0f;
+            continue;
+        }
+
+        // Non-uniform Catmull-Rom slopes (output / input units)
+        float dxPrev = std::max(pbx       - px(pprev), 0.0001f);
+        float dxNext = std::max(px(pnext) - pax,       0.0001f);
+        float m0 = (pby       - py(pprev)) / dxPrev;
+        float m1 = (py(pnext) - pay)       / dxNext;
+
+        // Fritsch-Carlson monotonicity: clamp slope ratio to [-3, 3]
+        float delta = (pby - pay) / dx;
+        if (std::abs(delta) < 0.0001f) {
+            m0 = 0.0f; m1 = 0.0f;
+        } else {
+            m0 = std::clamp(m0 / delta, -3.0f, 3.0f) * delta;
+            m1 = std::clamp(m1 / delta, -3.0f, 3.0f) * delta;
+        }
+
+        // Hermite basis expanded into a cubic in u
+        float t0 = dx * m0;
+        float t1 = dx * m1;
+        k[0] = pay;
+        k[1] = t0;
+        k[2] = -3.0f * pay - 2.0f * t0 + 3.0f * pby - t1;
+        k[3] =  2.0f * pay +        t0 - 2.0f * pby + t1;
+        out.invDx[seg] = 1.0f / dx;
+    }
+
+    // Starting segment for each bin. Taken one segment low
+    // so rounding at bin edges only ever needs a forward step.
+    float range = px(n - 1) - px(0);
+    if (!out.sorted || range <= 0.0f)
+        return;
+    out.binScale = CURVE_LUT_BINS / range;
+    int seg = 0;
+    for (int b = 0; b < CURVE_LUT_BINS; b++) {
+        float edge = px(0) + b / out.binScale;
+        while (seg < n - 2 && edge >= px(seg + 1))
+            seg++;
+        out.binSeg[b] = std::max(seg - 1, 0);
+    }
+}
+
+void compileCurves(const renderParams& params, curveLUTs& out) {
+    compileCurve(params.curveW, params.curveW_n, out.ch[CURVE_W]);
+    compileCurve(params.curveR, params.curveR_n, out.ch[CURVE_R]);
+    compileCurve(params.curveG, params.curveG_n, out.ch[CURVE_G]);
+    compileCurve(params.curveB, params.curveB_n, out.ch[CURVE_B]);
+}
+
+void packCurveUniforms(const curveLUTs& luts, curveUniforms& out) {
+    out = curveUniforms();
+    for (int ch = 0; ch < CURVE_COUNT; ch++) {
+        const compiledCurve& c = luts.ch[ch];
+        out.n[ch] = c.n;
+        for (int i = 0; i < CURVE_MAX_PTS; i++)
+            out.knots[i][ch] = c.x[i];
+        for (int seg = 0; seg < CURVE_MAX_SEGS; seg++) {
+            out.invDx[seg][ch] = c.invDx[seg];
+            std::memcpy(out.coef[ch * CURVE_MAX_SEGS + seg], c.coef[seg], sizeof(c.coef[seg]));
+        }
+        out.extrap[ch][0] = c.slopeLo;
+        out.extrap[ch][1] = c.slopeHi;
+        out.extrap[ch][2] = c.yLo;
+        out.extrap[ch][3] = c.yHi;
+    }
+}
+
+//--- Curve Cache Update ---//
+/*
+    Compare the active points of each curve
+    with what was compiled last time
+*/
+bool curveCache::update(const renderParams& params) {
+    const float* pts[CURVE_COUNT] = { params.curveW, params.curveR, params.curveG, params.curveB };
+    const int n[CURVE_COUNT] = { params.curveW_n, params.curveR_n, params.curveG_n, params.curveB_n };
+
+    bool changed = !m_valid;
+    for (int ch = 0; ch < CURVE_COUNT && !changed; ch++) {
+        int count = std::clamp(n[ch], 0, CURVE_MAX_PTS);
+        changed = m_n[ch] != n[ch] ||
+            std::memcmp(m_pts[ch], pts[ch], count * 2 * sizeof(float)) != 0;
+    }
+    if (!changed)
+        return false;
+
+    for (int ch = 0; ch < CURVE_COUNT; ch++) {
+        int count = std::clamp(n[ch], 0, CURVE_MAX_PTS);
+        m_n[ch] = n[ch];
+        std::memcpy(m_pts[ch], pts[ch], count * 2 * sizeof(float));
+        compileCurve(pts[ch], n[ch], m_luts.ch[ch]);
+    }
+    m_valid = true;
+    return true;
+}
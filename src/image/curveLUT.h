@@ -0,0 +1,110 @@
+#ifndef _curvelut_h
+#define _curvelut_h
+
+#include <cstdint>
+#include "renderParams.h"
+
+#define CURVE_MAX_SEGS (CURVE_MAX_PTS - 1)
+#define CURVE_LUT_BINS 64   // segment lookup bins across [px0, pxN]
+
+//--- Compiled Curve ---//
+/*
+    One tone curve reduced to a cubic per segment.
+    Each segment stores y = c0 + c1*u + c2*u^2 + c3*u^3
+    with u = (v - x[seg]) * invDx[seg], which is the
+    Hermite form of evalCurve with the Catmull-Rom /
+    Fritsch-Carlson slopes already solved. A coarse bin
+    table gives the starting segment so evaluation
+    needs no search over the control points.
+*/
+struct compiledCurve {
+    int n = 0;                          // control points, < 2 is pass-through
+    bool sorted = true;                 // bins are only valid for ascending px
+    float x[CURVE_MAX_PTS] = {};
+    float invDx[CURVE_MAX_SEGS] = {};
+    float coef[CURVE_MAX_SEGS][4] = {};
+    float slopeLo = 1.0f;               // linear extrapolation below px0
+    float slopeHi = 1.0f;               // and above pxN
+    float yLo = 0.0f;
+    float yHi = 1.0f;
+    float binScale = 0.0f;
+    uint8_t binSeg[CURVE_LUT_BINS] = {};
+};
+
+// Curves in renderParams order
+enum curveChannel {
+    CURVE_W,
+    CURVE_R,
+    CURVE_G,
+    CURVE_B,
+    CURVE_COUNT
+};
+
+struct curveLUTs {
+    compiledCurve ch[CURVE_COUNT];
+};
+
+// Compiled curves laid out as vec4 arrays for the shader,
+// with W, R, G, B in the x, y, z, w lanes
+struct curveUniforms {
+    float knots[CURVE_MAX_PTS][4];
+    float invDx[CURVE_MAX_SEGS][4];
+    float coef[CURVE_COUNT * CURVE_MAX_SEGS][4];  // [ch * CURVE_MAX_SEGS + seg]
+    float extrap[CURVE_COUNT][4];                 // slopeLo, slopeHi, yLo, yHi
+    int n[CURVE_COUNT];
+};
+
+void compileCurve(const float* curve, int n, compiledCurve& out);
+void compileCurves(const renderParams& params, curveLUTs& out);
+void packCurveUniforms(const curveLUTs& luts, curveUniforms& out);
+
+// Matches evalCurve, including extrapolation outside [px0, pxN]
+inline float evalCompiledCurve(const compiledCurve& c, float v) {
+    if (c.n < 2)
+        return v;
+    // NaN fails both range checks and would index off the bins
+    if (v != v)
+        return v;
+    if (v < c.x[0])
+        return c.yLo + c.slopeLo * (v - c.x[0]);
+    if (v > c.x[c.n - 1])
+        return c.yHi + c.slopeHi * (v - c.x[c.n - 1]);
+
+    int seg = 0;
+    if (c.sorted) {
+        int bin = (int)((v - c.x[0]) * c.binScale);
+        seg = c.binSeg[bin < CURVE_LUT_BINS ? bin : CURVE_LUT_BINS - 1];
+        while (seg < c.n - 2 && v >= c.x[seg + 1])
+            seg++;
+    } else {
+        seg = c.n - 2;
+        for (int i = 0; i < c.n - 1; i++) {
+            if (v < c.x[i + 1]) { seg = i; break; }
+        }
+    }
+
+    const float* k = c.coef[seg];
+    float u = (v - c.x[seg]) * c.invDx[seg];
+    return k[0] + u * (k[1] + u * (k[2] + u * k[3]));
+}
+
+//--- Curve Cache ---//
+/*
+    Holds the compiled curves for the last set
+    of control points seen, and only recompiles
+    when they change
+*/
+class curveCache {
+    public:
+    // Returns true when the curves had to be recompiled
+    bool update(const renderParams& params);
+    const curveLUTs& luts() const { return m_luts; }
+
+    private:
+    bool m_valid = false;
+    int m_n[CURVE_COUNT] = {};
+    float m_pts[CURVE_COUNT][CURVE_MAX_PTS * 2] = {};
+    curveLUTs m_luts;
+};
+
+#endif
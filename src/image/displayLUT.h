@@ -0,0 +1,52 @@
+#ifndef _displaylut_h
+#define _displaylut_h
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#define DISPLAY_LUT_SIZE 65         // lattice points per axis
+#define DISPLAY_LUT_LOG2_MIN -12.0f // shaper range in stops of scene linear
+#define DISPLAY_LUT_LOG2_MAX 6.0f
+
+//--- Display LUT ---//
+/*
+    A display transform baked into a 3D lattice.
+    Scene-linear input is spread over the lattice
+    by a log2 shaper, so each stop between 2^-12
+    and 2^6 gets the same number of points. Values
+    below the range land on its first point,
+    values above it on its last.
+
+    Lattice points are stored as RGBA, red
+    fastest, so each corner is one 16 byte load.
+    Lookups are tetrahedral: the cube around the
+    sample is split along its fractional ordering
+    and only four corners are blended.
+*/
+struct displayLUT {
+    int size = 0;
+    float log2Min = DISPLAY_LUT_LOG2_MIN;
+    float log2Max = DISPLAY_LUT_LOG2_MAX;
+    std::vector<float> table;
+
+    bool valid() const { return size >= 2 && table.size() == (size_t)size * size * size * 4; }
+};
+
+// Transforms count RGBA pixels in place
+using lutTransformFn = std::function<void(float* rgba, size_t count)>;
+
+// Scene linear to lattice coordinate in [0, 1], and back
+float displayLUTShaper(const displayLUT& lut, float v);
+float displayLUTUnshaper(const displayLUT& lut, float s);
+
+// Run the transform over every lattice point
+void bakeDisplayLUT(displayLUT& lut, const lutTransformFn& transform,
+                    int size = DISPLAY_LUT_SIZE,
+                    float log2Min = DISPLAY_LUT_LOG2_MIN,
+                    float log2Max = DISPLAY_LUT_LOG2_MAX);
+
+// Tetrahedral lookup of count RGBA pixels in place, alpha is kept
+void applyDisplayLUT(const displayLUT& lut, float* rgba, size_t count);
+
+#endif
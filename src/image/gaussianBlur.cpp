@@ -0,0 +1,261 @@
+#include "gaussianBlur.h"
+#include "threadPool.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//--- Recursive Gaussian Coefficients ---//
+/*
+    Young / van Vliet third order filter
+        w[n] = B*x[n] + a1*w[n-1] + a2*w[n-2] + a3*w[n-3]
+    run forwards then backwards. M maps the last
+    three forward outputs to the backward start
+    state for a signal held at its edge value
+    (Triggs / Sdika), found here by running the
+    filter rather than from the closed form.
+*/
+struct iirCoeffs {
+    double B, a1, a2, a3;
+    double M[3][3];
+};
+
+static void computeIIRCoeffs(float sigma, iirCoeffs& c) {
+    double s = sigma;
+    double q = s >= 2.5 ? 0.98711 * s - 0.96330
+                        : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * s);
+    double q2 = q * q;
+    double q3 = q2 * q;
+    double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+    double a1 = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0;
+    double a2 = -(1.4281 * q2 + 1.26661 * q3) / b0;
+    double a3 = (0.422205 * q3) / b0;
+
+    c.B = 1.0 - (a1 + a2 + a3);
+    c.a1 = a1;
+    c.a2 = a2;
+    c.a3 = a3;
+
+    // Triggs / Sdika edge matrix. Past the end the input holds its
+    // last value, so only the deviation of the causal state from it
+    // matters. Run each basis deviation out until it has decayed and
+    // back again, the first three backward outputs are its column.
+    size_t len = (size_t)std::ceil(40.0 * q) + 64;
+    std::vector<double> f(len), g(len + 3);
+    for (int k = 0; k < 3; k++) {
+        double s0 = k == 0, s1 = k == 1, s2 = k == 2;
+        for (size_t j = 0; j < len; j++) {
+            f[j] = a1 * s0 + a2 * s1 + a3 * s2;
+            s2 = s1;
+            s1 = s0;
+            s0 = f[j];
+        }
+        std::fill(g.begin(), g.end(), 0.0);
+        for (size_t j = len; j-- > 0;)
+            g[j] = c.B * f[j] + a1 * g[j + 1] + a2 * g[j + 2] + a3 * g[j + 3];
+        for (int r = 0; r < 3; r++)
+            c.M[r][k] = g[r];
+    }
+}
+
+//--- Recursive Line ---//
+/*
+    Filter n elements, inStride / outStride floats
+    apart, each made of lanes contiguous floats
+    that are filtered independently. A row is lanes = 4,
+    a block of columns is lanes = 4 * columns.
+    The state is kept in double, at large sigma
+    the poles sit close to 1 and float rounding
+    shifts flat areas by ~1e-4.
+*/
+static void iirLine(const iirCoeffs& c, const float* in, size_t inStride,
+                    float* out, size_t outStride, size_t n, size_t lanes) {
+    double state[3][BLUR_BLOCK_COLUMNS * 4];
+    double* p0 = state[0];
+    double* p1 = state[1];
+    double* p2 = state[2];
+
+    // Causal pass, the first value continues to the left
+    for (size_t l = 0; l < lanes; l++)
+        p0[l] = p1[l] = p2[l] = in[l];
+    for (size_t i = 0; i < n; i++) {
+        const float* x = in + i * inStride;
+        float* w = out + i * outStride;
+        for (size_t l = 0; l < lanes; l++) {
+            double v = c.B * x[l] + c.a1 * p0[l] + c.a2 * p1[l] + c.a3 * p2[l];
+            w[l] = v;
+            p2[l] = v;
+        }
+        std::swap(p1, p2);
+        std::swap(p0, p1);
+    }
+
+    // Anti-causal start state from the edge value
+    const float* xLast = in + (n - 1) * inStride;
+    for (size_t l = 0; l < lanes; l++) {
+        double u[3] = {p0[l] - xLast[l], p1[l] - xLast[l], p2[l] - xLast[l]};
+        double v[3];
+        for (int r = 0; r < 3; r++)
+            v[r] = c.M[r][0] * u[0] + c.M[r][1] * u[1] + c.M[r][2] * u[2] + xLast[l];
+        p0[l] = v[0];
+        p1[l] = v[1];
+        p2[l] = v[2];
+    }
+
+    // Anti-causal pass in place over the causal result
+    for (size_t i = n; i-- > 0;) {
+        float* w = out + i * outStride;
+        for (size_t l = 0; l < lanes; l++) {
+            double v = c.B * w[l] + c.a1 * p0[l] + c.a2 * p1[l] + c.a3 * p2[l];
+            w[l] = v;
+            p2[l] = v;
+        }
+        std::swap(p1, p2);
+        std::swap(p0, p1);
+    }
+}
+
+//--- Blur Plan ---//
+/*
+    Everything a pass needs for one sigma,
+    either the direct kernel or the recursive
+    filter coefficients
+*/
+struct blurPlan {
+    bool recursive = false;
+    iirCoeffs iir;
+    std::vector<float> kern;
+    int halfSize = 0;
+};
+
+static void makeBlurPlan(float sigma, bool recursive, blurPlan& plan) {
+    plan.recursive = recursive;
+    if (recursive) {
+        computeIIRCoeffs(sigma, plan.iir);
+        return;
+    }
+    int kernelSize = (int)(sigma * KERNELSIZE) + 1;
+    kernelSize = kernelSize % 2 == 0 ? kernelSize + 1 : kernelSize;
+    plan.halfSize = kernelSize / 2;
+    plan.kern.resize(kernelSize);
+    computeKernels(sigma, plan.kern.data());
+}
+
+//--- Blur Rows ---//
+/*
+    Horizontal pass of the whole image into tmp
+*/
+static void blurRows(const blurPlan& plan, const float* src, float* tmp, int width, int height) {
+    size_t rowLen = (size_t)width * 4;
+    parallelFor(0, height, parallelGrain(height), [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; y++) {
+            const float* row = src + y * rowLen;
+            float* out = tmp + y * rowLen;
+            if (plan.recursive) {
+                iirLine(plan.iir, row, 4, out, 4, width, 4);
+                continue;
+            }
+            for (int x = 0; x < width; x++) {
+                float outPix[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                for (int i = -plan.halfSize; i <= plan.halfSize; i++) {
+                    int sx = std::clamp(x + i, 0, width - 1);
+                    float w = plan.kern[i + plan.halfSize];
+                    for (int ch = 0; ch < 4; ch++)
+                        outPix[ch] += w * row[sx * 4 + ch];
+                }
+                std::copy_n(outPix, 4, out + x * 4);
+            }
+        }
+    });
+}
+
+//--- Blur Columns ---//
+/*
+    Vertical pass over columns [x0, x0 + cols) of
+    tmp, rows written outStride floats apart. The
+    direct kernel accumulates whole row segments
+    so both paths read memory in order.
+*/
+static void blurColumns(const blurPlan& plan, const float* tmp, int width, int height,
+                        size_t x0, size_t cols, float* out, size_t outStride) {
+    size_t rowLen = (size_t)width * 4;
+    size_t lanes = cols * 4;
+    const float* in = tmp + x0 * 4;
+    if (plan.recursive) {
+        iirLine(plan.iir, in, rowLen, out, outStride, height, lanes);
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        float* dst = out + y * outStride;
+        std::fill_n(dst, lanes, 0.0f);
+        for (int i = -plan.halfSize; i <= plan.halfSize; i++) {
+            int sy = std::clamp(y + i, 0, height - 1);
+            float w = plan.kern[i + plan.halfSize];
+            const float* row = in + sy * rowLen;
+            for (size_t j = 0; j < lanes; j++)
+                dst[j] += w * row[j];
+        }
+    }
+}
+
+static size_t blurBlockCount(int width) {
+    return (width + BLUR_BLOCK_COLUMNS - 1) / BLUR_BLOCK_COLUMNS;
+}
+
+static void blurFull(const blurPlan& plan, const float* src, float* tmp, float* dst, int width, int height) {
+    if (!src || !tmp || !dst || width < 1 || height < 1)
+        return;
+    blurRows(plan, src, tmp, width, height);
+    size_t rowLen = (size_t)width * 4;
+    parallelFor(0, blurBlockCount(width), 1, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; b++) {
+            size_t x0 = b * BLUR_BLOCK_COLUMNS;
+            size_t cols = std::min<size_t>(BLUR_BLOCK_COLUMNS, width - x0);
+            blurColumns(plan, tmp, width, height, x0, cols, dst + x0 * 4, rowLen);
+        }
+    });
+}
+
+void gaussianBlurDirect(const float* src, float* tmp, float* dst, int width, int height, float sigma) {
+    blurPlan plan;
+    makeBlurPlan(sigma, false, plan);
+    blurFull(plan, src, tmp, dst, width, height);
+}
+
+void gaussianBlurIIR(const float* src, float* tmp, float* dst, int width, int height, float sigma) {
+    blurPlan plan;
+    makeBlurPlan(sigma, true, plan);
+    blurFull(plan, src, tmp, dst, width, height);
+}
+
+void gaussianBlur(const float* src, float* tmp, float* dst, int width, int height, float sigma) {
+    blurPlan plan;
+    makeBlurPlan(sigma, sigma >= BLUR_IIR_MIN_SIGMA, plan);
+    blurFull(plan, src, tmp, dst, width, height);
+}
+
+//--- Streaming Blur ---//
+/*
+    Each worker blurs its column blocks into a
+    strip of its own and hands it to the sink,
+    so only tmp is ever full size
+*/
+void gaussianBlurBlocks(const float* src, float* tmp, int width, int height, float sigma,
+                        const blurBlockFn& sink) {
+    if (!src || !tmp || width < 1 || height < 1)
+        return;
+    blurPlan plan;
+    makeBlurPlan(sigma, sigma >= BLUR_IIR_MIN_SIGMA, plan);
+    blurRows(plan, src, tmp, width, height);
+
+    size_t blocks = blurBlockCount(width);
+    parallelFor(0, blocks, 1, [&](size_t b0, size_t b1) {
+        std::vector<float> strip((size_t)height * BLUR_BLOCK_COLUMNS * 4);
+        for (size_t b = b0; b < b1; b++) {
+            size_t x0 = b * BLUR_BLOCK_COLUMNS;
+            size_t cols = std::min<size_t>(BLUR_BLOCK_COLUMNS, width - x0);
+            blurColumns(plan, tmp, width, height, x0, cols, strip.data(), cols * 4);
+            sink(b, strip.data(), cols * 4, x0, x0 + cols);
+        }
+    });
+}
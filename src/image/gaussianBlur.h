@@ -0,0 +1,46 @@
+#ifndef _gaussianblur_h
+#define _gaussianblur_h
+
+#include <cstddef>
+#include <functional>
+
+#define BLUR_IIR_MIN_SIGMA 3.0f     // below this the direct kernel is cheap and more accurate
+#define BLUR_BLOCK_COLUMNS 64       // columns filtered together in the vertical pass
+
+//--- Gaussian Blur ---//
+/*
+    Blur an RGBA float image with clamp-to-edge borders.
+    src and dst are width*height*4 floats, tmp holds the
+    horizontal pass and must be the same size. dst may not
+    alias src or tmp.
+
+    gaussianBlurDirect is the separable kernel from
+    computeKernels, truncated at KERNELSIZE/2 sigma.
+    Its cost grows with sigma.
+
+    gaussianBlurIIR is the Young / van Vliet recursive
+    Gaussian with Triggs / Sdika edge handling. It costs
+    the same per pixel at any sigma.
+
+    Both run the vertical pass over blocks of
+    BLUR_BLOCK_COLUMNS columns a row at a time, so memory
+    is read in order rather than down the columns.
+
+    gaussianBlur picks between them on sigma.
+*/
+void gaussianBlurDirect(const float* src, float* tmp, float* dst, int width, int height, float sigma);
+void gaussianBlurIIR(const float* src, float* tmp, float* dst, int width, int height, float sigma);
+void gaussianBlur(const float* src, float* tmp, float* dst, int width, int height, float sigma);
+
+// Receives block index, then every row of columns [x0, x1)
+// with rows stride floats apart. Called from pool threads,
+// the strip is only valid for the duration of the call.
+using blurBlockFn = std::function<void(size_t block, const float* strip, size_t stride, size_t x0, size_t x1)>;
+
+// Same blur as gaussianBlur, but the result is handed over a
+// column block at a time instead of being stored. Blocks are
+// numbered left to right, there are ceil(width / BLUR_BLOCK_COLUMNS).
+void gaussianBlurBlocks(const float* src, float* tmp, int width, int height, float sigma,
+                        const blurBlockFn& sink);
+
+#endif
@@ -0,0 +1,194 @@
+#include "gradeKernel.h"
+#include "logger.h"
+
+#if defined(GRADE_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//--- Make Grade Constants ---//
+/*
+    Fold the per-pixel constant part of the
+    grade into gradeConsts. Mirrors the scalar
+    math in gradePixelsCPU.
+*/
+void makeGradeConsts(const renderParams& params, gradeConsts& consts) {
+    const float warm[3] = {2.0f, 1.0f, 0.0f};
+    const float cool[3] = {0.0f, 1.0f, 2.0f};
+    const float green[3] = {0.0f, 1.5f, 0.0f};
+    const float mag[3] = {1.5f, 0.0f, 1.5f};
+    float temp = -1.0f * params.temp;
+    float tint = 0.75f * params.tint;
+
+    for (int ch = 0; ch < 3; ch++) {
+        float invRange = 1.0f / (params.whitePoint[ch] - params.blackPoint[ch]);
+        consts.baseScale[ch] = params.baseColor[ch] * 0.1f * invRange;
+        consts.baseOffset[ch] = -params.blackPoint[ch] * invRange;
+
+        // WB and tint reduce to a per-channel multiplier
+        float wb = temp >= 0.0f ?
+            cool[ch] * temp + (1.0f - temp) :
+            warm[ch] * -temp + (1.0f + temp);
+        float tn = tint >= 0.0f ?
+            mag[ch] * tint + (1.0f - tint) :
+            green[ch] * -tint + (1.0f + tint);
+
+        float invGrade = 1.0f / (params.G_whitepoint[ch] - params.G_blackpoint[ch]);
+        consts.gradeScale[ch] = wb * tn * invGrade;
+        consts.gradeOffset[ch] = -params.G_blackpoint[ch] * invGrade;
+
+        consts.aGrade[ch] = params.G_mult[ch] * (params.G_gain[ch] - params.G_lift[ch]);
+        consts.bGrade[ch] = params.G_offset[ch] + params.G_lift[ch];
+        consts.invGamma[ch] = 1.0f / params.G_gamma[ch];
+    }
+    for (int i = 0; i < 3; i++) {
+        consts.matrix[0 + i] = params.G_matrixR[i];
+        consts.matrix[3 + i] = params.G_matrixG[i];
+        consts.matrix[6 + i] = params.G_matrixB[i];
+    }
+    consts.saturation = params.saturation + 1.0f;
+    consts.bypass = params.bypass == 1;
+    consts.gradeBypass = params.gradeBypass == 1;
+}
+
+//--- NEON Grade Kernel ---//
+/*
+    4 pixels per iteration. NEON is part of the
+    baseline on arm64 so no dispatch is needed.
+*/
+#if defined(GRADE_NEON)
+#include <arm_neon.h>
+#include "gradeKernelImpl.h"
+
+namespace {
+struct vNEON {
+    using f = float32x4_t;
+    using i = int32x4_t;
+    using m = uint32x4_t;
+    static constexpr int width = 4;
+
+    static f set1(float v) { return vdupq_n_f32(v); }
+    static i seti(int v) { return vdupq_n_s32(v); }
+    static f load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, f v) { vst1q_f32(p, v); }
+    static f add(f a, f b) { return vaddq_f32(a, b); }
+    static f sub(f a, f b) { return vsubq_f32(a, b); }
+    static f mul(f a, f b) { return vmulq_f32(a, b); }
+    static f div(f a, f b) { return vdivq_f32(a, b); }
+    static f min(f a, f b) { return vminq_f32(a, b); }
+    static f max(f a, f b) { return vmaxq_f32(a, b); }
+    static f fma(f a, f b, f c) { return vfmaq_f32(c, a, b); }
+    static m le(f a, f b) { return vcleq_f32(a, b); }
+    static m gt(f a, f b) { return vcgtq_f32(a, b); }
+    static f select(m k, f a, f b) { return vbslq_f32(k, a, b); }
+    static f floor(f a) { return vrndmq_f32(a); }
+    static i toInt(f a) { return vcvtq_s32_f32(a); }
+    static f toFloat(i a) { return vcvtq_f32_s32(a); }
+    static i asInt(f a) { return vreinterpretq_s32_f32(a); }
+    static f asFloat(i a) { return vreinterpretq_f32_s32(a); }
+    static i addi(i a, i b) { return vaddq_s32(a, b); }
+    static i subi(i a, i b) { return vsubq_s32(a, b); }
+    static i andi(i a, i b) { return vandq_s32(a, b); }
+    static i ori(i a, i b) { return vorrq_s32(a, b); }
+    static i shr23(i a) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), 23)); }
+    static i shl23(i a) { return vshlq_n_s32(a, 23); }
+};
+} // namespace
+#endif
+
+//--- Detect Grade ISA ---//
+/*
+    Ask the CPU (and OS, for the wider register
+    state) which vector instruction set we can use
+*/
+gradeIsa detectGradeIsa() {
+#if defined(GRADE_NEON)
+    return GRADE_ISA_NEON;
+#elif defined(GRADE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = info[2] & (1 << 19);
+    bool fma = info[2] & (1 << 12);
+    bool osxsave = info[2] & (1 << 27);
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool ymmState = (xcr0 & 0x6) == 0x6;
+    bool zmmState = (xcr0 & 0xe6) == 0xe6;
+    bool avx2 = false, avx512 = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = info[1] & (1 << 5);
+        avx512 = info[1] & (1 << 16);
+    }
+    if (avx512 && zmmState)
+        return GRADE_ISA_AVX512;
+    if (avx2 && fma && ymmState)
+        return GRADE_ISA_AVX2;
+    if (sse41)
+        return GRADE_ISA_SSE4;
+    return GRADE_ISA_SCALAR;
+#elif defined(GRADE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return GRADE_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return GRADE_ISA_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return GRADE_ISA_SSE4;
+    return GRADE_ISA_SCALAR;
+#else
+    return GRADE_ISA_SCALAR;
+#endif
+}
+
+gradeKernelFn gradeKernel(gradeIsa isa) {
+    switch (isa) {
+        case GRADE_ISA_SSE4: return gradeKernelSSE4();
+        case GRADE_ISA_AVX2: return gradeKernelAVX2();
+        case GRADE_ISA_AVX512: return gradeKernelAVX512();
+#if defined(GRADE_NEON)
+        case GRADE_ISA_NEON: return &gradeSpan<vNEON>;
+#endif
+        default: return nullptr;
+    }
+}
+
+const char* gradeIsaName(gradeIsa isa) {
+    switch (isa) {
+        case GRADE_ISA_SSE4: return "SSE4.1";
+        case GRADE_ISA_AVX2: return "AVX2";
+        case GRADE_ISA_AVX512: return "AVX-512";
+        case GRADE_ISA_NEON: return "NEON";
+        default: return "scalar";
+    }
+}
+
+//--- Active Grade ISA ---//
+/*
+    Pick the widest kernel that is both supported
+    by this CPU and was built into the binary,
+    stepping down if a wider one was compiled out
+*/
+gradeIsa activeGradeIsa() {
+    static const gradeIsa active = []() -> gradeIsa {
+        int isa = detectGradeIsa();
+        if (isa == GRADE_ISA_NEON) {
+            LOG_INFO("CPU grade kernel: {}", gradeIsaName(GRADE_ISA_NEON));
+            return GRADE_ISA_NEON;
+        }
+        for (; isa > GRADE_ISA_SCALAR; isa--) {
+            if (gradeKernel((gradeIsa)isa)) {
+                LOG_INFO("CPU grade kernel: {}", gradeIsaName((gradeIsa)isa));
+                return (gradeIsa)isa;
+            }
+        }
+        LOG_INFO("CPU grade kernel: {}", gradeIsaName(GRADE_ISA_SCALAR));
+        return GRADE_ISA_SCALAR;
+    }();
+    return active;
+}
+
+gradeKernelFn activeGradeKernel() {
+    static const gradeKernelFn kernel = gradeKernel(activeGradeIsa());
+    return kernel;
+}
@@ -0,0 +1,65 @@
+#ifndef _gradekernel_h
+#define _gradekernel_h
+
+#include <cstddef>
+#include "renderParams.h"
+
+// Target architecture for the SIMD grade kernels
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+#define GRADE_X86 1
+#elif defined(__aarch64__) || defined(__arm64__) || defined(_M_ARM64)
+#define GRADE_NEON 1
+#endif
+
+enum gradeIsa {
+    GRADE_ISA_SCALAR,
+    GRADE_ISA_SSE4,
+    GRADE_ISA_AVX2,
+    GRADE_ISA_AVX512,
+    GRADE_ISA_NEON,
+    GRADE_ISA_COUNT
+};
+
+//--- Grade Constants ---//
+/*
+    renderParams folded down to the per-channel
+    constants the vector kernels need. The chain of
+    base divide, black/white point, temp/tint and
+    grade black/white point collapses into two
+    multiply-adds per channel.
+*/
+struct gradeConsts {
+    float baseScale[3];     // base * 0.1 / (wp - bp)
+    float baseOffset[3];    // -bp / (wp - bp)
+    float gradeScale[3];    // temp/tint / (gwp - gbp)
+    float gradeOffset[3];   // -gbp / (gwp - gbp)
+    float matrix[9];        // row-major R, G, B
+    float aGrade[3];
+    float bGrade[3];
+    float invGamma[3];
+    float saturation;       // saturation + 1
+    int bypass;
+    int gradeBypass;
+};
+
+void makeGradeConsts(const renderParams& params, gradeConsts& consts);
+
+// Grade count RGBA pixels from in to out, alpha is written as 1
+using gradeKernelFn = void (*)(const gradeConsts& consts, const float* in, float* out, size_t count);
+
+// Best instruction set the running CPU supports
+gradeIsa detectGradeIsa();
+// Kernel for an instruction set, nullptr if it was not built or is scalar
+gradeKernelFn gradeKernel(gradeIsa isa);
+// Instruction set picked once for this machine
+gradeIsa activeGradeIsa();
+// Kernel for activeGradeIsa, nullptr to use the scalar path
+gradeKernelFn activeGradeKernel();
+const char* gradeIsaName(gradeIsa isa);
+
+// Per-ISA entry points, each built in its own translation unit
+gradeKernelFn gradeKernelSSE4();
+gradeKernelFn gradeKernelAVX2();
+gradeKernelFn gradeKernelAVX512();
+
+#endif
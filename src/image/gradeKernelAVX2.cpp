@@ -0,0 +1,51 @@
+#include "gradeKernel.h"
+
+//--- AVX2 Grade Kernel ---//
+/*
+    8 pixels per iteration with FMA. Built with
+    -mavx2 -mfma (/arch:AVX2), returns nullptr when
+    the compiler was not given the instruction set.
+*/
+#if defined(GRADE_X86) && defined(__AVX2__)
+#include <immintrin.h>
+#include "gradeKernelImpl.h"
+
+namespace {
+struct vAVX2 {
+    using f = __m256;
+    using i = __m256i;
+    using m = __m256;
+    static constexpr int width = 8;
+
+    static f set1(float v) { return _mm256_set1_ps(v); }
+    static i seti(int v) { return _mm256_set1_epi32(v); }
+    static f load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, f v) { _mm256_storeu_ps(p, v); }
+    static f add(f a, f b) { return _mm256_add_ps(a, b); }
+    static f sub(f a, f b) { return _mm256_sub_ps(a, b); }
+    static f mul(f a, f b) { return _mm256_mul_ps(a, b); }
+    static f div(f a, f b) { return _mm256_div_ps(a, b); }
+    static f min(f a, f b) { return _mm256_min_ps(a, b); }
+    static f max(f a, f b) { return _mm256_max_ps(a, b); }
+    static f fma(f a, f b, f c) { return _mm256_fmadd_ps(a, b, c); }
+    static m le(f a, f b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static m gt(f a, f b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static f select(m k, f a, f b) { return _mm256_blendv_ps(b, a, k); }
+    static f floor(f a) { return _mm256_floor_ps(a); }
+    static i toInt(f a) { return _mm256_cvttps_epi32(a); }
+    static f toFloat(i a) { return _mm256_cvtepi32_ps(a); }
+    static i asInt(f a) { return _mm256_castps_si256(a); }
+    static f asFloat(i a) { return _mm256_castsi256_ps(a); }
+    static i addi(i a, i b) { return _mm256_add_epi32(a, b); }
+    static i subi(i a, i b) { return _mm256_sub_epi32(a, b); }
+    static i andi(i a, i b) { return _mm256_and_si256(a, b); }
+    static i ori(i a, i b) { return _mm256_or_si256(a, b); }
+    static i shr23(i a) { return _mm256_srli_epi32(a, 23); }
+    static i shl23(i a) { return _mm256_slli_epi32(a, 23); }
+};
+} // namespace
+
+gradeKernelFn gradeKernelAVX2() { return &gradeSpan<vAVX2>; }
+#else
+gradeKernelFn gradeKernelAVX2() { return nullptr; }
+#endif
@@ -0,0 +1,51 @@
+#include "gradeKernel.h"
+
+//--- AVX-512 Grade Kernel ---//
+/*
+    16 pixels per iteration. Built with -mavx512f
+    (/arch:AVX512), returns nullptr when the compiler
+    was not given the instruction set.
+*/
+#if defined(GRADE_X86) && defined(__AVX512F__)
+#include <immintrin.h>
+#include "gradeKernelImpl.h"
+
+namespace {
+struct vAVX512 {
+    using f = __m512;
+    using i = __m512i;
+    using m = __mmask16;
+    static constexpr int width = 16;
+
+    static f set1(float v) { return _mm512_set1_ps(v); }
+    static i seti(int v) { return _mm512_set1_epi32(v); }
+    static f load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, f v) { _mm512_storeu_ps(p, v); }
+    static f add(f a, f b) { return _mm512_add_ps(a, b); }
+    static f sub(f a, f b) { return _mm512_sub_ps(a, b); }
+    static f mul(f a, f b) { return _mm512_mul_ps(a, b); }
+    static f div(f a, f b) { return _mm512_div_ps(a, b); }
+    static f min(f a, f b) { return _mm512_min_ps(a, b); }
+    static f max(f a, f b) { return _mm512_max_ps(a, b); }
+    static f fma(f a, f b, f c) { return _mm512_fmadd_ps(a, b, c); }
+    static m le(f a, f b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static m gt(f a, f b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static f select(m k, f a, f b) { return _mm512_mask_blend_ps(k, b, a); }
+    static f floor(f a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static i toInt(f a) { return _mm512_cvttps_epi32(a); }
+    static f toFloat(i a) { return _mm512_cvtepi32_ps(a); }
+    static i asInt(f a) { return _mm512_castps_si512(a); }
+    static f asFloat(i a) { return _mm512_castsi512_ps(a); }
+    static i addi(i a, i b) { return _mm512_add_epi32(a, b); }
+    static i subi(i a, i b) { return _mm512_sub_epi32(a, b); }
+    static i andi(i a, i b) { return _mm512_and_si512(a, b); }
+    static i ori(i a, i b) { return _mm512_or_si512(a, b); }
+    static i shr23(i a) { return _mm512_srli_epi32(a, 23); }
+    static i shl23(i a) { return _mm512_slli_epi32(a, 23); }
+};
+} // namespace
+
+gradeKernelFn gradeKernelAVX512() { return &gradeSpan<vAVX512>; }
+#else
+gradeKernelFn gradeKernelAVX512() { return nullptr; }
+#endif
@@ -0,0 +1,184 @@
+#ifndef _gradekernelimpl_h
+#define _gradekernelimpl_h
+
+#include "gradeKernel.h"
+
+//--- Vector Grade Kernel ---//
+/*
+    Shared body of the SIMD grade kernels. Each ISA
+    translation unit defines a vector wrapper V and
+    instantiates gradeSpan<V>. Only included from those
+    files, everything here has internal linkage so code
+    built with wider instruction sets can never be picked
+    by the linker for another translation unit. For the
+    same reason nothing from the standard library is used.
+
+    V provides:
+        f, i, m             float, int and mask vector types
+        width               lanes per vector
+        set1, seti          broadcast float / int
+        load, store         unaligned float access
+        add, sub, mul, div, min, max, fma(a, b, c) = a * b + c
+        le, gt              compare to mask
+        select(m, a, b)     m ? a : b
+        floor, toInt, toFloat, asInt, asFloat
+        addi, subi, andi, ori, shr23, shl23
+*/
+namespace {
+
+// JPLog constants, matching the scalar path
+constexpr float kLinBreak = 0.006801176276f;
+constexpr float kLogBreak = 0.16129032258064516129f;
+constexpr float kLinToLogSlope = 10.36773919972907075549f;
+constexpr float kLinToLogYInt = 0.09077750069969257965f;
+
+// log2 for x > 0
+// Mantissa is reduced to [sqrt(.5), sqrt(2)) and log2 evaluated
+// through atanh, max error around 1e-7
+template<class V>
+inline typename V::f vLog2(typename V::f x) {
+    using f = typename V::f;
+    using i = typename V::i;
+    const f one = V::set1(1.0f);
+
+    i bits = V::asInt(x);
+    i expo = V::subi(V::shr23(bits), V::seti(127));
+    f mant = V::asFloat(V::ori(V::andi(bits, V::seti(0x007fffff)), V::seti(0x3f800000)));
+
+    auto big = V::gt(mant, V::set1(1.41421356f));
+    mant = V::select(big, V::mul(mant, V::set1(0.5f)), mant);
+    f e = V::add(V::toFloat(expo), V::select(big, one, V::set1(0.0f)));
+
+    f t = V::div(V::sub(mant, one), V::add(mant, one));
+    f t2 = V::mul(t, t);
+    f p = V::fma(t2, V::set1(1.0f / 9.0f), V::set1(1.0f / 7.0f));
+    p = V::fma(p, t2, V::set1(1.0f / 5.0f));
+    p = V::fma(p, t2, V::set1(1.0f / 3.0f));
+    p = V::fma(p, t2, one);
+    p = V::mul(p, V::mul(t, V::set1(2.88539008f))); // 2 / ln(2)
+    return V::add(e, p);
+}
+
+// 2^y, overflows to inf like powf
+template<class V>
+inline typename V::f vExp2(typename V::f y) {
+    using f = typename V::f;
+    using i = typename V::i;
+    const f one = V::set1(1.0f);
+
+    f yc = V::min(V::max(y, V::set1(-126.0f)), V::set1(127.0f));
+    f k = V::floor(V::add(yc, V::set1(0.5f)));
+    f r = V::mul(V::sub(yc, k), V::set1(0.69314718f));
+
+    // e^r for |r| <= ln(2) / 2
+    f p = V::fma(r, V::set1(1.0f / 720.0f), V::set1(1.0f / 120.0f));
+    p = V::fma(p, r, V::set1(1.0f / 24.0f));
+    p = V::fma(p, r, V::set1(1.0f / 6.0f));
+    p = V::fma(p, r, V::set1(0.5f));
+    p = V::fma(p, r, one);
+    p = V::fma(p, r, one);
+
+    i scale = V::shl23(V::addi(V::toInt(k), V::seti(127)));
+    f res = V::mul(p, V::asFloat(scale));
+    return V::select(V::gt(y, V::set1(128.0f)), V::asFloat(V::seti(0x7f800000)), res);
+}
+
+template<class V>
+inline typename V::f vLinToJPLog(typename V::f x) {
+    auto lin = V::fma(x, V::set1(kLinToLogSlope), V::set1(kLinToLogYInt));
+    auto lg = V::mul(V::add(vLog2<V>(x), V::set1(10.5f)), V::set1(1.0f / 20.46f));
+    return V::select(V::le(x, V::set1(kLinBreak)), lin, lg);
+}
+
+template<class V>
+inline typename V::f vJPLogToLin(typename V::f x) {
+    auto lin = V::mul(V::sub(x, V::set1(kLinToLogYInt)), V::set1(1.0f / kLinToLogSlope));
+    auto ex = vExp2<V>(V::fma(x, V::set1(20.46f), V::set1(-10.5f)));
+    return V::select(V::le(x, V::set1(kLogBreak)), lin, ex);
+}
+
+template<class V>
+void gradeSpan(const gradeConsts& c, const float* in, float* out, size_t count) {
+    using f = typename V::f;
+    constexpr int W = V::width;
+    alignas(64) float rgb[3][W];
+
+    if (c.bypass) {
+        for (size_t p = 0; p < count; p++) {
+            out[p * 4 + 0] = in[p * 4 + 0];
+            out[p * 4 + 1] = in[p * 4 + 1];
+            out[p * 4 + 2] = in[p * 4 + 2];
+            out[p * 4 + 3] = 1.0f;
+        }
+        return;
+    }
+
+    const f minPix = V::set1(0.0001f);
+    const f one = V::set1(1.0f);
+    const f zero = V::set1(0.0f);
+    const f hundred = V::set1(100.0f);
+
+    for (size_t p0 = 0; p0 < count; p0 += W) {
+        size_t n = count - p0 < (size_t)W ? count - p0 : (size_t)W;
+
+        // Deinterleave, padding the tail with a safe value
+        for (size_t l = 0; l < (size_t)W; l++) {
+            const float* px = in + (p0 + (l < n ? l : 0)) * 4;
+            rgb[0][l] = px[0];
+            rgb[1][l] = px[1];
+            rgb[2][l] = px[2];
+        }
+
+        f v[3];
+        for (int ch = 0; ch < 3; ch++) {
+            // Base color divide and black/white point
+            f inv = V::div(one, V::max(V::load(rgb[ch]), minPix));
+            v[ch] = V::fma(inv, V::set1(c.baseScale[ch]), V::set1(c.baseOffset[ch]));
+        }
+
+        if (!c.gradeBypass) {
+            // Temp/tint and grade black/white point
+            f t[3];
+            for (int ch = 0; ch < 3; ch++)
+                t[ch] = V::fma(v[ch], V::set1(c.gradeScale[ch]), V::set1(c.gradeOffset[ch]));
+
+            // Color matrix, then into log for grading
+            for (int ch = 0; ch < 3; ch++) {
+                f m = V::mul(t[0], V::set1(c.matrix[ch * 3 + 0]));
+                m = V::fma(t[1], V::set1(c.matrix[ch * 3 + 1]), m);
+                m = V::fma(t[2], V::set1(c.matrix[ch * 3 + 2]), m);
+                v[ch] = vLinToJPLog<V>(m);
+            }
+
+            // Lift/gain/gamma, clamp and back to lin
+            for (int ch = 0; ch < 3; ch++) {
+                f base = V::fma(V::set1(c.aGrade[ch]), v[ch], V::set1(c.bGrade[ch]));
+                base = V::max(base, minPix);
+                f g = vExp2<V>(V::mul(vLog2<V>(base), V::set1(c.invGamma[ch])));
+                g = V::min(V::max(g, zero), hundred);
+                v[ch] = vJPLogToLin<V>(g);
+            }
+
+            // Saturation
+            f l = V::mul(v[0], V::set1(0.2722287168f));
+            l = V::fma(v[1], V::set1(0.6740817658f), l);
+            l = V::fma(v[2], V::set1(0.0536895174f), l);
+            for (int ch = 0; ch < 3; ch++)
+                v[ch] = V::fma(V::set1(c.saturation), V::sub(v[ch], l), l);
+        }
+
+        for (int ch = 0; ch < 3; ch++)
+            V::store(rgb[ch], v[ch]);
+        for (size_t l = 0; l < n; l++) {
+            float* px = out + (p0 + l) * 4;
+            px[0] = rgb[0][l];
+            px[1] = rgb[1][l];
+            px[2] = rgb[2][l];
+            px[3] = 1.0f;
+        }
+    }
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,51 @@
+#include "gradeKernel.h"
+
+//--- SSE4.1 Grade Kernel ---//
+/*
+    4 pixels per iteration. Built with -msse4.1,
+    returns nullptr when the compiler was not
+    given the instruction set.
+*/
+#if defined(GRADE_X86) && (defined(__SSE4_1__) || defined(_MSC_VER))
+#include <smmintrin.h>
+#include "gradeKernelImpl.h"
+
+namespace {
+struct vSSE4 {
+    using f = __m128;
+    using i = __m128i;
+    using m = __m128;
+    static constexpr int width = 4;
+
+    static f set1(float v) { return _mm_set1_ps(v); }
+    static i seti(int v) { return _mm_set1_epi32(v); }
+    static f load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, f v) { _mm_storeu_ps(p, v); }
+    static f add(f a, f b) { return _mm_add_ps(a, b); }
+    static f sub(f a, f b) { return _mm_sub_ps(a, b); }
+    static f mul(f a, f b) { return _mm_mul_ps(a, b); }
+    static f div(f a, f b) { return _mm_div_ps(a, b); }
+    static f min(f a, f b) { return _mm_min_ps(a, b); }
+    static f max(f a, f b) { return _mm_max_ps(a, b); }
+    static f fma(f a, f b, f c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static m le(f a, f b) { return _mm_cmple_ps(a, b); }
+    static m gt(f a, f b) { return _mm_cmpgt_ps(a, b); }
+    static f select(m k, f a, f b) { return _mm_blendv_ps(b, a, k); }
+    static f floor(f a) { return _mm_floor_ps(a); }
+    static i toInt(f a) { return _mm_cvttps_epi32(a); }
+    static f toFloat(i a) { return _mm_cvtepi32_ps(a); }
+    static i asInt(f a) { return _mm_castps_si128(a); }
+    static f asFloat(i a) { return _mm_castsi128_ps(a); }
+    static i addi(i a, i b) { return _mm_add_epi32(a, b); }
+    static i subi(i a, i b) { return _mm_sub_epi32(a, b); }
+    static i andi(i a, i b) { return _mm_and_si128(a, b); }
+    static i ori(i a, i b) { return _mm_or_si128(a, b); }
+    static i shr23(i a) { return _mm_srli_epi32(a, 23); }
+    static i shl23(i a) { return _mm_slli_epi32(a, 23); }
+};
+} // namespace
+
+gradeKernelFn gradeKernelSSE4() { return &gradeSpan<vSSE4>; }
+#else
+gradeKernelFn gradeKernelSSE4() { return nullptr; }
+#endif
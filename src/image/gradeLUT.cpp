@@ -0,0 +1,271 @@
+#include "gradeLUT.h"
+#include "image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+// Table domains
+#define GRADE_LUT_LIN_MIN -0.5f
+#define GRADE_LUT_LOG_MIN_EXP -14    // 2^-14
+#define GRADE_LUT_LOG_MAX_EXP 24     // 2^24
+
+static const float kLogMin = std::ldexp(1.0f, GRADE_LUT_LOG_MIN_EXP);
+static const float kLogMax = std::ldexp(1.0f, GRADE_LUT_LOG_MAX_EXP);
+
+static inline uint32_t floatBits(float v) {
+    uint32_t b;
+    std::memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+static inline float bitsFloat(uint32_t b) {
+    float v;
+    std::memcpy(&v, &b, sizeof(v));
+    return v;
+}
+
+//--- Eval Grade Post ---//
+/*
+    Positive values index the log table by their
+    exponent and top mantissa bits, the remaining
+    mantissa bits are the interpolation weight
+*/
+float evalGradePost(const bakedGrade& bake, int ch, float v) {
+    const bakedGradeChannel& c = bake.ch[ch];
+    float r = NAN;
+    if (v >= kLogMin && v < kLogMax) {
+        uint32_t shift = 23 - bake.bits;
+        uint32_t rel = floatBits(v) - floatBits(kLogMin);
+        const float* cell = &c.logCells[(rel >> shift) * 2];
+        float t = (rel & ((1u << shift) - 1)) * (1.0f / (1u << shift));
+        r = cell[0] + t * cell[1];
+    } else if (v >= GRADE_LUT_LIN_MIN && v < kLogMin) {
+        float pos = (v - GRADE_LUT_LIN_MIN) * bake.linScale;
+        size_t i = std::min<size_t>(pos, c.linCells.size() / 2 - 1);
+        r = c.linCells[i * 2] + (pos - i) * c.linCells[i * 2 + 1];
+    }
+    // Outside the tables, or a cell left to the exact path
+    if (std::isnan(r))
+        return gradePostCPU(v, c.aGrade, c.bGrade, c.gamma);
+    return r;
+}
+
+// Error of a table result against the exact value
+static float relError(float approx, float exact) {
+    return std::abs(approx - exact) / std::max(std::abs(exact), 1e-3f);
+}
+
+//--- Bake Table ---//
+/*
+    Fill cells from the exact function at their
+    edges, then probe each one inside. Cells that
+    miss maxError are handed to the exact path.
+    Returns the number of those, worst tracks the
+    largest error of the cells that were kept.
+*/
+template<class Edge>
+static int bakeTable(std::vector<float>& cells, size_t count, Edge edge,
+                     const std::function<float(float)>& exact, float maxError, float& worst) {
+    cells.resize(count * 2);
+    float lo = edge(0);
+    float yLo = exact(lo);
+    int rejected = 0;
+    for (size_t i = 0; i < count; i++) {
+        float hi = edge(i + 1);
+        float yHi = exact(hi);
+        float* cell = &cells[i * 2];
+        cell[0] = yLo;
+        cell[1] = yHi - yLo;
+
+        if (!std::isfinite(yLo) || !std::isfinite(yHi)) {
+            // Overflow region, not counted against the budget
+            cell[0] = cell[1] = NAN;
+        } else {
+            float cellWorst = 0.0f;
+            for (float t : {0.25f, 0.5f, 0.75f}) {
+                float v = lo + t * (hi - lo);
+                float ex = exact(v);
+                float err = std::isfinite(ex) ? relError(cell[0] + t * cell[1], ex) : INFINITY;
+                cellWorst = std::max(cellWorst, err);
+            }
+            if (cellWorst > maxError) {
+                cell[0] = cell[1] = NAN;
+                rejected++;
+            } else {
+                worst = std::max(worst, cellWorst);
+            }
+        }
+        lo = hi;
+        yLo = yHi;
+    }
+    return rejected;
+}
+
+//--- Bake Channel ---//
+/*
+    Build both tables for one channel at the given
+    resolution. Returns false if too many cells
+    would need the exact path.
+*/
+static bool bakeChannel(bakedGrade& bake, int ch, int bits, float maxError) {
+    bakedGradeChannel& c = bake.ch[ch];
+    std::function<float(float)> exact = [&c](float v) {
+        return gradePostCPU(v, c.aGrade, c.bGrade, c.gamma);
+    };
+
+    // Log cells start on float values with the low mantissa bits cleared
+    uint32_t shift = 23 - bits;
+    size_t logCount = (floatBits(kLogMax) - floatBits(kLogMin)) >> shift;
+    auto logEdge = [shift](size_t i) { return bitsFloat(floatBits(kLogMin) + (uint32_t)(i << shift)); };
+
+    size_t linCount = (size_t)(-GRADE_LUT_LIN_MIN * 4) << bits;
+    bake.linScale = linCount / (kLogMin - GRADE_LUT_LIN_MIN);
+    auto linEdge = [&bake](size_t i) { return GRADE_LUT_LIN_MIN + i / bake.linScale; };
+
+    float worst = bake.maxError;
+    int rejected = bakeTable(c.logCells, logCount, logEdge, exact, maxError, worst);
+    rejected += bakeTable(c.linCells, linCount, linEdge, exact, maxError, worst);
+    bake.maxError = worst;
+    return rejected <= GRADE_LUT_MAX_EXACT;
+}
+
+//--- Compile Grade LUT ---//
+/*
+    Double the table resolution until every
+    channel is within maxError apart from a few
+    knee cells, or give up at GRADE_LUT_MAX_BITS
+    and leave the grade to the exact path
+*/
+bool compileGradeLUT(const renderParams& params, bakedGrade& bake, float maxError) {
+    bake = bakedGrade();
+    makeGradeConsts(params, bake.consts);
+    for (int ch = 0; ch < 3; ch++) {
+        bake.ch[ch].aGrade = bake.consts.aGrade[ch];
+        bake.ch[ch].bGrade = bake.consts.bGrade[ch];
+        bake.ch[ch].gamma = params.G_gamma[ch];
+    }
+    // Nothing to bake when the grade is bypassed
+    if (bake.consts.bypass || bake.consts.gradeBypass) {
+        bake.valid = true;
+        return true;
+    }
+
+    for (int bits = GRADE_LUT_MIN_BITS; bits <= GRADE_LUT_MAX_BITS; bits++) {
+        bake.bits = bits;
+        bake.maxError = 0.0f;
+        bool ok = true;
+        for (int ch = 0; ch < 3 && ok; ch++)
+            ok = bakeChannel(bake, ch, bits, maxError);
+        if (ok) {
+            bake.valid = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+//--- Grade Pixels LUT ---//
+/*
+    Exact pre stage, matrix and saturation
+    around the baked post stage
+*/
+void gradePixelsLUT(const bakedGrade& bake, const float* in, float* out, size_t count) {
+    const gradeConsts& c = bake.consts;
+    for (size_t i = 0; i < count; i++) {
+        const float* px = in + i * 4;
+        float* dst = out + i * 4;
+        dst[3] = 1.0f;
+        if (c.bypass) {
+            dst[0] = px[0];
+            dst[1] = px[1];
+            dst[2] = px[2];
+            continue;
+        }
+
+        // Base color divide and black/white point
+        float v[3];
+        for (int ch = 0; ch < 3; ch++)
+            v[ch] = (1.0f / std::max(px[ch], 0.0001f)) * c.baseScale[ch] + c.baseOffset[ch];
+        if (c.gradeBypass) {
+            dst[0] = v[0];
+            dst[1] = v[1];
+            dst[2] = v[2];
+            continue;
+        }
+
+        // Temp/tint and grade black/white point
+        float t[3];
+        for (int ch = 0; ch < 3; ch++)
+            t[ch] = v[ch] * c.gradeScale[ch] + c.gradeOffset[ch];
+
+        // Color matrix, then the baked per-channel grade
+        for (int ch = 0; ch < 3; ch++) {
+            float m = t[0] * c.matrix[ch * 3 + 0] + t[1] * c.matrix[ch * 3 + 1] + t[2] * c.matrix[ch * 3 + 2];
+            v[ch] = evalGradePost(bake, ch, m);
+        }
+
+        // Saturation
+        float l = v[0] * 0.2722287168f + v[1] * 0.6740817658f + v[2] * 0.0536895174f;
+        for (int ch = 0; ch < 3; ch++)
+            dst[ch] = l + c.saturation * (v[ch] - l);
+    }
+}
+
+//--- Grade LUT Preferred ---//
+/*
+    The table replaces the log/pow of the post stage
+    with a lookup, which beats 4-wide vector math but
+    not the 8 and 16-wide kernels
+*/
+bool gradeLUTPreferred() {
+    gradeIsa isa = activeGradeIsa();
+    return isa == GRADE_ISA_SCALAR || isa == GRADE_ISA_SSE4 || isa == GRADE_ISA_NEON;
+}
+
+//--- Cached Grade LUT ---//
+/*
+    Most recently used entry first. The key is
+    the folded constants plus gamma, which is
+    everything compileGradeLUT reads.
+*/
+std::shared_ptr<const bakedGrade> cachedGradeLUT(const renderParams& params) {
+    struct entry {
+        gradeConsts consts;
+        float gamma[3];
+        std::shared_ptr<const bakedGrade> bake;
+    };
+    static std::mutex mutex;
+    static std::vector<entry> entries;
+
+    entry key;
+    makeGradeConsts(params, key.consts);
+    std::copy_n(params.G_gamma, 3, key.gamma);
+    auto matches = [&key](const entry& e) {
+        return std::memcmp(&e.consts, &key.consts, sizeof(gradeConsts)) == 0 &&
+            std::memcmp(e.gamma, key.gamma, sizeof(key.gamma)) == 0;
+    };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(entries.begin(), entries.end(), matches);
+        if (it != entries.end()) {
+            std::rotate(entries.begin(), it, it + 1);
+            return entries.front().bake;
+        }
+    }
+
+    // Bake outside the lock, a racing render may bake the same grade
+    auto bake = std::make_shared<bakedGrade>();
+    if (!compileGradeLUT(params, *bake))
+        return nullptr;
+    key.bake = bake;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::find_if(entries.begin(), entries.end(), matches) == entries.end()) {
+        entries.insert(entries.begin(), key);
+        if (entries.size() > GRADE_LUT_CACHE_SIZE)
+            entries.pop_back();
+    }
+    return bake;
+}
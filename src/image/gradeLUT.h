@@ -0,0 +1,78 @@
+#ifndef _gradelut_h
+#define _gradelut_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "gradeKernel.h"
+#include "renderParams.h"
+
+#define GRADE_LUT_MAX_ERROR 1e-4f   // default relative error bound for baked grades
+#define GRADE_LUT_MIN_BITS 6        // table cells per octave = 2^bits
+#define GRADE_LUT_MAX_BITS 11
+#define GRADE_LUT_MAX_EXACT 8       // inaccurate cells per channel left to the exact path
+#define GRADE_LUT_CACHE_SIZE 4      // baked grades kept for concurrent renders
+
+//--- Baked Grade ---//
+/*
+    Grade split into separable stages:
+        pre     base divide, black/white point, temp/tint,
+                grade black/white point. Affine in 1/x, kept exact.
+        matrix  3x3 color matrix, kept exact.
+        post    JPLog, lift/gain/gamma, clamp, back to linear.
+                Per channel, baked into a table.
+        sat     saturation, kept exact.
+
+    The post table is indexed straight from the float bits,
+    so spacing is constant in relative terms (2^bits cells
+    per octave) and interpolation is linear within a cell.
+    Values below 2^-14 use a uniformly spaced table down
+    to GRADE_LUT_LIN_MIN. Each cell stores its start value
+    and delta. Cells that can't meet the error bound (the
+    knee where the grade clamps, overflow to inf) are stored
+    as NaN and evaluated exactly, as is anything outside
+    both tables.
+*/
+struct bakedGradeChannel {
+    std::vector<float> logCells;    // value, delta pairs
+    std::vector<float> linCells;
+    float aGrade = 1.0f;            // exact fallback parameters
+    float bGrade = 0.0f;
+    float gamma = 1.0f;
+};
+
+struct bakedGrade {
+    bool valid = false;
+    int bits = 0;
+    float maxError = 0.0f;          // worst relative error over the baked cells
+    float linScale = 0.0f;          // cells per unit in linCells
+    gradeConsts consts;
+    bakedGradeChannel ch[3];
+};
+
+// Bake params, growing the table until the measured error is below maxError.
+// Returns false (and leaves bake.valid unset) if the bound can't be met.
+bool compileGradeLUT(const renderParams& params, bakedGrade& bake, float maxError = GRADE_LUT_MAX_ERROR);
+
+// Post stage of one channel through the table
+float evalGradePost(const bakedGrade& bake, int ch, float v);
+
+// Grade count RGBA pixels through a baked grade, alpha is written as 1
+void gradePixelsLUT(const bakedGrade& bake, const float* in, float* out, size_t count);
+
+// True when the table is faster than the grade kernel this machine runs.
+// It wins over scalar and 4-wide kernels, AVX2 and up evaluate faster.
+bool gradeLUTPreferred();
+
+//--- Grade LUT Cache ---//
+/*
+    Returns the bake for params, reusing one of the
+    last few bakes when the folded grade constants
+    match so unchanged grades aren't re-baked on
+    every render. Safe to call from concurrent
+    renders. nullptr if the bound can't be met.
+*/
+std::shared_ptr<const bakedGrade> cachedGradeLUT(const renderParams& params);
+
+#endif
@@ -0,0 +1,281 @@
+#include "histogramKernel.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Clamp to [0, 1], NaN goes to 0
+static inline float clamp01(float v) {
+    return std::min(std::max(0.0f, v), 1.0f);
+}
+
+// Round a clamped value to 8 bits
+static inline uint32_t quantize8(float v) {
+    return (uint32_t)std::min((int)(v * 255.0f + 0.5f), 255);
+}
+
+//--- Quantize Batch ---//
+/*
+    Straight-line pass over n pixels, packing
+    the R, G, B and luma levels of each into one
+    word. Kept free of branches, and writing words
+    rather than bytes, so it vectorizes.
+*/
+static void quantizeBatch(const float* px, size_t n, uint32_t* levels) {
+    for (size_t i = 0; i < n; i++) {
+        float rf = clamp01(px[i * 4 + 0]);
+        float gf = clamp01(px[i * 4 + 1]);
+        float bf = clamp01(px[i * 4 + 2]);
+        float lf = 0.2126f * rf + 0.7152f * gf + 0.0722f * bf;
+        levels[i] = quantize8(rf) | (quantize8(gf) << 8) | (quantize8(bf) << 16) | (quantize8(lf) << 24);
+    }
+}
+
+// Level counts for one worker, [sub][channel][level]
+struct histCounts {
+    uint32_t c[HIST_SUB_COUNT][4][256];
+};
+
+static void countBatch(histCounts& h, size_t n, const uint32_t* levels) {
+    size_t i = 0;
+    for (; i + HIST_SUB_COUNT <= n; i += HIST_SUB_COUNT) {
+        for (int s = 0; s < HIST_SUB_COUNT; s++) {
+            uint32_t v = levels[i + s];
+            h.c[s][0][v & 0xFF]++;
+            h.c[s][1][(v >> 8) & 0xFF]++;
+            h.c[s][2][(v >> 16) & 0xFF]++;
+            h.c[s][3][v >> 24]++;
+        }
+    }
+    for (; i < n; i++) {
+        uint32_t v = levels[i];
+        h.c[0][0][v & 0xFF]++;
+        h.c[0][1][(v >> 8) & 0xFF]++;
+        h.c[0][2][(v >> 16) & 0xFF]++;
+        h.c[0][3][v >> 24]++;
+    }
+}
+
+//--- Bin Strided ---//
+/*
+    Shared by the full and sampled passes. With
+    a step above 1, every step-th pixel from
+    x0 + phase is gathered into a contiguous batch
+    first, the phase moving along with each span.
+*/
+static void binStrided(const float* rgba, unsigned int width, const rowSpan* spans,
+                       size_t spanCount, unsigned int step, HistogramData& histogram) {
+    histogram = HistogramData();
+    if (!rgba || !spans || spanCount == 0)
+        return;
+
+    std::mutex mergeLock;
+    parallelFor(0, spanCount, parallelGrain(spanCount), [&](size_t s0, size_t s1) {
+        auto counts = std::make_unique<histCounts>();
+        std::memset(counts.get(), 0, sizeof(histCounts));
+        uint32_t levels[HIST_BATCH];
+        std::vector<float> gathered;
+        if (step > 1)
+            gathered.resize(HIST_BATCH * 4);
+
+        for (size_t s = s0; s < s1; s++) {
+            const rowSpan& span = spans[s];
+            const float* row = rgba + ((size_t)span.y * width) * 4;
+            if (step == 1) {
+                for (unsigned int x = span.x0; x < span.x1; x += HIST_BATCH) {
+                    size_t n = std::min<size_t>(HIST_BATCH, span.x1 - x);
+                    quantizeBatch(row + (size_t)x * 4, n, levels);
+                    countBatch(*counts, n, levels);
+                }
+                continue;
+            }
+            size_t n = 0;
+            for (size_t x = span.x0 + s % step; x < span.x1; x += step) {
+                std::memcpy(&gathered[n * 4], row + x * 4, 4 * sizeof(float));
+                if (++n == HIST_BATCH) {
+                    quantizeBatch(gathered.data(), n, levels);
+                    countBatch(*counts, n, levels);
+                    n = 0;
+                }
+            }
+            quantizeBatch(gathered.data(), n, levels);
+            countBatch(*counts, n, levels);
+        }
+
+        // Fold the sub-histograms, each level fills two output bins
+        int folded[4][256];
+        for (int ch = 0; ch < 4; ch++) {
+            for (int v = 0; v < 256; v++) {
+                uint32_t total = 0;
+                for (int sub = 0; sub < HIST_SUB_COUNT; sub++)
+                    total += counts->c[sub][ch][v];
+                folded[ch][v] = (int)total;
+            }
+        }
+        std::array<int, 512>* out[4] = {&histogram.r_hist, &histogram.g_hist,
+                                        &histogram.b_hist, &histogram.luminance_hist};
+        std::lock_guard<std::mutex> lock(mergeLock);
+        for (int ch = 0; ch < 4; ch++) {
+            for (int v = 0; v < 256; v++) {
+                (*out[ch])[v * 2] += folded[ch][v];
+                (*out[ch])[v * 2 + 1] += folded[ch][v];
+            }
+        }
+    });
+}
+
+//--- Bin Histogram Spans ---//
+void binHistogramSpans(const float* rgba, unsigned int width, const rowSpan* spans,
+                       size_t spanCount, HistogramData& histogram) {
+    binStrided(rgba, width, spans, spanCount, 1, histogram);
+}
+
+//--- Bin Histogram Sampled ---//
+/*
+    Splits the decimation between rows and
+    columns so the samples stay spread over the
+    whole area, then scales the counts back up
+    to the full pixel count so the drawn shape
+    matches the full pass.
+*/
+void binHistogramSampled(const float* rgba, unsigned int width, const rowSpan* spans,
+                         size_t spanCount, size_t maxSamples, HistogramData& histogram) {
+    size_t total = 0;
+    for (size_t s = 0; s < spanCount; s++)
+        total += spans[s].x1 - spans[s].x0;
+    if (maxSamples == 0 || total <= maxSamples) {
+        binHistogramSpans(rgba, width, spans, spanCount, histogram);
+        return;
+    }
+
+    double ratio = (double)total / (double)maxSamples;
+    unsigned int rowStep = std::max(1u, (unsigned int)std::sqrt(ratio));
+    unsigned int colStep = std::max(1u, (unsigned int)std::ceil(ratio / rowStep));
+
+    std::vector<rowSpan> rows;
+    rows.reserve(spanCount / rowStep + 1);
+    for (size_t s = 0; s < spanCount; s++) {
+        if (spans[s].y % rowStep == 0)
+            rows.push_back(spans[s]);
+    }
+    size_t sampled = 0;
+    for (size_t s = 0; s < rows.size(); s++) {
+        size_t start = rows[s].x0 + s % colStep;
+        if (start < rows[s].x1)
+            sampled += (rows[s].x1 - start + colStep - 1) / colStep;
+    }
+    binStrided(rgba, width, rows.data(), rows.size(), colStep, histogram);
+    if (sampled == 0)
+        return;
+
+    double scale = (double)total / (double)sampled;
+    for (std::array<int, 512>* ch : {&histogram.r_hist, &histogram.g_hist,
+                                     &histogram.b_hist, &histogram.luminance_hist}) {
+        for (int& bin : *ch)
+            bin = (int)std::lround(bin * scale);
+    }
+}
+
+//--- Histogram Bar Heights ---//
+/*
+    Each channel is scaled to its own peak. A
+    peak far above the 98th percentile of the
+    filled bins is pulled down logarithmically so
+    one spike doesn't flatten the rest, and a
+    filled bin is never drawn under 2 pixels.
+*/
+void histogramBarHeights(const HistogramData& histogram, int barHeight, float* heights) {
+    const std::array<int, 512>* channels[4] = {&histogram.r_hist, &histogram.g_hist,
+                                               &histogram.b_hist, &histogram.luminance_hist};
+    for (int ch = 0; ch < 4; ch++) {
+        const std::array<int, 512>& hist = *channels[ch];
+        int maxVal = *std::max_element(hist.begin(), hist.end());
+
+        std::vector<int> filled;
+        for (int val : hist) {
+            if (val > 0)
+                filled.push_back(val);
+        }
+        int percentileVal = 1;
+        if (!filled.empty()) {
+            std::sort(filled.begin(), filled.end());
+            size_t idx = std::min(filled.size() - 1, (size_t)(filled.size() * 0.98f));
+            percentileVal = filled[idx];
+        }
+        if (maxVal > percentileVal * 3)
+            maxVal = percentileVal + (int)(std::log(maxVal - percentileVal + 1) * percentileVal * 0.5);
+        if (maxVal == 0)
+            maxVal = 1;
+
+        for (int bin = 0; bin < 512; bin++) {
+            int height = (int)(((int64_t)hist[bin] * barHeight) / maxVal);
+            if (hist[bin] > 0 && height < 2)
+                height = 2;
+            heights[bin * 4 + ch] = (float)height;
+        }
+    }
+}
+
+//--- Histogram Cache ---//
+bool histogramCache::find(uint64_t key, HistogramData& histogram) {
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->first != key)
+            continue;
+        // Move to the front so it's the last to go
+        m_entries.splice(m_entries.begin(), m_entries, it);
+        histogram = m_entries.front().second;
+        m_hits++;
+        return true;
+    }
+    m_misses++;
+    return false;
+}
+
+void histogramCache::insert(uint64_t key, const HistogramData& histogram) {
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->first == key) {
+            m_entries.erase(it);
+            break;
+        }
+    }
+    m_entries.emplace_front(key, histogram);
+    while (m_entries.size() > m_capacity)
+        m_entries.pop_back();
+}
+
+void histogramCache::clear() {
+    m_entries.clear();
+}
+
+//--- Histogram Spans ---//
+void histogramSpans(int width, int height, const unsigned int* xPoints,
+                    const unsigned int* yPoints, bool cropped, std::vector<rowSpan>& spans) {
+    spans.clear();
+    if (width < 1 || height < 1)
+        return;
+    if (cropped) {
+        spans.resize(height);
+        for (int y = 0; y < height; y++)
+            spans[y] = {(unsigned)y, 0u, (unsigned)width};
+    } else {
+        cropBoxSpans(xPoints, yPoints, width, height, spans);
+    }
+}
+
+//--- Calculate Histogram from RGBA ---//
+void calculateHistogramFromRGBA(const float* rgba_buffer, int width, int height,
+                                HistogramData& histogram, const unsigned int* xPoints,
+                                const unsigned int* yPoints, bool cropped) {
+    if (!rgba_buffer || !xPoints || !yPoints || width < 1 || height < 1) {
+        histogram = HistogramData();
+        return;
+    }
+
+    std::vector<rowSpan> spans;
+    histogramSpans(width, height, xPoints, yPoints, cropped, spans);
+    binHistogramSpans(rgba_buffer, width, spans.data(), spans.size(), histogram);
+}
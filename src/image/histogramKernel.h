@@ -0,0 +1,80 @@
+#ifndef _histogramkernel_h
+#define _histogramkernel_h
+
+#include "structs.h"
+#include "utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+#define HIST_SUB_COUNT 4        // interleaved sub-histograms per worker
+#define HIST_BATCH 256          // pixels quantized ahead of binning
+#define HIST_CACHE_SIZE 16      // histograms kept by render key
+
+//--- Histogram Kernel ---//
+/*
+    Bins the display-referred RGBA pixels of
+    the given row spans. Each channel and the
+    BT.709 luma are clamped to [0, 1] and rounded
+    to 8 bits. A level v counts once in each of
+    bins 2v and 2v + 1 of the 512-bin output.
+    NaN counts as 0.
+
+    Workers count 256 levels into HIST_SUB_COUNT
+    interleaved copies per channel, so pixels in a
+    row that share a level don't wait on each
+    other's increment, then fold them into the
+    output once.
+*/
+void binHistogramSpans(const float* rgba, unsigned int width, const rowSpan* spans,
+                       size_t spanCount, HistogramData& histogram);
+
+// Bins at most maxSamples pixels on a stratified row and
+// column grid, with the counts scaled up to the full area.
+// A maxSamples of 0, or more than the spans hold, bins all.
+void binHistogramSampled(const float* rgba, unsigned int width, const rowSpan* spans,
+                         size_t spanCount, size_t maxSamples, HistogramData& histogram);
+
+// The spans the histogram covers: the whole image when
+// cropped, otherwise only the crop box
+void histogramSpans(int width, int height, const unsigned int* xPoints,
+                    const unsigned int* yPoints, bool cropped, std::vector<rowSpan>& spans);
+
+// Whole image when cropped, otherwise only the crop box
+void calculateHistogramFromRGBA(const float* rgba_buffer, int width, int height,
+                                HistogramData& histogram, const unsigned int* xPoints,
+                                const unsigned int* yPoints, bool cropped);
+
+// Drawn bar height in pixels of each of the 512 bins, as
+// R, G, B, luma quads, for bars up to about barHeight tall
+void histogramBarHeights(const HistogramData& histogram, int barHeight, float* heights);
+
+//--- Histogram Cache ---//
+/*
+    Most recently used histograms by a hash of
+    everything that shapes them, so stepping back
+    to an earlier grade or image skips the readback
+    and binning. Only touched from the GL thread.
+*/
+class histogramCache {
+    public:
+    explicit histogramCache(size_t capacity = HIST_CACHE_SIZE) : m_capacity(capacity) {}
+
+    bool find(uint64_t key, HistogramData& histogram);
+    void insert(uint64_t key, const HistogramData& histogram);
+    void clear();
+
+    size_t size() const { return m_entries.size(); }
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+    private:
+    size_t m_capacity;
+    std::list<std::pair<uint64_t, HistogramData>> m_entries;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+
+#endif
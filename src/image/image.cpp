@@ -176,7 +176,7 @@ void image::updateSaveState() {
     (add/sub for bp, lift, offset)
 */
 renderParams img_to_param(image* _img) {
-    renderParams params;
+    renderParams params{};
 
     params.width = _img->fullIm ? _img->rawWidth : _img->width;
     params.height = _img->fullIm ? _img->rawHeight : _img->height;
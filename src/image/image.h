@@ -6,18 +6,43 @@
 #include <optional>
 #include <variant>
 #include <thread>
+#include <memory>
 #include <mutex>
 #include <vector>
+#include <functional>
 #include <OpenImageIO/imageio.h>
 #include "nlohmann/json.hpp"
 #include "renderParams.h"
+#include "renderTicket.h"
 #include "imageParams.h"
 #include "imageMeta.h"
 #include "state.h"
 #include "structs.h"
+#include "summedArea.h"
+#include "utils.h"
 #include <exiv2/exiv2.hpp>
 
 
+//--- Luma Min/Max ---//
+/*
+    Darkest and brightest pixel found by analysis,
+    with their RGB values. Ties go to the first
+    pixel in row-major order, so partial results
+    can be merged in any order and still match a
+    plain scan of the image.
+*/
+struct lumaMinMax {
+    bool found = false;
+    float minLuma = 0.0f;
+    float maxLuma = 0.0f;
+    unsigned int minX = 0, minY = 0;
+    unsigned int maxX = 0, maxY = 0;
+    float minPix[3] = {};
+    float maxPix[3] = {};
+
+    void add(float luma, unsigned int x, unsigned int y, const float* pix);
+    void merge(const lumaMinMax& other);
+};
 
 struct image {
     // Buffers
@@ -27,6 +52,7 @@ struct image {
     float* tmpOutData = nullptr;
     float* blurImgData = nullptr;
     uint8_t* dispImgData = nullptr;  // Deprecated - remove
+    summedAreaTable rawSAT;          // Held while the base color sample is dragged
     //uint8_t* thumbData;
 
     // Metadata
@@ -47,6 +73,7 @@ struct image {
 
     // Buffer Sizes
     uint64_t rawBufSize = 0;
+    uint64_t rawGen = 0;            // Bumped whenever rawImgData is replaced
     uint64_t blurBufSize = 0;
     uint64_t procBufSize = 0;
     uint64_t tmpBufSize = 0;
@@ -91,6 +118,7 @@ struct image {
     bool cpuRender = false;
     bool imageLoaded = false;
     bool fullIm = false;
+    bool displayProof = false;  // Full render only headed for an 8-bit JPEG
     bool analyzed = false;
     bool selected = false;
     bool visible = false;
@@ -99,7 +127,12 @@ struct image {
     bool imgRst = false;
     bool minSel = false;
     bool reloading = false;
+    bool analysisReload = false;    // Loaded only for a batch analysis, settled by rollRenderCheck
     uint64_t histQueue = 0;
+    // Held while the buffers are loaded or cleared, so the
+    // roll loader and batch analysis never load one image
+    // twice. Shared so images stay copyable.
+    std::shared_ptr<std::mutex> bufferLock = std::make_shared<std::mutex>();
     int activeExpCount = 1;
 
     // Display/Render flags
@@ -112,6 +145,7 @@ struct image {
 
 
     // GL Display
+    long long unsigned int glTexture = 0;   // Resident input texture, may have been evicted
     long long unsigned int glTextureSm = 0;
 
     void* histTex = nullptr;
@@ -174,13 +208,15 @@ struct image {
 
 
     // imageProcessing.cpp
-    void processBaseColor();
+    void processBaseColor(bool live = false);
     void blurImage();
     void processMinMax(ocioSetting ocioSet);
+    void analyzeMinMax(ocioSetting ocioSet);
+    void setAnalysedMinMax(const lumaMinMax& result, ocioSetting ocioSet);
     void setMinMax(ocioSetting ocioSet);
     void calcProxyDim();
     void resizeProxy();
-    void processCPU(ocioSetting ocioSet);
+    void processCPU(ocioSetting ocioSet, renderTicketPtr ticket = nullptr);
 
 };
 
@@ -328,4 +364,33 @@ inline float4 clamp(float4 a, float4 b, float4 c) {
     );
 }
 
+//--- CPU Render Job ---//
+/*
+    Everything the fused CPU pipeline needs to
+    render one image. params.arbitraryRotation
+    is expected in radians.
+*/
+struct cpuRenderJob {
+    const float* src = nullptr;
+    float* dst = nullptr;
+    int srcWidth = 0;
+    int srcHeight = 0;
+    int outWidth = 0;
+    int outHeight = 0;
+    renderParams params;
+};
+
+// Applied in place to a band of RGBA pixels (pixels, width, rows)
+using displayTransformFn = std::function<void(float*, unsigned int, unsigned int)>;
+
+// imageProcessing.cpp
+float gradePostCPU(float v, float aGrade, float bGrade, float gamma);
+void gradePixelsCPU(const renderParams& params, const float* in, float* out, size_t count);
+void renderCPUTiles(const cpuRenderJob& job, const displayTransformFn& displayTransform, unsigned int bandRows = 0);
+void scanLumaMinMax(const float* pixels, size_t stride, size_t x0, size_t x1,
+                    const rowSpan* spans, size_t spanCount,
+                    const float* baseColor, lumaMinMax& out);
+lumaMinMax findLumaMinMax(const float* pixels, unsigned int width,
+                          const std::vector<rowSpan>& spans, const float* baseColor = nullptr);
+
 #endif
@@ -2,6 +2,7 @@
 #include "imageParams.h"
 #include "logger.h"
 #include "preferences.h"
+#include "threadPool.h"
 #include <algorithm>
 
 
@@ -88,9 +89,12 @@ void image::delDispBuf() {
     on ram usage.
 */
 void image::clearBuffers() {
+    std::lock_guard<std::mutex> lock(*bufferLock);
     if (!rawImgData)
         return;
     // Delete raw buffer
+    rawSAT.clear();
+    rawGen++;
     if (rawImgData) {
         delete [] rawImgData;
         rawImgData = nullptr;
@@ -126,8 +130,11 @@ void image::clearBuffers() {
 /*
     Re-allocate and re-load an image back
     from disk after it has been unloaded.
+    A second caller waits for the first load
+    and then finds the image loaded.
 */
 void image::loadBuffers() {
+    std::lock_guard<std::mutex> lock(*bufferLock);
     if (imageLoaded)
         return;
     reloading = true;
@@ -172,19 +179,6 @@ void image::padToRGBA() {
         LOG_ERROR("Either source or destination rgba buffer is null");
     }
 
-    // Define the number of threads to use
-    unsigned int numThreads = 2;//std::thread::hardware_concurrency();
-    if (numThreads == 0) {
-        numThreads = 2; // Default value if concurrent threads can't be determined
-    }
-
-
-    // Create a vector of threads
-    std::vector<std::thread> threads(numThreads);
-
-    // Divide the workload into equal parts for each thread
-    int rowsPerThread = rawHeight / numThreads;
-
     auto processRows = [&](int startRow, int endRow) {
         for (int y=startRow; y<endRow; y++)
         {
@@ -200,17 +194,8 @@ void image::padToRGBA() {
         }
     };
 
-    // Launch the threads
-    for (int i=0; i<numThreads; ++i) {
-        int startRow = i * rowsPerThread;
-        int endRow = (i == numThreads - 1) ? rawHeight : (i + 1) * rowsPerThread;
-        threads[i] = std::thread(processRows, startRow, endRow);
-    }
+    parallelFor(0, rawHeight, parallelGrain(rawHeight), processRows);
 
-        // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
-    }
     memcpy(rawImgData, procImgData, rawWidth * rawHeight * 4 * sizeof(float));
     delProcBuf();
 }
@@ -231,19 +216,6 @@ void image::trimForSave() {
         return;
     }
 
-    // Define the number of threads to use
-    unsigned int numThreads = 2;//std::thread::hardware_concurrency();
-    if (numThreads == 0) {
-        numThreads = 2; // Default value if concurrent threads can't be determined
-    }
-
-
-    // Create a vector of threads
-    std::vector<std::thread> threads(numThreads);
-
-    // Divide the workload into equal parts for each thread
-    int rowsPerThread = rndrH / numThreads;
-
     auto processRows = [&](int startRow, int endRow) {
         for (int y=startRow; y<endRow; y++)
         {
@@ -261,17 +233,7 @@ void image::trimForSave() {
         }
     };
 
-    // Launch the threads
-    for (int i=0; i<numThreads; ++i) {
-        int startRow = i * rowsPerThread;
-        int endRow = (i == numThreads - 1) ? rndrH : (i + 1) * rowsPerThread;
-        threads[i] = std::thread(processRows, startRow, endRow);
-    }
-
-        // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
-    }
+    parallelFor(0, rndrH, parallelGrain(rndrH), processRows);
 }
 
 // --- Unload File Buffer --- //
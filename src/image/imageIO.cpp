@@ -3,6 +3,7 @@
 #include "utils.h"
 #include "preferences.h"
 #include "lancir.h"
+#include "threadPool.h"
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -85,6 +86,7 @@ void image::exportPostProcess() {
         delProcBuf();
     }
     fullIm = false;
+    displayProof = false;
     renderReady = false;
     imgRst = true;
     needRndr = true;
@@ -363,6 +365,8 @@ bool image::debayerImage(bool fullRes, int quality) {
     rawWidth = processedImage->width;
     rawHeight = processedImage->height;
     nChannels = processedImage->colors;
+    rawSAT.clear();
+    rawGen++;
     if (rawImgData)
         delete[] rawImgData;
     rawImgData = new float[processedImage->width * processedImage->height * 4];
@@ -370,13 +374,6 @@ bool image::debayerImage(bool fullRes, int quality) {
 
     // Convert to float (assuming 16-bit output)
     if (processedImage->bits == 16 && processedImage->type == LIBRAW_IMAGE_BITMAP) {
-        unsigned int numThreads = 2;//std::thread::hardware_concurrency();
-        numThreads = numThreads == 0 ? 2 : numThreads;
-        // Create a vector of threads
-        std::vector<std::thread> threads(numThreads);
-        // Divide the workload into equal parts for each thread
-        int rowsPerThread = processedImage->height / numThreads;
-
         uint16_t* raw_data = reinterpret_cast<uint16_t*>(processedImage->data);
         auto processRows = [&](int startRow, int endRow) {
             float pIn[3] = {0};
@@ -402,17 +399,7 @@ bool image::debayerImage(bool fullRes, int quality) {
                 }
             }
         };
-        // Launch the threads
-        for (int i=0; i<numThreads; ++i) {
-            int startRow = i * rowsPerThread;
-            int endRow = (i == numThreads - 1) ? processedImage->height : (i + 1) * rowsPerThread;
-            threads[i] = std::thread(processRows, startRow, endRow);
-        }
-
-            // Wait for all threads to finish
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        parallelFor(0, processedImage->height, parallelGrain(processedImage->height), processRows);
         padToRGBA();
         if (appPrefs.prefs.perfMode && !fullIm)
             resizeProxy();
@@ -471,6 +458,8 @@ bool image::oiioReload() {
     //width = inputSpec.width;
     //height = inputSpec.height;
     //nChannels = inputSpec.nchannels;
+    rawSAT.clear();
+    rawGen++;
     if (rawImgData) {
         delete [] rawImgData;
         rawImgData = nullptr;
@@ -529,6 +518,8 @@ bool image::dataReload() {
     int bytesPerChannel = (intRawSet.bitDepth > 8) ? (intRawSet.bitDepth > 16 ? 4 : 2) : 1;
     int planeSize = rawWidth * rawHeight * bytesPerChannel;
 
+    rawSAT.clear();
+    rawGen++;
     if (rawImgData) {
         delete [] rawImgData;
         rawImgData = nullptr;
@@ -538,12 +529,6 @@ bool image::dataReload() {
     rawBufSize = rawWidth * rawHeight * 4 * sizeof(float);
 
     // Load in the image and pre-process to Linear AP1
-    unsigned int numThreads = 2;//std::thread::hardware_concurrency();
-    numThreads = numThreads == 0 ? 2 : numThreads;
-    // Create a vector of threads
-    std::vector<std::thread> threads(numThreads);
-    // Divide the workload into equal parts for each thread
-    int rowsPerThread = rawHeight / numThreads;
     auto processRows = [&](int startRow, int endRow) {
         float pIn[3] = {0};
         float pOut[3] = {0};
@@ -599,17 +584,7 @@ bool image::dataReload() {
             }
         }
     };
-    // Launch the threads
-    for (int i=0; i<numThreads; ++i) {
-        int startRow = i * rowsPerThread;
-        int endRow = (i == numThreads - 1) ? rawHeight : (i + 1) * rowsPerThread;
-        threads[i] = std::thread(processRows, startRow, endRow);
-    }
-
-    // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
-    }
+    parallelFor(0, rawHeight, parallelGrain(rawHeight), processRows);
 
     padToRGBA();
     width = rawWidth;
@@ -730,13 +705,6 @@ std::variant<image, std::string> readDataImage(std::string imagePath, rawSetting
             img.rawImgData = new float[img.width * img.height * 4];
             img.rawBufSize = img.width * img.height * 4 * sizeof(float);
             // Load in the image and pre-process to Linear AP1
-            unsigned int numThreads = 2;//std::thread::hardware_concurrency();
-            numThreads = numThreads == 0 ? 2 : numThreads;
-            // Create a vector of threads
-            std::vector<std::thread> threads(numThreads);
-            // Divide the workload into equal parts for each thread
-            int rowsPerThread = img.height / numThreads;
-
             img.loadFileintoBuffer();
             if (!img.fileLoaded || img.fileBuffer.size() < 24) {
                 delete [] img.rawImgData;
@@ -814,17 +782,7 @@ std::variant<image, std::string> readDataImage(std::string imagePath, rawSetting
                     }
                 }
             };
-            // Launch the threads
-            for (int i=0; i<numThreads; ++i) {
-                int startRow = i * rowsPerThread;
-                int endRow = (i == numThreads - 1) ? img.height : (i + 1) * rowsPerThread;
-                threads[i] = std::thread(processRows, startRow, endRow);
-            }
-
-            // Wait for all threads to finish
-            for (auto& thread : threads) {
-                thread.join();
-            }
+            parallelFor(0, img.height, parallelGrain(img.height), processRows);
 
             // Image is good
             img.renderBypass = true;
@@ -1030,13 +988,6 @@ auto c1 = std::chrono::steady_clock::now();
     img.rawBufSize = img.width * img.height * 4 * sizeof(float);
     // Convert to float (assuming 16-bit output)
     if (processedImage->bits == 16 && processedImage->type == LIBRAW_IMAGE_BITMAP) {
-        unsigned int numThreads = 2;//std::thread::hardware_concurrency();
-        numThreads = numThreads == 0 ? 2 : numThreads;
-        // Create a vector of threads
-        std::vector<std::thread> threads(numThreads);
-        // Divide the workload into equal parts for each thread
-        int rowsPerThread = processedImage->height / numThreads;
-
         uint16_t* raw_data = reinterpret_cast<uint16_t*>(processedImage->data);
         auto processRows = [&](int startRow, int endRow) {
             float pIn[3] = {0};
@@ -1062,17 +1013,7 @@ auto c1 = std::chrono::steady_clock::now();
                 }
             }
         };
-        // Launch the threads
-        for (int i=0; i<numThreads; ++i) {
-            int startRow = i * rowsPerThread;
-            int endRow = (i == numThreads - 1) ? processedImage->height : (i + 1) * rowsPerThread;
-            threads[i] = std::thread(processRows, startRow, endRow);
-        }
-
-        // Wait for all threads to finish
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        parallelFor(0, processedImage->height, parallelGrain(processedImage->height), processRows);
 
     }
 auto d1 = std::chrono::steady_clock::now();
@@ -1,4 +1,8 @@
 #include "image.h"
+#include "curveLUT.h"
+#include "gaussianBlur.h"
+#include "gradeKernel.h"
+#include "gradeLUT.h"
 #include "imageParams.h"
 #include "logger.h"
 #include "ocioProcessor.h"
@@ -6,16 +10,25 @@
 #include "renderParams.h"
 #include "utils.h"
 #include "lancir.h"
+#include "threadPool.h"
 #include <string>
 
 //---Process Base Color---//
 /*
     Based on the selection points made in the GUI,
     average all of the pixels in the rectangle
-    together to get the base color
+    together to get the base color.
+    Live samples (while dragging) build the summed
+    area table so every update after the first is
+    four lookups, otherwise it is used if already
+    built and the box is summed directly if not.
 */
 
-void image::processBaseColor() {
+void image::processBaseColor(bool live) {
+    if (!rawImgData || width == 0 || height == 0) {
+        LOG_ERROR("Cannot average base! No image data");
+        return;
+    }
 
     unsigned int x0, x1, y0, y1;
     unsigned int sampleX[2];
@@ -36,13 +49,18 @@ void image::processBaseColor() {
     y0 = std::clamp(y0, 0u, height - 1);
     y1 = std::clamp(y1, 0u, height - 1);
 
+    if (live)
+        rawSAT.update(rawImgData, width, height);
+    if (rawSAT.boxMean(x0, y0, x1, y1, imgParam.baseColor))
+        return;
+
     unsigned int pixCount = 0;
-    float rTotal = 0.0f;
-    float gTotal = 0.0f;
-    float bTotal = 0.0f;
-    for (int y = y0; y <= y1; y++) {
-        for (int x = x0; x <= x1; x++) {
-            int index = ((y * width) + x) * 4;
+    double rTotal = 0.0;
+    double gTotal = 0.0;
+    double bTotal = 0.0;
+    for (unsigned int y = y0; y <= y1; y++) {
+        for (unsigned int x = x0; x <= x1; x++) {
+            size_t index = (((size_t)y * width) + x) * 4;
             rTotal += rawImgData[index + 0];
             gTotal += rawImgData[index + 1];
             bTotal += rawImgData[index + 2];
@@ -55,9 +73,9 @@ void image::processBaseColor() {
         return;
     }
 
-    imgParam.baseColor[0] = rTotal / (float)pixCount;
-    imgParam.baseColor[1] = gTotal / (float)pixCount;
-    imgParam.baseColor[2] = bTotal / (float)pixCount;
+    imgParam.baseColor[0] = rTotal / pixCount;
+    imgParam.baseColor[1] = gTotal / pixCount;
+    imgParam.baseColor[2] = bTotal / pixCount;
 
 }
 
@@ -69,90 +87,191 @@ void image::processBaseColor() {
 void image::blurImage() {
     allocateTmpBuf();
 
-    int kernelSize = (int)(imgParam.blurAmount * KERNELSIZE) + 1;
-    kernelSize = kernelSize % 2 == 0 ? kernelSize + 1 : kernelSize;
+    // Blur into the blur buffer, using the tmp buffer between passes
+    gaussianBlur(rawImgData, tmpOutData, blurImgData, width, height, imgParam.blurAmount);
 
-    int halfSize = kernelSize / 2;
+    // Invert against the base color
+    size_t rowLen = (size_t)width * 4;
+    parallelFor(0, height, parallelGrain(height), [&](size_t y0, size_t y1) {
+        for (size_t i = y0 * rowLen; i < y1 * rowLen; i += 4) {
+            for (int ch = 0; ch < 3; ch++)
+                blurImgData[i + ch] = (imgParam.baseColor[ch] / blurImgData[i + ch]) * 0.1f;
+        }
+    });
+
+    clearTmpBuf();
+    blurReady = true;
+}
+
+
+//--- Luma Min/Max ---//
+static bool rowMajorBefore(unsigned int x, unsigned int y, unsigned int ox, unsigned int oy) {
+    return y < oy || (y == oy && x < ox);
+}
+
+void lumaMinMax::add(float luma, unsigned int x, unsigned int y, const float* pix) {
+    lumaMinMax one;
+    one.found = true;
+    one.minLuma = one.maxLuma = luma;
+    one.minX = one.maxX = x;
+    one.minY = one.maxY = y;
+    std::copy_n(pix, 3, one.minPix);
+    std::copy_n(pix, 3, one.maxPix);
+    merge(one);
+}
+
+void lumaMinMax::merge(const lumaMinMax& other) {
+    if (!other.found)
+        return;
+    if (!found) {
+        *this = other;
+        return;
+    }
+    if (other.minLuma < minLuma ||
+        (other.minLuma == minLuma && rowMajorBefore(other.minX, other.minY, minX, minY))) {
+        minLuma = other.minLuma;
+        minX = other.minX;
+        minY = other.minY;
+        std::copy_n(other.minPix, 3, minPix);
+    }
+    if (other.maxLuma > maxLuma ||
+        (other.maxLuma == maxLuma && rowMajorBefore(other.maxX, other.maxY, maxX, maxY))) {
+        maxLuma = other.maxLuma;
+        maxX = other.maxX;
+        maxY = other.maxY;
+        std::copy_n(other.maxPix, 3, maxPix);
+    }
+}
 
-    float* blurKern = new float[kernelSize];
-
-    computeKernels(imgParam.blurAmount, blurKern);
-
-    unsigned int numThreads = std::thread::hardware_concurrency();
-    numThreads = numThreads == 0 ? 2 : numThreads;
-    // Create a vector of threads
-    std::vector<std::thread> threads(numThreads);
-
-    int rowsPerThread = height / numThreads;
-    int colsPerThread = width / numThreads;
-
-    // Horizontal Blur
-    auto processRows = [&](int startRow, int endRow) {
-        for (int y=startRow; y<endRow; y++)
-        {
-            for (int x=0; x < width; x++) {
-                float outPix[3] = {0.0f, 0.0f, 0.0f};
-                for (int i = -halfSize; i <= halfSize; i++)
-                {
-                    int sx = std::clamp(x + i, 0, (int)width - 1);
-                    float w = blurKern[i + halfSize];
-                    const float* pix = rawImgData + ((y * width + sx) * 4);
-                    outPix[0] += w * pix[0];
-                    outPix[1] += w * pix[1];
-                    outPix[2] += w * pix[2];
-                }
-                float* out = tmpOutData + ((y * width + x) * 4);
-                out[0] = outPix[0];
-                out[1] = outPix[1];
-                out[2] = outPix[2];
-            }
+//--- Span Luma Min/Max ---//
+/*
+    Min/max of count pixels on row y starting at
+    column x. Luma goes into a scratch row first so
+    the reductions run over plain floats, with a
+    bank of lanes the compiler can keep in vector
+    registers. Only the winners are located after.
+*/
+#define MINMAX_LANES 8
+
+static inline void invertedPixel(const float* src, const float* baseColor, float* pix) {
+    for (int ch = 0; ch < 3; ch++)
+        pix[ch] = baseColor ? (baseColor[ch] / src[ch]) * 0.1f : src[ch];
+}
+
+static void spanLumaMinMax(const float* pixels, unsigned int x, unsigned int y, size_t count,
+                           const float* baseColor, std::vector<float>& scratch, lumaMinMax& out) {
+    scratch.resize(count);
+    float* luma = scratch.data();
+    if (baseColor) {
+        for (size_t i = 0; i < count; i++) {
+            const float* src = pixels + i * 4;
+            float r = (baseColor[0] / src[0]) * 0.1f;
+            float g = (baseColor[1] / src[1]) * 0.1f;
+            float b = (baseColor[2] / src[2]) * 0.1f;
+            luma[i] = r * 0.2722287168f + g * 0.6740817658f + b * 0.0536895174f;
         }
-    };
-    // Launch the threads
-    for (int i=0; i<numThreads; ++i) {
-        int startRow = i * rowsPerThread;
-        int endRow = (i == numThreads - 1) ? height : (i + 1) * rowsPerThread;
-        threads[i] = std::thread(processRows, startRow, endRow);
-    }
-
-    // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
-    }
-
-    // Vertical Blur
-    auto processCols = [&](int startCol, int endCol) {
-        for (int x = startCol; x < endCol; x++) {
-            for (int y = 0; y < height; y++) {
-                for (int ch = 0; ch < 3; ch++) {
-                    float outPix = 0.0f;
-                    int kernelCountery = 0;
-                    for (int i = -halfSize; i <= halfSize; i++) {
-                        outPix += blurKern[kernelCountery] * tmpOutData[(((std::clamp(y + i, 0, (int)height - 1) * width) + x) * 4)+ch];
-                        kernelCountery++;
-                    }
-                    blurImgData[(((y * width) + x) * 4 ) + ch] = (imgParam.baseColor[ch] / outPix) * 0.1f;
-                }
-            }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            const float* src = pixels + i * 4;
+            luma[i] = src[0] * 0.2722287168f + src[1] * 0.6740817658f + src[2] * 0.0536895174f;
         }
-    };
-    // Launch the threads
-    for (int i=0; i<numThreads; ++i) {
-        int startCol = i * colsPerThread;
-        int endCol = (i == numThreads - 1) ? width : (i + 1) * colsPerThread;
-        threads[i] = std::thread(processCols, startCol, endCol);
     }
 
-    // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
+    // NaN compares false and never replaces a lane
+    float lo[MINMAX_LANES], hi[MINMAX_LANES];
+    std::fill_n(lo, MINMAX_LANES, INFINITY);
+    std::fill_n(hi, MINMAX_LANES, -INFINITY);
+    size_t i = 0;
+    for (; i + MINMAX_LANES <= count; i += MINMAX_LANES) {
+        for (int l = 0; l < MINMAX_LANES; l++) {
+            float v = luma[i + l];
+            lo[l] = v < lo[l] ? v : lo[l];
+            hi[l] = v > hi[l] ? v : hi[l];
+        }
+    }
+    for (; i < count; i++) {
+        lo[0] = luma[i] < lo[0] ? luma[i] : lo[0];
+        hi[0] = luma[i] > hi[0] ? luma[i] : hi[0];
     }
+    float rowMin = lo[0], rowMax = hi[0];
+    for (int l = 1; l < MINMAX_LANES; l++) {
+        rowMin = lo[l] < rowMin ? lo[l] : rowMin;
+        rowMax = hi[l] > rowMax ? hi[l] : rowMax;
+    }
+    // Nothing but NaN on this span
+    if (rowMin > rowMax)
+        return;
+    // Most rows can't change the result
+    if (out.found && rowMin > out.minLuma && rowMax < out.maxLuma)
+        return;
 
-    clearTmpBuf();
-    delete [] blurKern;
-    blurReady = true;
+    // First position of each winner, ties resolve in merge
+    lumaMinMax row;
+    row.found = true;
+    row.minLuma = rowMin;
+    row.maxLuma = rowMax;
+    row.minY = row.maxY = y;
+    size_t minI = std::find(luma, luma + count, rowMin) - luma;
+    size_t maxI = std::find(luma, luma + count, rowMax) - luma;
+    row.minX = x + minI;
+    row.maxX = x + maxI;
+    invertedPixel(pixels + minI * 4, baseColor, row.minPix);
+    invertedPixel(pixels + maxI * 4, baseColor, row.maxPix);
+    out.merge(row);
+}
+
+//--- Scan Luma Min/Max ---//
+/*
+    Find the darkest and brightest pixel of
+    columns [x0, x1) over the given spans. Pixel
+    (x, y) is at pixels[y * stride + (x - x0) * 4].
+    With a baseColor the pixels are the raw blur
+    and get inverted against it first.
+*/
+void scanLumaMinMax(const float* pixels, size_t stride, size_t x0, size_t x1,
+                    const rowSpan* spans, size_t spanCount,
+                    const float* baseColor, lumaMinMax& out) {
+    std::vector<float> scratch;
+    for (size_t i = 0; i < spanCount; i++) {
+        const rowSpan& span = spans[i];
+        size_t a = std::max<size_t>(span.x0, x0);
+        size_t b = std::min<size_t>(span.x1, x1);
+        if (a >= b)
+            continue;
+        const float* row = pixels + span.y * stride;
+        spanLumaMinMax(row + (a - x0) * 4, a, span.y, b - a, baseColor, scratch, out);
+    }
 }
 
+//--- Find Luma Min/Max ---//
+/*
+    Parallel scan of a stored RGBA image. Spans
+    are split into fixed pieces and the piece
+    results merged in order, which together with
+    the merge tie rule makes the answer the same
+    whatever the thread count.
+*/
+lumaMinMax findLumaMinMax(const float* pixels, unsigned int width,
+                          const std::vector<rowSpan>& spans, const float* baseColor) {
+    lumaMinMax result;
+    if (!pixels || spans.empty())
+        return result;
+
+    size_t grain = parallelGrain(spans.size(), 16);
+    size_t pieces = (spans.size() + grain - 1) / grain;
+    std::vector<lumaMinMax> pieceResults(pieces);
+    parallelFor(0, pieces, 1, [&](size_t p0, size_t p1) {
+        for (size_t p = p0; p < p1; p++) {
+            size_t first = p * grain;
+            size_t count = std::min(grain, spans.size() - first);
+            scanLumaMinMax(pixels, (size_t)width * 4, 0, width, spans.data() + first, count,
+                           baseColor, pieceResults[p]);
+        }
+    });
+    for (const lumaMinMax& r : pieceResults)
+        result.merge(r);
+    return result;
+}
 
 //--- Process Min/Max values ---//
 /*
@@ -168,41 +287,63 @@ void image::processMinMax(ocioSetting ocioSet) {
             return; //TODO: Error status return
         }
 
-    float* buffer = blurImgData;
+    unsigned int cropBoxX[4];
+    unsigned int cropBoxY[4];
+    for (int i = 0; i < 4; i++) {
+        cropBoxX[i] = imgParam.cropBoxX[i] * width;
+        cropBoxY[i] = imgParam.cropBoxY[i] * height;
+    }
+    std::vector<rowSpan> spans;
+    cropBoxSpans(cropBoxX, cropBoxY, width, height, spans);
+    setAnalysedMinMax(findLumaMinMax(blurImgData, width, spans, nullptr), ocioSet);
+}
 
-    float maxLuma = -100.0f;
-    float minLuma = 100.0f;
-    unsigned int minX, minY, maxX, maxY;
+//--- Analyze Min/Max ---//
+/*
+    Fused blur and min/max. The vertical blur
+    hands each column block straight to the scan,
+    so blurImgData is never allocated and only the
+    tmp buffer is full size. Gives the same result
+    as blurImage followed by processMinMax.
+*/
+void image::analyzeMinMax(ocioSetting ocioSet) {
     unsigned int cropBoxX[4];
     unsigned int cropBoxY[4];
     for (int i = 0; i < 4; i++) {
         cropBoxX[i] = imgParam.cropBoxX[i] * width;
         cropBoxY[i] = imgParam.cropBoxY[i] * height;
     }
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (isPointInBox(x, y, cropBoxX, cropBoxY)) {
-                unsigned int index = (y * width) + x;
-                float luma = Luma(buffer[4 * index + 0], buffer[4 * index + 1], buffer[4 * index + 2]);
-                if (luma < minLuma) {
-                    minLuma = luma;
-                    minX = x;
-                    minY = y;
-                    imgParam.blackPoint[0] = buffer[4 * index + 0];
-                    imgParam.blackPoint[1] = buffer[4 * index + 1];
-                    imgParam.blackPoint[2] = buffer[4 * index + 2];
-                }
-                if (luma > maxLuma) {
-                    maxLuma = luma;
-                    maxX = x;
-                    maxY = y;
-                    imgParam.whitePoint[0] = buffer[4 * index + 0];
-                    imgParam.whitePoint[1] = buffer[4 * index + 1];
-                    imgParam.whitePoint[2] = buffer[4 * index + 2];
-                }
-            }
-        }
+    std::vector<rowSpan> spans;
+    cropBoxSpans(cropBoxX, cropBoxY, width, height, spans);
+
+    allocateTmpBuf();
+    // One result per block, merged in order once the workers are done
+    std::vector<lumaMinMax> blockResults((width + BLUR_BLOCK_COLUMNS - 1) / BLUR_BLOCK_COLUMNS);
+    gaussianBlurBlocks(rawImgData, tmpOutData, width, height, imgParam.blurAmount,
+        [&](size_t block, const float* strip, size_t stride, size_t x0, size_t x1) {
+            scanLumaMinMax(strip, stride, x0, x1, spans.data(), spans.size(),
+                           imgParam.baseColor, blockResults[block]);
+        });
+    clearTmpBuf();
+
+    lumaMinMax result;
+    for (const lumaMinMax& r : blockResults)
+        result.merge(r);
+    setAnalysedMinMax(result, ocioSet);
+}
+
+//--- Set Analysed Min/Max ---//
+/*
+    Store the analysed black and white points,
+    offset by the display transform minimum
+*/
+void image::setAnalysedMinMax(const lumaMinMax& result, ocioSetting ocioSet) {
+    if (!result.found) {
+        LOG_ERROR("Cannot analyze {}. No pixels inside the crop box!", srcFilename);
+        return;
     }
+    std::copy_n(result.minPix, 3, imgParam.blackPoint);
+    std::copy_n(result.maxPix, 3, imgParam.whitePoint);
 
     // Apply Display Transform Minimum Offset
     float zeroPix[4] = {appPrefs.prefs.minOffset, appPrefs.prefs.minOffset, appPrefs.prefs.minOffset, 1.0f};
@@ -213,18 +354,16 @@ void image::processMinMax(ocioSetting ocioSet) {
     imgParam.blackPoint[1] -= zeroPix[1];
     imgParam.blackPoint[2] -= zeroPix[2];
 
-    imgParam.minX = (float)minX / width;
-    imgParam.minY = (float)minY / height;
-    imgParam.maxX = (float)maxX / width;
-    imgParam.maxY = (float)maxY / height;
+    imgParam.minX = (float)result.minX / width;
+    imgParam.minY = (float)result.minY / height;
+    imgParam.maxX = (float)result.maxX / width;
+    imgParam.maxY = (float)result.maxY / height;
 
     LOG_INFO("Analysis finished for {}!", srcFilename);
     LOG_INFO("Min Pixel: {},{}", imgParam.minX, imgParam.minY);
     LOG_INFO("Min Values: {}, {}, {}", imgParam.blackPoint[0], imgParam.blackPoint[1], imgParam.blackPoint[2]);
-    int minIndex = (minY * width) + minX;
-    int maxIndex = (maxY * width) + maxX;
-    float min[3] = {buffer[4 * minIndex + 0], buffer[4 * minIndex + 1], buffer[4 * minIndex + 2]};
-    float max[3] = {buffer[4 * maxIndex + 0], buffer[4 * maxIndex + 1], buffer[4 * maxIndex + 2]};
+    const float* min = result.minPix;
+    const float* max = result.maxPix;
     float minSat = oklab_Chroma(min[0], min[1], min[2]);
     float maxSat = oklab_Chroma(max[0], max[1], max[2]);
     LOG_INFO("Min Value Chrominance: {}", minSat);
@@ -250,22 +389,29 @@ void image::setMinMax(ocioSetting ocioSet) {
     int pointX = minSel ? imgParam.minX * width : imgParam.maxX * width;
     int pointY = minSel ? imgParam.minY * height : imgParam.maxY * height;
 
-    float sumWeights = 0.0;
+    // The 2D Gaussian is the product of two 1D ones,
+    // so the weights only need one exp() per tap
+    std::vector<float> weights(kernelSize);
+    float sumWeights1D = 0.0f;
+    for (int i = -halfSize; i <= halfSize; i++) {
+        weights[i + halfSize] = std::exp(-((float)(i * i)) / (2.0f * imgParam.blurAmount * imgParam.blurAmount));
+        sumWeights1D += weights[i + halfSize];
+    }
+    float sumWeights = sumWeights1D * sumWeights1D;
     float outPix[3] = {0.0f, 0.0f, 0.0f};
-    int ySq, xSq;
 
     for (int y = -halfSize; y <= halfSize; y++) {
-        ySq = y * y;
-        for (int x = -halfSize; x<= halfSize; x++) {
-            xSq = x * x;
+        int yPos = std::clamp(pointY + y, 0, (int)height - 1);
+        const float* row = rawImgData + (size_t)yPos * width * 4;
+        float rowPix[3] = {0.0f, 0.0f, 0.0f};
+        for (int x = -halfSize; x <= halfSize; x++) {
             int xPos = std::clamp(pointX + x, 0, (int)width - 1);
-            int yPos = std::clamp(pointY + y, 0, (int)height - 1);
-            float weight = exp(-((float)(xSq + ySq)) / (2.0f * imgParam.blurAmount * imgParam.blurAmount));
-            for (int ch = 0; ch < 3; ch ++) {
-                outPix[ch] += weight * rawImgData[(((yPos * width) + xPos) * 4) + ch];
-            }
-            sumWeights += weight;
+            float weight = weights[x + halfSize];
+            for (int ch = 0; ch < 3; ch++)
+                rowPix[ch] += weight * row[xPos * 4 + ch];
         }
+        for (int ch = 0; ch < 3; ch++)
+            outPix[ch] += weights[y + halfSize] * rowPix[ch];
     }
     if (minSel) {
         imgParam.blackPoint[0] = (imgParam.baseColor[0] / (outPix[0] / sumWeights)) * 0.1f;
@@ -331,6 +477,8 @@ void image::resizeProxy() {
 
     // We want to resize the raw image data buffer
     // to only be as big as the new smaller image
+    rawSAT.clear();
+    rawGen++;
     if (rawImgData) {
         delete [] rawImgData;
         rawImgData = nullptr;
@@ -573,37 +721,32 @@ float evalCurve(float v, const float* curve, int n) {
     return h00*pay + h10*dx*m0 + h01*pby + h11*dx*m1;
 }
 
-//--- CPU Render ---//
+//--- Grade Post Stage ---//
 /*
-    Function to process images on CPU
-    rather than on GPU
+    The per-channel part of the grade that follows
+    the color matrix: into JPLog, lift/gain/gamma,
+    clamp and back to linear. Same float math as
+    gradePixelsCPU, used to bake the grade LUTs.
 */
-void image::processCPU(ocioSetting ocioSet) {
-    auto start = std::chrono::steady_clock::now();
-    cpuRender = true;
-    // Generate RenderParams struct
-    renderParams _renderParams = img_to_param(this);
-
-    int procWidth = fullIm ? rawWidth : width;
-    int procHeight = fullIm ? rawHeight : height;
-
-    int outputWidth = procWidth;
-    int outputHeight = procHeight;
-    if (imgParam.cropEnable) {
-        // Calculate crop rectangle dimensions
-        outputWidth = (imgParam.imageCropMaxX - imgParam.imageCropMinX) * procWidth;
-        outputHeight = (imgParam.imageCropMaxY - imgParam.imageCropMinY) * procHeight;
+float gradePostCPU(float v, float aGrade, float bGrade, float gamma) {
+    float4 tempPix = LintoJPLog(float4(v));
+    float4 powBase = float4(aGrade) * tempPix + float4(bGrade);
+    powBase = max(powBase, float4(0.0001));
+    tempPix = pow(powBase, 1.0/float4(gamma));
+    tempPix = clamp(tempPix, 0.0, 100.0);
+    return JPLogtoLin(tempPix).x;
+}
 
-        // Ensure minimum size
-        if (outputWidth < 1) outputWidth = 1;
-        if (outputHeight < 1) outputHeight = 1;
-    }
-    allocProcBuf();
+//--- Grade Pixels ---//
+/*
+    Scalar inversion/grade of count RGBA pixels.
+    Reference for the SIMD kernels in gradeKernel,
+    and the fallback when none are available.
+*/
+void gradePixelsCPU(const renderParams& _renderParams, const float* in, float* out, size_t count) {
     float4 baseColor = float4(_renderParams.baseColor);
     float4 blackPoint = float4(_renderParams.blackPoint);
     float4 whitePoint = float4(_renderParams.whitePoint);
-    float G_temp = _renderParams.temp;
-    float G_tint = _renderParams.tint;
     float4 G_blackpoint = float4(_renderParams.G_blackpoint);
     float4 G_whitepoint = float4(_renderParams.G_whitepoint);
     float4 G_mult = float4(_renderParams.G_mult);
@@ -611,158 +754,266 @@ void image::processCPU(ocioSetting ocioSet) {
     float4 G_lift = float4(_renderParams.G_lift);
     float4 G_offset = float4(_renderParams.G_offset);
     float4 G_gamma = float4(_renderParams.G_gamma);
-    _renderParams.arbitraryRotation = imgParam.arbitraryRotation * (M_PI / 180.0f);
-
-    // Get system thread count
-    int threadCount = std::thread::hardware_concurrency();
-    threadCount = threadCount < 1 ? 1 : threadCount; // Ensure minimum
-
-    // Get minimum of active images/max export count
-    unsigned int numThreads = threadCount / std::min(appPrefs.prefs.maxSimExports, activeExpCount);
-    numThreads = numThreads < 1 ? 1 : numThreads; // Ensure minimum
-
-    LOG_INFO("Processing image {} on CPU with {} threads!", srcFilename, numThreads);
-
-    // Thread vector
-    std::vector<std::thread> threads(numThreads);
-    int rowsPerThread = outputHeight / numThreads;
-
-    auto processRows = [&](int startRow, int endRow) {
-        for (int y = startRow; y < endRow; y++) {
-            for (int x = 0; x < outputWidth; x++) {
-                float4 pixIn;
-                uint32_t index;
-                if (imgParam.cropEnable) {
-                    // Convert output pixel to normalized UV coordinates [0, 1]
-                    float u = ((float)x + 0.5f) / (float)outputWidth;
-                    float v = ((float)y + 0.5f) / (float)outputHeight;
-
-                    // Calculate input UV coordinates
-                    float sampleU, sampleV;
-                    getCroppedRotatedUV(u, v, sampleU, sampleV, _renderParams,
-                                        procWidth, procHeight,      // input dimensions
-                                        outputWidth, outputHeight);  // output dimensions
-                    // Check if sample position is outside valid texture bounds
-                    index = ((y * outputWidth) + x) * 4;
-                    if (sampleU < 0.0f || sampleU > 1.0f || sampleV < 0.0f || sampleV > 1.0f) {
-                        continue;
-                    }
-
-                    pixIn = sampleImageMitchell(rawImgData, procWidth, procHeight,
-                                                       sampleU, sampleV);
-                } else {
-                    index = ((y * outputWidth) + x) * 4;
-                    pixIn.x = rawImgData[index + 0];
-                    pixIn.y = rawImgData[index + 1];
-                    pixIn.z = rawImgData[index + 2];
-                    pixIn.w = rawImgData[index + 3];
-                }
-
-                // Base Color
-                float4 pixOut = (baseColor / max(pixIn, float4(0.0001))) * 0.1;
-                pixOut.w = 1.0;
-
-                // Set White/Black Points
-                pixOut = (pixOut - blackPoint) / (whitePoint - blackPoint);
-
-                // Temp/Tint
-                float4 tempPix = pixOut;
-                float4 warm = float4(2.0, 1.0, 0.0, 1.0);
-                float4 cool = float4(0.0, 1.0, 2.0, 1.0);
-                float4 green = float4(0.0, 1.5, 0.0, 1.0);
-                float4 mag = float4(1.5, 0.0, 1.5, 1.0);
-                float temp = (-1.0 * _renderParams.temp);
-                float tint = (0.75 * _renderParams.tint);
-
-                // WB
-                tempPix = temp >= 0.0 ?
-                    (tempPix * cool * temp) + ((1.0 - temp) * tempPix) :
-                    (tempPix * warm * (-1.0 * temp)) + ((1.0 - (-1.0 * temp)) * tempPix);
-                // Tint
-                tempPix = tint >= 0.0 ?
-                    (tempPix * mag * tint) + ((1.0 - tint) * tempPix) :
-                    (tempPix * green * (-1.0 * tint)) + ((1.0 - (-1.0 * tint)) * tempPix);
-
-                // Process grade bp/wp in linear
-                tempPix = (tempPix - G_blackpoint) / (G_whitepoint - G_blackpoint);
-
-                // Color Matrix
-                float4 inPix = tempPix;
-                tempPix.x = (inPix.x * _renderParams.G_matrixR[0] + inPix.y * _renderParams.G_matrixR[1] + inPix.z * _renderParams.G_matrixR[2]);
-                tempPix.y = (inPix.x * _renderParams.G_matrixG[0] + inPix.y * _renderParams.G_matrixG[1] + inPix.z * _renderParams.G_matrixG[2]);
-                tempPix.z = (inPix.x * _renderParams.G_matrixB[0] + inPix.y * _renderParams.G_matrixB[1] + inPix.z * _renderParams.G_matrixB[2]);
-
-                // Lin to Log for grading
-                tempPix = LintoJPLog(tempPix);
-
-                // Grade node operation
-                float4 aGrade = G_mult * (G_gain - G_lift) / (1.0 - 0.0);
-                float4 bGrade = G_offset + G_lift - aGrade * 0.0;
-                float4 powBase = aGrade * tempPix + bGrade;
-                powBase = max(powBase, float4(0.0001));
-                tempPix = pow(powBase, 1.0/G_gamma);
-                tempPix = clamp(tempPix, 0.0, 100.0);
-
-                // Back to lin for output
-                tempPix = JPLogtoLin(tempPix);
-
-                // Perform saturation operation
-                float lumaPix = luma(tempPix);
-                tempPix = lumaPix + (_renderParams.saturation + 1.0) * (tempPix - lumaPix);
-
-                procImgData[index + 0] = (renderBypass == 1 ? pixIn.x : gradeBypass == 1 ? pixOut.x : tempPix.x);
-                procImgData[index + 1] = (renderBypass == 1 ? pixIn.y : gradeBypass == 1 ? pixOut.y : tempPix.y);
-                procImgData[index + 2] = (renderBypass == 1 ? pixIn.z : gradeBypass == 1 ? pixOut.z : tempPix.z);
-                procImgData[index + 3] = 1.0f;
-            }
-        }
+
+    for (size_t i = 0; i < count; i++) {
+        float4 pixIn;
+        pixIn.x = in[i * 4 + 0];
+        pixIn.y = in[i * 4 + 1];
+        pixIn.z = in[i * 4 + 2];
+        pixIn.w = in[i * 4 + 3];
+
+        // Base Color
+        float4 pixOut = (baseColor / max(pixIn, float4(0.0001))) * 0.1;
+        pixOut.w = 1.0;
+
+        // Set White/Black Points
+        pixOut = (pixOut - blackPoint) / (whitePoint - blackPoint);
+
+        // Temp/Tint
+        float4 tempPix = pixOut;
+        float4 warm = float4(2.0, 1.0, 0.0, 1.0);
+        float4 cool = float4(0.0, 1.0, 2.0, 1.0);
+        float4 green = float4(0.0, 1.5, 0.0, 1.0);
+        float4 mag = float4(1.5, 0.0, 1.5, 1.0);
+        float temp = (-1.0 * _renderParams.temp);
+        float tint = (0.75 * _renderParams.tint);
+
+        // WB
+        tempPix = temp >= 0.0 ?
+            (tempPix * cool * temp) + ((1.0 - temp) * tempPix) :
+            (tempPix * warm * (-1.0 * temp)) + ((1.0 - (-1.0 * temp)) * tempPix);
+        // Tint
+        tempPix = tint >= 0.0 ?
+            (tempPix * mag * tint) + ((1.0 - tint) * tempPix) :
+            (tempPix * green * (-1.0 * tint)) + ((1.0 - (-1.0 * tint)) * tempPix);
+
+        // Process grade bp/wp in linear
+        tempPix = (tempPix - G_blackpoint) / (G_whitepoint - G_blackpoint);
+
+        // Color Matrix
+        float4 inPix = tempPix;
+        tempPix.x = (inPix.x * _renderParams.G_matrixR[0] + inPix.y * _renderParams.G_matrixR[1] + inPix.z * _renderParams.G_matrixR[2]);
+        tempPix.y = (inPix.x * _renderParams.G_matrixG[0] + inPix.y * _renderParams.G_matrixG[1] + inPix.z * _renderParams.G_matrixG[2]);
+        tempPix.z = (inPix.x * _renderParams.G_matrixB[0] + inPix.y * _renderParams.G_matrixB[1] + inPix.z * _renderParams.G_matrixB[2]);
+
+        // Lin to Log for grading
+        tempPix = LintoJPLog(tempPix);
+
+        // Grade node operation
+        float4 aGrade = G_mult * (G_gain - G_lift) / (1.0 - 0.0);
+        float4 bGrade = G_offset + G_lift - aGrade * 0.0;
+        float4 powBase = aGrade * tempPix + bGrade;
+        powBase = max(powBase, float4(0.0001));
+        tempPix = pow(powBase, 1.0/G_gamma);
+        tempPix = clamp(tempPix, 0.0, 100.0);
+
+        // Back to lin for output
+        tempPix = JPLogtoLin(tempPix);
+
+        // Perform saturation operation
+        float lumaPix = luma(tempPix);
+        tempPix = lumaPix + (_renderParams.saturation + 1.0) * (tempPix - lumaPix);
+
+        out[i * 4 + 0] = (_renderParams.bypass == 1 ? pixIn.x : _renderParams.gradeBypass == 1 ? pixOut.x : tempPix.x);
+        out[i * 4 + 1] = (_renderParams.bypass == 1 ? pixIn.y : _renderParams.gradeBypass == 1 ? pixOut.y : tempPix.y);
+        out[i * 4 + 2] = (_renderParams.bypass == 1 ? pixIn.z : _renderParams.gradeBypass == 1 ? pixOut.z : tempPix.z);
+        out[i * 4 + 3] = 1.0f;
+    }
+}
+
+//--- Grade Rows ---//
+/*
+    Run the inversion/grade stage for output
+    rows [y0, y1) into the job's output buffer.
+    Uses the baked grade if one was given, then
+    the widest SIMD kernel this machine has.
+*/
+void gradeRowsCPU(const cpuRenderJob& job, int y0, int y1, const bakedGrade* baked) {
+    const renderParams& _renderParams = job.params;
+    gradeKernelFn kernel = baked ? nullptr : activeGradeKernel();
+    gradeConsts consts;
+    if (kernel)
+        makeGradeConsts(_renderParams, consts);
+
+    auto gradeSpan = [&](const float* in, float* out, size_t count) {
+        if (baked)
+            gradePixelsLUT(*baked, in, out, count);
+        else if (kernel)
+            kernel(consts, in, out, count);
+        else
+            gradePixelsCPU(_renderParams, in, out, count);
     };
 
-    for (size_t i = 0; i < numThreads; i++) {
-        int startRow = i * rowsPerThread;
-        int endRow = (i == numThreads - 1) ? outputHeight : (i + 1) * rowsPerThread;
-        threads[i] = std::thread(processRows, startRow, endRow);
-    }
-
-    for (auto & thread : threads) {
-        thread.join();
-    }
-
-    ocioProc.processImage(procImgData, outputWidth, outputHeight, ocioSet);
-
-    // Process our curves after the ODT space for better feel
-    if (renderBypass != 1 && gradeBypass != 1) {
-        auto curveRows = [&](int startRow, int endRow) {
-            for (int y = startRow; y < endRow; y++) {
-                for (int x = 0; x < outputWidth; x++) {
-                    int index = ((y * outputWidth) + x) * 4;
-                    // RGB Curves
-                    procImgData[index + 0] = evalCurve(procImgData[index + 0], _renderParams.curveR, _renderParams.curveR_n);
-                    procImgData[index + 1] = evalCurve(procImgData[index + 1], _renderParams.curveG, _renderParams.curveG_n);
-                    procImgData[index + 2] = evalCurve(procImgData[index + 2], _renderParams.curveB, _renderParams.curveB_n);
-
-                    // Luma Curve
-                    procImgData[index + 0] = evalCurve(procImgData[index + 0], _renderParams.curveW, _renderParams.curveW_n);
-                    procImgData[index + 1] = evalCurve(procImgData[index + 1], _renderParams.curveW, _renderParams.curveW_n);
-                    procImgData[index + 2] = evalCurve(procImgData[index + 2], _renderParams.curveW, _renderParams.curveW_n);
-                }
-            }
-        };
-        std::vector<std::thread> curveThreads(numThreads);
-        for (size_t i = 0; i < numThreads; i++) {
-            int startRow = i * rowsPerThread;
-            int endRow = (i == numThreads - 1) ? outputHeight : (i + 1) * rowsPerThread;
-            curveThreads[i] = std::thread(curveRows, startRow, endRow);
+    if (!_renderParams.cropEnable) {
+        size_t offset = (size_t)y0 * job.outWidth * 4;
+        gradeSpan(job.src + offset, job.dst + offset, (size_t)(y1 - y0) * job.outWidth);
+        return;
+    }
+
+    // Crop/rotate resamples each row into scratch first.
+    // Pixels that land outside the source are left untouched.
+    std::vector<float> rowIn(job.outWidth * 4);
+    std::vector<float> rowOut(job.outWidth * 4);
+    std::vector<uint8_t> valid(job.outWidth);
+    for (int y = y0; y < y1; y++) {
+        for (int x = 0; x < job.outWidth; x++) {
+            // Convert output pixel to normalized UV coordinates [0, 1]
+            float u = ((float)x + 0.5f) / (float)job.outWidth;
+            float v = ((float)y + 0.5f) / (float)job.outHeight;
+
+            // Calculate input UV coordinates
+            float sampleU, sampleV;
+            getCroppedRotatedUV(u, v, sampleU, sampleV, _renderParams,
+                                job.srcWidth, job.srcHeight,    // input dimensions
+                                job.outWidth, job.outHeight);   // output dimensions
+            // Check if sample position is outside valid texture bounds
+            valid[x] = !(sampleU < 0.0f || sampleU > 1.0f || sampleV < 0.0f || sampleV > 1.0f);
+            float4 pixIn = valid[x] ? sampleImageMitchell(job.src, job.srcWidth, job.srcHeight,
+                                                          sampleU, sampleV) : float4(1.0f);
+            rowIn[x * 4 + 0] = pixIn.x;
+            rowIn[x * 4 + 1] = pixIn.y;
+            rowIn[x * 4 + 2] = pixIn.z;
+            rowIn[x * 4 + 3] = pixIn.w;
+        }
+        gradeSpan(rowIn.data(), rowOut.data(), job.outWidth);
+
+        float* dstRow = job.dst + (size_t)y * job.outWidth * 4;
+        for (int x = 0; x < job.outWidth; x++) {
+            if (valid[x])
+                std::copy_n(&rowOut[x * 4], 4, &dstRow[x * 4]);
         }
-        for (auto& t : curveThreads)
-            t.join();
     }
+}
+
+//--- Curve Pixels ---//
+/*
+    Apply the RGB curves followed by the
+    luma curve to a run of RGBA pixels
+*/
+void curvePixelsCPU(const curveLUTs& curves, float* pixels, size_t count) {
+    const compiledCurve& cW = curves.ch[CURVE_W];
+    const compiledCurve& cR = curves.ch[CURVE_R];
+    const compiledCurve& cG = curves.ch[CURVE_G];
+    const compiledCurve& cB = curves.ch[CURVE_B];
+    for (size_t i = 0; i < count; i++) {
+        float* pix = pixels + i * 4;
+        // RGB Curves
+        pix[0] = evalCompiledCurve(cR, pix[0]);
+        pix[1] = evalCompiledCurve(cG, pix[1]);
+        pix[2] = evalCompiledCurve(cB, pix[2]);
+
+        // Luma Curve
+        pix[0] = evalCompiledCurve(cW, pix[0]);
+        pix[1] = evalCompiledCurve(cW, pix[1]);
+        pix[2] = evalCompiledCurve(cW, pix[2]);
+    }
+}
+
+//--- Render CPU Tiles ---//
+/*
+    Fused CPU pipeline. The output is split into
+    bands of whole rows sized to stay in cache, and
+    each band runs grade -> display transform -> curves
+    before the next one is touched. Full-width bands
+    keep every stage operating on contiguous memory.
+    bandRows = 0 picks the band height from CPU_TILE_BYTES.
+*/
+void renderCPUTiles(const cpuRenderJob& job, const displayTransformFn& displayTransform, unsigned int bandRows) {
+    if (!job.src || !job.dst || job.outWidth < 1 || job.outHeight < 1)
+        return;
+
+    size_t rowBytes = (size_t)job.outWidth * 4 * sizeof(float);
+    if (bandRows == 0)
+        bandRows = std::max<size_t>(1, CPU_TILE_BYTES / rowBytes);
+    size_t bandCount = (job.outHeight + bandRows - 1) / bandRows;
+    bool applyCurves = job.params.bypass != 1 && job.params.gradeBypass != 1;
+    // Solve the splines once for the whole render
+    curveLUTs curves;
+    if (applyCurves)
+        compileCurves(job.params, curves);
+    // The baked grade beats the scalar and 4-wide kernels
+    std::shared_ptr<const bakedGrade> baked;
+    if (gradeLUTPreferred())
+        baked = cachedGradeLUT(job.params);
+
+    parallelFor(0, bandCount, 1, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; b++) {
+            int y0 = b * bandRows;
+            int y1 = std::min<int>(y0 + bandRows, job.outHeight);
+            float* band = job.dst + (size_t)y0 * job.outWidth * 4;
+
+            gradeRowsCPU(job, y0, y1, baked.get());
+            if (displayTransform)
+                displayTransform(band, job.outWidth, y1 - y0);
+            // Process our curves after the ODT space for better feel
+            if (applyCurves)
+                curvePixelsCPU(curves, band, (size_t)(y1 - y0) * job.outWidth);
+        }
+    });
+}
 
-    rndrW = outputWidth;
-    rndrH = outputHeight;
+//--- CPU Render ---//
+/*
+    Function to process images on CPU
+    rather than on GPU, settling the
+    ticket when done
+*/
+void image::processCPU(ocioSetting ocioSet, renderTicketPtr ticket) {
+    auto start = std::chrono::steady_clock::now();
+    if (!rawImgData) {
+        if (ticket)
+            ticket->fail("Image buffers not loaded");
+        return;
+    }
+    cpuRender = true;
+
+    cpuRenderJob job;
+    // Generate RenderParams struct
+    job.params = img_to_param(this);
+    job.params.arbitraryRotation = imgParam.arbitraryRotation * (M_PI / 180.0f);
+
+    job.srcWidth = fullIm ? rawWidth : width;
+    job.srcHeight = fullIm ? rawHeight : height;
+
+    job.outWidth = job.srcWidth;
+    job.outHeight = job.srcHeight;
+    if (imgParam.cropEnable) {
+        // Calculate crop rectangle dimensions
+        job.outWidth = (imgParam.imageCropMaxX - imgParam.imageCropMinX) * job.srcWidth;
+        job.outHeight = (imgParam.imageCropMaxY - imgParam.imageCropMinY) * job.srcHeight;
+
+        // Ensure minimum size
+        if (job.outWidth < 1) job.outWidth = 1;
+        if (job.outHeight < 1) job.outHeight = 1;
+    }
+    allocProcBuf();
+    job.src = rawImgData;
+    job.dst = procImgData;
+
+    LOG_INFO("Processing image {} on CPU with {} pool threads!", srcFilename, tPool ? tPool->size() : 1);
+
+    // Build the display transform once, apply it per band.
+    // Previews and JPEG proofs can use the baked LUT instead,
+    // its shaper clips below 2^-12 and above 2^6 so anything
+    // keeping more than 8 bits gets the exact processor.
+    std::shared_ptr<const displayLUT> lut;
+    if (appPrefs.prefs.cpuLUT && (!fullIm || displayProof))
+        lut = ocioProc.getDisplayLUT(ocioSet);
+    OCIO::ConstCPUProcessorRcPtr cpuProc = lut ? nullptr : ocioProc.getCPUProcessor(ocioSet);
+    renderCPUTiles(job, [&cpuProc, &lut](float* pixels, unsigned int w, unsigned int h) {
+        if (lut)
+            applyDisplayLUT(*lut, pixels, (size_t)w * h);
+        else if (cpuProc)
+            ocioProc.applyCPU(cpuProc, pixels, w, h);
+    });
+
+    rndrW = job.outWidth;
+    rndrH = job.outHeight;
 
     renderReady = true;
     cpuRender = false;
+    if (ticket)
+        ticket->complete();
     auto end = std::chrono::steady_clock::now();
     auto dur = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     LOG_INFO("Finished CPU processing {} in {}ms", srcFilename, dur.count()/1000);
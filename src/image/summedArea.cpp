@@ -0,0 +1,113 @@
+#include "summedArea.h"
+#include "threadPool.h"
+#include <algorithm>
+
+summedAreaTable::summedAreaTable(const summedAreaTable& other) {
+    m_table = other.get();
+}
+
+summedAreaTable& summedAreaTable::operator=(const summedAreaTable& other) {
+    if (this != &other) {
+        auto t = other.get();
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_table = std::move(t);
+    }
+    return *this;
+}
+
+std::shared_ptr<const summedAreaTable::table> summedAreaTable::get() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_table;
+}
+
+//--- Update ---//
+/*
+    Rows are prefix summed in parallel first,
+    then blocks of columns add the row above
+    going down, so both passes run along rows
+*/
+bool summedAreaTable::update(const float* rgba, unsigned int width, unsigned int height) {
+    auto cur = get();
+    if (cur && cur->src == rgba && cur->width == width && cur->height == height)
+        return false;
+    if (!rgba || width == 0 || height == 0) {
+        clear();
+        return false;
+    }
+
+    auto t = std::make_shared<table>();
+    t->src = rgba;
+    t->width = width;
+    t->height = height;
+    size_t stride = ((size_t)width + 1) * 3;
+    t->sums.assign(stride * ((size_t)height + 1), 0.0);
+    double* sums = t->sums.data();
+
+    // Row prefix sums into rows 1..height, column 0 stays zero
+    parallelFor(0, height, parallelGrain(height), [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; y++) {
+            const float* src = rgba + y * width * 4;
+            double* row = sums + (y + 1) * stride;
+            double acc[3] = {0.0, 0.0, 0.0};
+            for (size_t x = 0; x < width; x++) {
+                for (int ch = 0; ch < 3; ch++) {
+                    acc[ch] += src[x * 4 + ch];
+                    row[(x + 1) * 3 + ch] = acc[ch];
+                }
+            }
+        }
+    });
+
+    // Accumulate down the columns
+    size_t blockLen = 1024 * 3;
+    size_t blocks = (stride + blockLen - 1) / blockLen;
+    parallelFor(0, blocks, 1, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; b++) {
+            size_t i0 = b * blockLen;
+            size_t i1 = std::min(stride, i0 + blockLen);
+            for (size_t y = 2; y <= height; y++) {
+                double* row = sums + y * stride;
+                const double* above = row - stride;
+                for (size_t i = i0; i < i1; i++)
+                    row[i] += above[i];
+            }
+        }
+    });
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_table = std::move(t);
+    return true;
+}
+
+void summedAreaTable::clear() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_table.reset();
+}
+
+bool summedAreaTable::valid() const {
+    return get() != nullptr;
+}
+
+size_t summedAreaTable::bytes() const {
+    auto t = get();
+    return t ? t->sums.size() * sizeof(double) : 0;
+}
+
+//--- Box Mean ---//
+bool summedAreaTable::boxMean(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, float* rgb) const {
+    auto t = get();
+    if (!t || x0 > x1 || y0 > y1 || x1 >= t->width || y1 >= t->height)
+        return false;
+
+    size_t stride = ((size_t)t->width + 1) * 3;
+    const double* top = t->sums.data() + (size_t)y0 * stride;
+    const double* bottom = t->sums.data() + ((size_t)y1 + 1) * stride;
+    size_t l = (size_t)x0 * 3;
+    size_t r = ((size_t)x1 + 1) * 3;
+    double count = (double)(x1 - x0 + 1) * (double)(y1 - y0 + 1);
+    for (int ch = 0; ch < 3; ch++) {
+        double sum = bottom[r + ch] - bottom[l + ch] - top[r + ch] + top[l + ch];
+        rgb[ch] = sum / count;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef _summedarea_h
+#define _summedarea_h
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//--- Summed Area Table ---//
+/*
+    Integral image of the RGB channels of an RGBA
+    float buffer. Entry (x, y) holds the sum of every
+    pixel above and left of it, so the sum over any
+    axis-aligned box is four lookups.
+
+    Sums are kept in double, which is 24 bytes per
+    pixel, so it is only built on first use and
+    dropped along with the buffer it was built from.
+    A built table is immutable and shared, readers
+    keep theirs alive while a rebuild or clear swaps
+    in a new one.
+*/
+class summedAreaTable {
+    public:
+    summedAreaTable() = default;
+    summedAreaTable(const summedAreaTable& other);
+    summedAreaTable& operator=(const summedAreaTable& other);
+
+    // Build for this buffer unless it already is. Returns true if it rebuilt.
+    bool update(const float* rgba, unsigned int width, unsigned int height);
+    void clear();
+    bool valid() const;
+    size_t bytes() const;
+
+    // Mean RGB over the inclusive box [x0, x1] x [y0, y1].
+    // False if the table isn't built or the box is outside it.
+    bool boxMean(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, float* rgb) const;
+
+    private:
+    struct table {
+        const float* src = nullptr;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::vector<double> sums;   // (width + 1) * (height + 1) * 3
+    };
+    std::shared_ptr<const table> get() const;
+
+    mutable std::mutex m_lock;
+    std::shared_ptr<const table> m_table;
+};
+
+#endif
@@ -19,8 +19,9 @@ int main(void)
     appPrefs.loadFromFile();
 
     // Setup Threadpool
-    unsigned int numThreads = appPrefs.prefs.maxSimExports;
-    numThreads = numThreads < 1 ? 4 : numThreads > THREAD_LIMIT ? 4 : numThreads;
+    // Shared by import, analysis, CPU render and export kernels
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    numThreads = numThreads < 1 ? 4 : numThreads > THREAD_LIMIT ? THREAD_LIMIT : numThreads;
     LOG_INFO("Starting thread pool with {} threads", numThreads);
     tPool = new ThreadPool(numThreads);
 
@@ -0,0 +1,79 @@
+#ifndef _lrucache_h
+#define _lrucache_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+//--- LRU Cache ---//
+/*
+    Thread-safe map holding the most recently
+    used values, dropping the oldest once past
+    capacity. Values are copied out, so it suits
+    small handles like shared pointers.
+    Lookups are counted as hits or misses.
+*/
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class lruCache {
+    public:
+    explicit lruCache(size_t capacity) : m_capacity(capacity) {}
+
+    // Copies the value out and marks it most recent
+    bool find(const Key& key, Value& value) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            m_misses++;
+            return false;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        value = it->second->second;
+        m_hits++;
+        return true;
+    }
+
+    void insert(const Key& key, const Value& value) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            it->second->second = value;
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+        m_entries.emplace_front(key, value);
+        m_index[key] = m_entries.begin();
+        while (m_entries.size() > m_capacity) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_index.clear();
+        m_entries.clear();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_entries.size();
+    }
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+    private:
+    using entryList = std::list<std::pair<Key, Value>>;
+
+    size_t m_capacity;
+    std::mutex m_lock;
+    entryList m_entries;
+    std::unordered_map<Key, typename entryList::iterator, Hash> m_index;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+};
+
+#endif
@@ -125,6 +125,20 @@ std::string userPreferences::getPrefFile() {
     #endif
 }
 
+//--- Get Shader Cache Directory ---//
+/*
+    Get (and create) the folder holding the
+    program binaries saved by the GPU renderer
+*/
+std::string userPreferences::getShaderCacheDir() {
+    std::filesystem::path cacheDir = std::filesystem::path(getPrefFile()).parent_path() / "shaders";
+    std::error_code ec;
+    if (!std::filesystem::exists(cacheDir, ec))
+        if (!std::filesystem::create_directory(cacheDir, ec))
+            LOG_ERROR("Unable to create shader cache directory!");
+    return cacheDir.string();
+}
+
 //--- Display Release Notes ---//
 /*
     Checks the user preferences string against the
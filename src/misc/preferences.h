@@ -42,6 +42,8 @@ struct preferenceSet {
     // Histogram Settings - in-app
     float histInt = 0.75;
     bool histEnable = true;
+    // Pixels binned while renders are streaming in, 0 for all
+    int histSamples = 131072;
 
     std::array<float, 4> imageBGColor= {0.0588f, 0.0588f, 0.0588f, 0.9411f};
     std::array<float, 4> paramBGColor= {0.0588f, 0.0588f, 0.0588f, 0.9411f};
@@ -97,6 +99,9 @@ struct preferenceSet {
 
     unsigned long renderTimeout = 90000;
 
+    // GPU queue time per frame (ms), one render a frame at least
+    int renderBudgetMs = 8;
+
     // Contact Sheet border size
     float contactSheetBorder = 0.02f;
 
@@ -105,10 +110,21 @@ struct preferenceSet {
 
     // CPU renders (full renders only)
     bool cpuRender = false;
+    // Display transform from a baked 3D LUT on CPU renders
+    bool cpuLUT = false;
 
     // Hold onto files
     bool holdFilesinRAM = false;
 
+    // VRAM kept for proxy input textures (MB)
+    int inputTexVram = 1024;
+
+    // Keep linked display programs on disk between runs
+    bool shaderDiskCache = false;
+
+    // Buffer budget for batch analysis (MB)
+    int analysisRam = 4096;
+
     // Aspect ratio presets (shown in crop panel)
     std::array<aspectPreset, 6> cropPresets = {{
         {"6x7",  1.200f},
@@ -126,11 +142,11 @@ struct preferenceSet {
 
 
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(preferenceSet, undoLevels,
-        autoSave, autoSFreq, histInt, histEnable, trackpadMode,
+        autoSave, autoSFreq, histInt, histEnable, histSamples, trackpadMode,
         viewerSetting, pixelScale, perfMode, maxRes, rollTimeout, debayerMode, maxSimExports,
         ocioPath, ocioExt, gamutComp, showStats, altGrades, cmykSliders, colorPicker,
-        autoSort, proxyRes, renderTimeout, contactSheetBorder, verString, cpuRender,
-        minOffset, imageBGColor, paramBGColor, thumbBGColor, holdFilesinRAM, cropPresets,
+        autoSort, proxyRes, renderTimeout, renderBudgetMs, contactSheetBorder, verString, cpuRender, cpuLUT,
+        minOffset, imageBGColor, paramBGColor, thumbBGColor, holdFilesinRAM, inputTexVram, shaderDiskCache, analysisRam, cropPresets,
         clickThrough, lastCheck, lastFound);
 };
 
@@ -144,6 +160,8 @@ class userPreferences {
     void loadFromFile();
     void saveToFile();
     bool displayReleaseNotes();
+    // Folder next to the preferences file for cached GPU programs
+    std::string getShaderCacheDir();
 
 
     bool tmpAutoSave = false;
@@ -10,6 +10,7 @@
 #define BLOCK_DIM 16
 #define MINLOG 0.0001f
 #define CURVE_MAX_PTS 16   // maximum control points per curve channel
+#define CPU_TILE_BYTES (512 * 1024) // working set per band in the fused CPU render
 
 
 
@@ -0,0 +1,100 @@
+#ifndef _renderticket_h
+#define _renderticket_h
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum renderStatus {
+    rs_pending = 0,
+    rs_done = 1,
+    rs_failed = 2,
+    rs_cancelled = 3
+};
+
+//--- Render Ticket ---//
+/*
+    Handed out for each render request and
+    settled once by whoever finishes it: the
+    GPU queue, the readback that lands the
+    pixels, or a CPU render. The first outcome
+    sticks, later ones are ignored.
+
+    When the queue folds a request into a newer
+    one for the same image, the older ticket is
+    chained onto the newer and settles with it.
+*/
+class renderTicket {
+    public:
+        void complete() { settle(rs_done, ""); }
+        void fail(const std::string& error) { settle(rs_failed, error); }
+        void cancel() { settle(rs_cancelled, "Render cancelled"); }
+
+        // Settle next the same way as this one
+        void chain(const std::shared_ptr<renderTicket>& next) {
+            if (!next || next.get() == this)
+                return;
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (m_status == rs_pending) {
+                m_chained.push_back(next);
+                return;
+            }
+            renderStatus status = m_status;
+            std::string error = m_error;
+            lock.unlock();
+            next->settle(status, error);
+        }
+
+        renderStatus wait() {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_settled.wait(lock, [this] { return m_status != rs_pending; });
+            return m_status;
+        }
+
+        // rs_pending if it timed out
+        template <typename Rep, typename Period>
+        renderStatus waitFor(const std::chrono::duration<Rep, Period>& timeout) {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_settled.wait_for(lock, timeout, [this] { return m_status != rs_pending; });
+            return m_status;
+        }
+
+        renderStatus status() {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_status;
+        }
+
+        std::string error() {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_error;
+        }
+
+    private:
+        void settle(renderStatus status, const std::string& error) {
+            std::vector<std::shared_ptr<renderTicket>> chained;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_status != rs_pending)
+                    return;
+                m_status = status;
+                m_error = error;
+                chained.swap(m_chained);
+            }
+            m_settled.notify_all();
+            for (auto& next : chained)
+                next->settle(status, error);
+        }
+
+        std::mutex m_lock;
+        std::condition_variable m_settled;
+        renderStatus m_status = rs_pending;
+        std::string m_error;
+        std::vector<std::shared_ptr<renderTicket>> m_chained;
+};
+
+using renderTicketPtr = std::shared_ptr<renderTicket>;
+
+#endif
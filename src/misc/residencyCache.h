@@ -0,0 +1,129 @@
+#ifndef _residencycache_h
+#define _residencycache_h
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//--- Residency Cache ---//
+/*
+    LRU bookkeeping for resources that cost
+    bytes somewhere else (GPU memory, say).
+    It only tracks sizes and order: whatever
+    falls out of the byte budget is handed
+    back so the owner can free it. The most
+    recent entry is never evicted, even when
+    it is larger than the budget on its own.
+
+    Not thread-safe, meant for the thread that
+    owns the resources.
+*/
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class residencyCache {
+    public:
+    explicit residencyCache(uint64_t budget) : m_budget(budget) {}
+
+    // Marks the entry most recent, nullptr if absent
+    Value* find(const Key& key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            m_misses++;
+            return nullptr;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        m_hits++;
+        return &it->second->value;
+    }
+
+    // Look without touching the order or the counts
+    const Value* peek(const Key& key) const {
+        auto it = m_index.find(key);
+        return it == m_index.end() ? nullptr : &it->second->value;
+    }
+
+    // Add (or replace) an entry, returns the value it replaced
+    // and whatever no longer fits
+    std::vector<Value> insert(const Key& key, const Value& value, uint64_t bytes) {
+        std::vector<Value> evicted;
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_bytes -= it->second->bytes;
+            evicted.push_back(it->second->value);
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+        m_entries.push_front({key, value, bytes});
+        m_index[key] = m_entries.begin();
+        m_bytes += bytes;
+        trim(evicted);
+        return evicted;
+    }
+
+    // Drop one entry, true and its value if it was there
+    bool erase(const Key& key, Value& value) {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+            return false;
+        value = it->second->value;
+        m_bytes -= it->second->bytes;
+        m_entries.erase(it->second);
+        m_index.erase(it);
+        return true;
+    }
+
+    std::vector<Value> setBudget(uint64_t budget) {
+        std::vector<Value> evicted;
+        m_budget = budget;
+        trim(evicted);
+        return evicted;
+    }
+
+    std::vector<Value> clear() {
+        std::vector<Value> all;
+        for (auto& entry : m_entries)
+            all.push_back(entry.value);
+        m_entries.clear();
+        m_index.clear();
+        m_bytes = 0;
+        return all;
+    }
+
+    size_t size() const { return m_entries.size(); }
+    uint64_t bytes() const { return m_bytes; }
+    uint64_t budget() const { return m_budget; }
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+    uint64_t evictions() const { return m_evictions; }
+
+    private:
+    struct entry {
+        Key key;
+        Value value;
+        uint64_t bytes;
+    };
+    using entryList = std::list<entry>;
+
+    void trim(std::vector<Value>& evicted) {
+        while (m_bytes > m_budget && m_entries.size() > 1) {
+            entry& last = m_entries.back();
+            m_bytes -= last.bytes;
+            evicted.push_back(last.value);
+            m_index.erase(last.key);
+            m_entries.pop_back();
+            m_evictions++;
+        }
+    }
+
+    uint64_t m_budget;
+    uint64_t m_bytes = 0;
+    entryList m_entries;
+    std::unordered_map<Key, typename entryList::iterator, Hash> m_index;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+};
+
+#endif
@@ -2,39 +2,176 @@
 #include <condition_variable>
 #include <functional>
 #include <atomic>
+#include <exception>
 #include "threadPool.h"
 
 // Global Threadpool
 ThreadPool *tPool;
 
+// Which pool (and which slot in it) the current thread works for
+static thread_local ThreadPool* t_pool = nullptr;
+static thread_local size_t t_index = 0;
+
 ThreadPool::ThreadPool(size_t numThreads) {
     for (size_t i = 0; i < numThreads; ++i)
-        workers.emplace_back([this]() { this->workerLoop(); });
+        localQueues.emplace_back(std::make_unique<workQueue>());
+    for (size_t i = 0; i < numThreads; ++i)
+        workers.emplace_back([this, i]() { this->workerLoop(i); });
 }
 
-void ThreadPool::workerLoop() {
-    while (!stop) {
-        std::function<void()> task;
-
-        {
-            std::unique_lock lock(queueMutex);
-            condition.wait(lock, [this]() {
-                return stop || !tasks.empty();
-            });
+bool ThreadPool::isWorkerThread() const {
+    return t_pool == this;
+}
 
-            if (stop && tasks.empty())
-                return;
+//--- Enqueue ---//
+/*
+    Push onto the local deque when called from
+    one of our workers, otherwise onto the shared
+    injection queue.
+*/
+void ThreadPool::enqueue(std::function<void()> task) {
+    // Count before publishing so a waking worker never misses it
+    {
+        std::lock_guard lock(queueMutex);
+        pending++;
+        if (!isWorkerThread())
+            tasks.emplace_back(std::move(task));
+    }
+    if (isWorkerThread()) {
+        std::lock_guard lock(localQueues[t_index]->lock);
+        localQueues[t_index]->tasks.emplace_back(std::move(task));
+    }
+    condition.notify_one();
+}
 
+//--- Pop Task ---//
+/*
+    Own deque (newest first), then the shared
+    queue, then steal the oldest task from
+    another worker.
+*/
+bool ThreadPool::popTask(size_t index, std::function<void()>& task) {
+    {
+        std::lock_guard lock(localQueues[index]->lock);
+        if (!localQueues[index]->tasks.empty()) {
+            task = std::move(localQueues[index]->tasks.back());
+            localQueues[index]->tasks.pop_back();
+            pending--;
+            return true;
+        }
+    }
+    {
+        std::lock_guard lock(queueMutex);
+        if (!tasks.empty()) {
             task = std::move(tasks.front());
-            tasks.pop();
+            tasks.pop_front();
+            pending--;
+            return true;
         }
+    }
+    for (size_t i = 1; i < localQueues.size(); i++) {
+        workQueue& victim = *localQueues[(index + i) % localQueues.size()];
+        std::unique_lock lock(victim.lock, std::try_to_lock);
+        if (lock.owns_lock() && !victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending--;
+            return true;
+        }
+    }
+    return false;
+}
 
-        task();
+void ThreadPool::workerLoop(size_t index) {
+    t_pool = this;
+    t_index = index;
+    while (true) {
+        std::function<void()> task;
+        if (popTask(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock lock(queueMutex);
+        if (stop && pending == 0)
+            return;
+        // Short timeout covers a steal that lost a try_lock race
+        condition.wait_for(lock, std::chrono::milliseconds(5), [this]() {
+            return stop || pending > 0;
+        });
+    }
+}
+
+//--- Run Parallel ---//
+/*
+    Shared state for one parallelFor call. Helpers
+    are queued to the pool, and all of them (plus
+    the caller) claim chunks until none are left.
+    A helper that starts after the range is
+    finished exits without touching the body.
+*/
+struct rangeJob {
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    size_t grain = 1;
+    size_t chunks = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> remaining{0};
+    std::mutex doneLock;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    void run() {
+        while (true) {
+            size_t chunk = next.fetch_add(1);
+            if (chunk >= chunks)
+                return;
+            size_t b = begin + chunk * grain;
+            size_t e = std::min(b + grain, end);
+            try {
+                (*body)(b, e);
+            } catch (...) {
+                std::lock_guard lock(doneLock);
+                if (!error)
+                    error = std::current_exception();
+            }
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard lock(doneLock);
+                done.notify_all();
+            }
+        }
     }
+};
+
+void ThreadPool::runParallel(size_t begin, size_t end, size_t grain,
+    const std::function<void(size_t, size_t)>& body) {
+    auto job = std::make_shared<rangeJob>();
+    job->body = &body;
+    job->begin = begin;
+    job->end = end;
+    job->grain = grain;
+    job->chunks = (end - begin + grain - 1) / grain;
+    job->remaining = job->chunks;
+
+    // The caller takes a share itself, so one less helper is needed
+    size_t helpers = std::min(job->chunks - 1, workers.size());
+    for (size_t i = 0; i < helpers; i++)
+        enqueue([job]() { job->run(); });
+
+    job->run();
+
+    std::unique_lock lock(job->doneLock);
+    job->done.wait(lock, [&job]() { return job->remaining == 0; });
+    if (job->error)
+        std::rethrow_exception(job->error);
 }
 
 ThreadPool::~ThreadPool() {
-    stop = true;
+    {
+        std::lock_guard lock(queueMutex);
+        stop = true;
+    }
     condition.notify_all();
     for (auto& t : workers)
         t.join();
@@ -3,10 +3,38 @@
 
 #include <vector>
 #include <mutex>
-#include <queue>
+#include <deque>
+#include <memory>
 #include <future>
 #include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
 
+// A rectangular region handed to a tiled parallel loop
+// [x0, x1) x [y0, y1) in pixels
+struct tileRange {
+    unsigned int x0 = 0;
+    unsigned int y0 = 0;
+    unsigned int x1 = 0;
+    unsigned int y1 = 0;
+};
+
+//--- Work-stealing Thread Pool ---//
+/*
+    Every worker owns a local deque. Tasks submitted
+    from a worker go onto its own deque (LIFO for the owner),
+    idle workers steal from the front of the others.
+    Tasks submitted from outside the pool go through a
+    shared injection queue.
+
+    parallelFor splits a range into grain-sized chunks
+    that are claimed through an atomic counter. The calling
+    thread always works on the range itself, so nested
+    parallel loops (a kernel running inside a pool task)
+    can never deadlock waiting on busy workers.
+*/
 class ThreadPool {
 public:
     explicit ThreadPool(size_t numThreads);
@@ -17,15 +45,39 @@ public:
     auto submit(Func&& func, Args&&... args)
         -> std::future<std::invoke_result_t<Func, Args...>>;
 
+    // Call func(chunkBegin, chunkEnd) over [begin, end) in grain-sized chunks
+    // Blocks until every chunk has finished
+    template<typename Func>
+    void parallelFor(size_t begin, size_t end, size_t grain, Func&& func);
+
+    // Call func(tileRange) for every tileW x tileH tile of a width x height region
+    template<typename Func>
+    void parallelForTiles(unsigned int width, unsigned int height,
+        unsigned int tileW, unsigned int tileH, Func&& func);
+
+    size_t size() const { return workers.size(); }
+    bool isWorkerThread() const;
+
 private:
+    struct workQueue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    std::vector<std::unique_ptr<workQueue>> localQueues;
+    std::deque<std::function<void()>> tasks;
 
     std::mutex queueMutex;
     std::condition_variable condition;
     std::atomic<bool> stop{false};
+    std::atomic<size_t> pending{0};
 
-    void workerLoop();
+    void workerLoop(size_t index);
+    void enqueue(std::function<void()> task);
+    bool popTask(size_t index, std::function<void()>& task);
+    void runParallel(size_t begin, size_t end, size_t grain,
+        const std::function<void(size_t, size_t)>& body);
 };
 
 template<typename Func, typename... Args>
@@ -39,14 +91,83 @@ auto ThreadPool::submit(Func&& func, Args&&... args)
     );
 
     std::future<return_type> result = task->get_future();
-    {
-        std::lock_guard lock(queueMutex);
-        tasks.emplace([task]() { (*task)(); });
-    }
-    condition.notify_one();
+    enqueue([task]() { (*task)(); });
     return result;
 }
 
+template<typename Func>
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, Func&& func) {
+    if (end <= begin)
+        return;
+    grain = std::max<size_t>(grain, 1);
+    if (end - begin <= grain || workers.empty()) {
+        // Not worth splitting
+        func(begin, end);
+        return;
+    }
+    runParallel(begin, end, grain, [&func](size_t b, size_t e) { func(b, e); });
+}
+
+template<typename Func>
+void ThreadPool::parallelForTiles(unsigned int width, unsigned int height,
+    unsigned int tileW, unsigned int tileH, Func&& func) {
+    if (width == 0 || height == 0)
+        return;
+    tileW = std::max(1u, std::min(tileW, width));
+    tileH = std::max(1u, std::min(tileH, height));
+    size_t tilesX = (width + tileW - 1) / tileW;
+    size_t tilesY = (height + tileH - 1) / tileH;
+
+    parallelFor(0, tilesX * tilesY, 1, [&](size_t t0, size_t t1) {
+        for (size_t t = t0; t < t1; t++) {
+            tileRange tile;
+            tile.x0 = (t % tilesX) * tileW;
+            tile.y0 = (t / tilesX) * tileH;
+            tile.x1 = std::min(tile.x0 + tileW, width);
+            tile.y1 = std::min(tile.y0 + tileH, height);
+            func(tile);
+        }
+    });
+}
+
 extern ThreadPool *tPool;
 
+//--- Global Pool Helpers ---//
+/*
+    Kernels go through these so they run on the
+    shared pool when it exists, and inline on the
+    calling thread when it doesn't (tests, tools)
+*/
+
+// Grain giving roughly 4 chunks per pool thread
+inline size_t parallelGrain(size_t count, size_t minGrain = 1) {
+    size_t threads = tPool ? std::max<size_t>(tPool->size(), 1) : 1;
+    return std::max(minGrain, count / (threads * 4));
+}
+
+template<typename Func>
+void parallelFor(size_t begin, size_t end, size_t grain, Func&& func) {
+    if (tPool)
+        tPool->parallelFor(begin, end, grain, std::forward<Func>(func));
+    else if (end > begin)
+        func(begin, end);
+}
+
+template<typename Func>
+void parallelForTiles(unsigned int width, unsigned int height,
+    unsigned int tileW, unsigned int tileH, Func&& func) {
+    if (tPool) {
+        tPool->parallelForTiles(width, height, tileW, tileH, std::forward<Func>(func));
+        return;
+    }
+    tileW = std::max(1u, tileW);
+    tileH = std::max(1u, tileH);
+    for (unsigned int y = 0; y < height; y += tileH) {
+        for (unsigned int x = 0; x < width; x += tileW) {
+            tileRange tile{x, y, std::min(x + tileW, width), std::min(y + tileH, height)};
+            func(tile);
+        }
+    }
+}
+
 #endif
@@ -1,12 +1,36 @@
 #include "utils.h"
+#include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <cstdio>
 
 
 
 int iDivUp(int a, int b) { return (a % b != 0) ? (a / b + 1) : (a / b); }
 
 
+// Winding contribution of one quad edge for the ray
+// from (x, y) to the right: +1 up, -1 down, 0 misses
+static int edgeWinding(const xyPoint& current, const xyPoint& next, float x, float y) {
+    // Check if the edge crosses the ray from the test point to the right
+    if (current.y <= y) {
+        if (next.y > y &&
+            ((next.x - current.x) * (y - current.y) -
+             (next.y - current.y) * (x - current.x)) > 0) {
+            // Ray crosses upward edge
+            return 1;
+        }
+    } else {
+        if (next.y <= y &&
+            ((next.x - current.x) * (y - current.y) -
+             (next.y - current.y) * (x - current.x)) < 0) {
+            // Ray crosses downward edge
+            return -1;
+        }
+    }
+    return 0;
+}
+
 bool isPointInBox(const unsigned int& x, const unsigned int& y, const unsigned int* xPoints, const unsigned int* yPoints) {
     // For a non-axis-aligned box (arbitrary quadrilateral)
     // We'll use the winding number algorithm
@@ -18,29 +42,86 @@ bool isPointInBox(const unsigned int& x, const unsigned int& y, const unsigned i
         // Get the current point and the next point (wrapping around to the first point)
         xyPoint current(static_cast<float>(xPoints[i]), static_cast<float>(yPoints[i]));
         xyPoint next(static_cast<float>(xPoints[(i + 1) % 4]), static_cast<float>(yPoints[(i + 1) % 4]));
-
-        // Check if the edge crosses the ray from the test point to the right
-        if (current.y <= y) {
-            if (next.y > y &&
-                ((next.x - current.x) * (y - current.y) -
-                 (next.y - current.y) * (x - current.x)) > 0) {
-                // Ray crosses upward edge
-                ++winding_number;
-            }
-        } else {
-            if (next.y <= y &&
-                ((next.x - current.x) * (y - current.y) -
-                 (next.y - current.y) * (x - current.x)) < 0) {
-                // Ray crosses downward edge
-                --winding_number;
-            }
-        }
+        winding_number += edgeWinding(current, next, x, y);
     }
 
     // If winding number is non-zero, the point is inside
     return winding_number != 0;
 }
 
+//--- Crop Box Spans ---//
+/*
+    Scanline version of isPointInBox. On a row,
+    an edge the row crosses counts for every x
+    left of its crossing, so each edge only needs
+    the first x it stops counting at. That is
+    estimated from the line, then stepped with
+    the same test isPointInBox uses so both agree
+    on every pixel.
+*/
+void cropBoxSpans(const unsigned int* xPoints, const unsigned int* yPoints,
+                  unsigned int width, unsigned int height, std::vector<rowSpan>& spans) {
+    spans.clear();
+    if (!xPoints || !yPoints || width == 0)
+        return;
+
+    xyPoint pts[4];
+    float yMin = yPoints[0], yMax = yPoints[0];
+    for (int i = 0; i < 4; i++) {
+        pts[i] = xyPoint(static_cast<float>(xPoints[i]), static_cast<float>(yPoints[i]));
+        yMin = std::min(yMin, pts[i].y);
+        yMax = std::max(yMax, pts[i].y);
+    }
+
+    unsigned int yEnd = std::min<float>(height, yMax + 1.0f);
+    for (unsigned int y = (unsigned int)yMin; y < yEnd; y++) {
+        float fy = y;
+        int edgeCount = 0;
+        int dir[4];
+        unsigned int stop[4];
+        for (int i = 0; i < 4; i++) {
+            const xyPoint& c = pts[i];
+            const xyPoint& n = pts[(i + 1) % 4];
+            bool up = c.y <= fy && n.y > fy;
+            bool down = c.y > fy && n.y <= fy;
+            if (!up && !down)
+                continue;
+
+            // First x this edge no longer counts at
+            double cross = c.x + (double)(n.x - c.x) * (fy - c.y) / (n.y - c.y);
+            long long t = std::clamp<long long>((long long)std::ceil(cross), 0, width);
+            while (t > 0 && edgeWinding(c, n, t - 1, fy) == 0)
+                t--;
+            while (t < width && edgeWinding(c, n, t, fy) != 0)
+                t++;
+            dir[edgeCount] = up ? 1 : -1;
+            stop[edgeCount] = t;
+            edgeCount++;
+        }
+
+        // Walk the intervals between stops, the winding is constant inside each
+        unsigned int bounds[6] = {0, width};
+        int boundCount = 2;
+        for (int e = 0; e < edgeCount; e++)
+            bounds[boundCount++] = stop[e];
+        std::sort(bounds, bounds + boundCount);
+        for (int b = 0; b + 1 < boundCount; b++) {
+            unsigned int x0 = bounds[b], x1 = bounds[b + 1];
+            if (x0 == x1)
+                continue;
+            int winding = 0;
+            for (int e = 0; e < edgeCount; e++)
+                winding += x0 < stop[e] ? dir[e] : 0;
+            if (winding == 0)
+                continue;
+            if (!spans.empty() && spans.back().y == y && spans.back().x1 == x0)
+                spans.back().x1 = x1;
+            else
+                spans.push_back({y, x0, x1});
+        }
+    }
+}
+
 
 float Luma(float R, float G, float B)
 {
@@ -204,3 +285,31 @@ uint64_t currentEpoch() {
     auto now = std::chrono::system_clock::now();
     return std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
 }
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void stageTimer::mark(const std::string& name) {
+    auto now = std::chrono::steady_clock::now();
+    m_stages.emplace_back(name, std::chrono::duration<double, std::milli>(now - m_last).count());
+    m_last = now;
+}
+
+std::string stageTimer::summary() const {
+    std::string out;
+    char buf[32];
+    for (const auto& stage : m_stages) {
+        std::snprintf(buf, sizeof(buf), " %.0fms, ", stage.second);
+        out += stage.first + buf;
+    }
+    std::snprintf(buf, sizeof(buf), "total %.0fms",
+                  std::chrono::duration<double, std::milli>(m_last - m_start).count());
+    return out + buf;
+}
@@ -2,7 +2,11 @@
 #define _utils_h
 #include "structs.h"
 #include <stdint.h>
+#include <chrono>
 #include <csignal>
+#include <string>
+#include <utility>
+#include <vector>
 
 #define KERNELSIZE 6
 
@@ -17,6 +21,19 @@ struct xyPoint {
 int iDivUp(int a, int b);
 
 bool isPointInBox(const unsigned int& x, const unsigned int& y, const unsigned int* xPoints, const unsigned int* yPoints);
+
+// Pixels [x0, x1) of row y
+struct rowSpan {
+    unsigned int y;
+    unsigned int x0;
+    unsigned int x1;
+};
+
+// The pixels of a width x height image that isPointInBox accepts,
+// as spans sorted by row then x. Empty rows have no span, a
+// self-crossing quad can give more than one span on a row.
+void cropBoxSpans(const unsigned int* xPoints, const unsigned int* yPoints,
+                  unsigned int width, unsigned int height, std::vector<rowSpan>& spans);
 float Luma(float R, float G, float B);
 
 
@@ -31,4 +48,24 @@ void computeKernels(float strength, float* kernels);
 void checkRawFile(rawSetting& rawSet, long fileSize);
 
 uint64_t currentEpoch();
+
+// Time between marks, for breaking a sequence
+// of steps (like startup) down in the log
+class stageTimer {
+    public:
+    stageTimer() : m_start(std::chrono::steady_clock::now()), m_last(m_start) {}
+
+    // Close the stage running since the last mark
+    void mark(const std::string& name);
+    // "name 12ms, name 3ms, total 15ms"
+    std::string summary() const;
+
+    private:
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_last;
+    std::vector<std::pair<std::string, double>> m_stages;
+};
+
+// FNV-1a over raw bytes, chain calls through seed
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
 #endif
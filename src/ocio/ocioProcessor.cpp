@@ -4,40 +4,35 @@
 #include "OpenColorIO/OpenColorTypes.h"
 #include "logger.h"
 #include "structs.h"
+#include "threadPool.h"
+#include <chrono>
 #include <cstring>
+#include <filesystem>
 #include <istream>
 
 ocioProcessor ocioProc;
 
 //--- Add Config ---//
 /*
-    Verify a configuration provided as a string
-    and add it to the valid congfigs vector
+    Register a configuration provided as a string.
+    Unless deferred it is parsed and verified now,
+    and dropped again if it is not valid.
 */
-bool ocioProcessor::addConfig(std::string &configFile, std::string configName) {
+bool ocioProcessor::addConfig(std::string &configFile, std::string configName, bool deferred) {
     ocioConfig newConfig;
-    try {
-        // Load config from the memory stream
-        std::istringstream is(configFile);
-        newConfig.config = OCIO::Config::CreateFromStream(is);
-
-        // Sanity check the config
-        newConfig.config->validate();
-        newConfig.configName = configName;
-
-        LOG_INFO("Successfully loaded OCIO config {}", configName);
+    newConfig.configName = configName;
+    newConfig.source = configFile;
+    m_configs.push_back(newConfig);
+    clearProcessorCache();
 
-    } catch (const OCIO::Exception& e) {
-        LOG_ERROR("Error loading OCIO config: {}", e.what());
-        return false;
+    if (deferred) {
+        LOG_INFO("Registered OCIO config {}, parsing on first use", configName);
+        return true;
     }
-
-    if (!newConfig.config) {
-        LOG_ERROR("No OCIO config loaded");
+    if (!loadConfig(m_configs.back())) {
+        m_configs.pop_back();
         return false;
     }
-    loadNames(newConfig);
-    m_configs.push_back(newConfig);
     return true;
 }
 
@@ -46,27 +41,139 @@ bool ocioProcessor::addConfig(std::string &configFile, std::string configName) {
     Attempt to add the config at the provided
     path to the vector
 */
-bool ocioProcessor::initExtConfig(std::string path) {
+bool ocioProcessor::initExtConfig(std::string path, bool deferred) {
     ocioConfig newConfig;
-    try {
-        // Load config from file
-        newConfig.config = OCIO::Config::CreateFromFile(path.c_str());
+    newConfig.configName = std::filesystem::path(path).stem().string();
+    newConfig.source = path;
+    newConfig.fromFile = true;
+    externalConfigPath = path;
+    m_configs.push_back(newConfig);
+    clearProcessorCache();
 
-        // Sanity check the config
-        newConfig.config->validate();
+    if (deferred) {
+        // Checked by settleExternalConfig once it has been parsed
+        m_pendingExternal = (int)m_configs.size() - 1;
+        LOG_INFO("Registered OCIO config {}, parsing on first use", path);
+        return true;
+    }
+    if (!loadConfig(m_configs.back())) {
+        m_configs.pop_back();
+        return false;
+    }
+    validExternal = true;
+    m_configs.back().configName = m_configs.back().config->getName();
+    return true;
+}
 
-        LOG_INFO("Successfully loaded OCIO config from file");
-        externalConfigPath = path;
+//--- Load Config ---//
+/*
+    Parse and verify a registered config the
+    first time it is needed. Safe to call from
+    the pool, a second caller waits for the
+    first parse. Returns false if it is invalid.
+*/
+bool ocioProcessor::loadConfig(ocioConfig& config) {
+    std::call_once(*config.parsed, [&]() {
+        auto start = std::chrono::steady_clock::now();
+        config.attempted = true;
+        OCIO::ConstConfigRcPtr parsed;
+        try {
+            if (config.fromFile) {
+                // Load config from file
+                parsed = OCIO::Config::CreateFromFile(config.source.c_str());
+            } else {
+                // Load config from the memory stream
+                std::istringstream is(config.source);
+                parsed = OCIO::Config::CreateFromStream(is);
+            }
+
+            // Sanity check the config
+            parsed->validate();
+
+        } catch (const OCIO::Exception& e) {
+            LOG_ERROR("Error loading OCIO config: {}", e.what());
+            config.error = e.what();
+            return;
+        }
+
+        if (!parsed) {
+            LOG_ERROR("No OCIO config loaded");
+            config.error = "No OCIO config loaded";
+            return;
+        }
+        config.config = parsed;
+        loadNames(config);
+        config.source.clear();
+
+        auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        LOG_INFO("Successfully loaded OCIO config {} in {}ms", config.configName, dur.count());
+    });
+    return config.config != nullptr;
+}
+
+//--- Preload Configs ---//
+/*
+    Parse the configs nobody has asked for yet
+    in the background, so switching to one later
+    does not stall a frame
+*/
+void ocioProcessor::preloadConfigs() {
+    if (!tPool)
+        return;
+    // Parsed ones return straight out of loadConfig
+    for (auto& config : m_configs) {
+        ocioConfig* pending = &config;
+        m_preloading++;
+        tPool->submit([this, pending]() {
+            loadConfig(*pending);
+            m_preloading--;
+        });
+    }
+}
+
+//--- Settle External Config ---//
+/*
+    A deferred external config can only be judged
+    after its first parse. Once that has run, and
+    no preload still holds a pointer into the list,
+    an invalid one is removed so it is no longer
+    offered. A valid one takes its config's name,
+    like an external config parsed up front.
+*/
+bool ocioProcessor::settleExternalConfig(std::string& error) {
+    if (m_pendingExternal < 0 || m_preloading.load() > 0)
+        return true;
+    ocioConfig& config = m_configs[m_pendingExternal];
+    if (!config.attempted)
+        return true;
+
+    int index = m_pendingExternal;
+    m_pendingExternal = -1;
+    if (config.config) {
         validExternal = true;
-        newConfig.configName = newConfig.config->getName();
+        config.configName = config.config->getName();
+        return true;
+    }
 
-    } catch (const OCIO::Exception& e) {
-        LOG_ERROR("Error loading OCIO config: {}", e.what());
-        return false;
+    error = config.error.empty() ? "Unable to parse the config" : config.error;
+    LOG_WARN("Removing invalid OCIO config {}", externalConfigPath);
+    // Configs are only ever appended, so it's still the last one
+    if (index == (int)m_configs.size() - 1 && selectedConfig != index) {
+        m_configs.pop_back();
+        clearProcessorCache();
     }
-    loadNames(newConfig);
-    m_configs.push_back(newConfig);
-    return true;
+    return false;
+}
+
+//--- Config At ---//
+/*
+    The parsed config at an index, parsing it
+    now if needed. nullptr if it is invalid.
+*/
+OCIO::ConstConfigRcPtr ocioProcessor::configAt(int id) {
+    if (id < 0 || id >= (int)m_configs.size() || !loadConfig(m_configs[id]))
+        return nullptr;
+    return m_configs[id].config;
 }
 
 //--- Load Names ---//
@@ -105,22 +212,34 @@ void ocioProcessor::loadNames(ocioConfig& config) {
 
 //--- Set Active Config ---//
 /*
-    Set the active config based on the index
+    Set the active config based on the index,
+    -1 is the last one added. Returns false and
+    keeps the current one if it does not parse.
 */
-void ocioProcessor::setActiveConfig(int id) {
-    if (id < m_configs.size() && id >= 0) {
-        // We have a valid id selection
-        OCIO::SetCurrentConfig(m_configs[id].config);
-        selectedConfig = id;
-    }
-
+bool ocioProcessor::setActiveConfig(int id) {
     if (id == -1) {
         // Startup instance where we want to
         // set the external config (last config
         // in the vector) active
-        OCIO::SetCurrentConfig(m_configs.back().config);
-        selectedConfig = m_configs.size() - 1;
+        id = (int)m_configs.size() - 1;
     }
+
+    OCIO::ConstConfigRcPtr config = configAt(id);
+    if (!config)
+        return false;
+    OCIO::SetCurrentConfig(config);
+    selectedConfig = id;
+    return true;
+}
+
+//--- Active Config ---//
+/*
+    The selected config. Already parsed when it
+    was made active, so this is just the check.
+*/
+ocioConfig* ocioProcessor::activeConfig() {
+    loadConfig(m_configs[selectedConfig]);
+    return &m_configs[selectedConfig];
 }
 
 //--- Get Config List ---//
@@ -137,44 +256,75 @@ std::vector<std::string> ocioProcessor::getConfigList() {
 
 //--- Get Config Names ---//
 /*
-    Get list of full config names
+    Get list of full config names, parsing
+    any config still waiting
 */
 std::vector<std::string> ocioProcessor::getConfigNames() {
     std::vector<std::string> list;
     for (auto &config : m_configs) {
-        list.push_back(config.config->getName());
+        list.push_back(loadConfig(config) ? config.config->getName() : "");
     }
     return list;
 }
 
-//--- Process Image ---//
+//--- Clear Processor Cache ---//
 /*
-    CPU process an image with the given OCIO Settings
+    Drop every cached CPU processor, called
+    whenever a config is added
 */
-void ocioProcessor::processImage(float *img, unsigned int width,
-                                 unsigned int height, ocioSetting &ocioSet) {
+void ocioProcessor::clearProcessorCache() {
+    if (m_cpuCache.hits() + m_cpuCache.misses() > 0)
+        LOG_INFO("Clearing OCIO processor cache, {} hits, {} misses",
+                 m_cpuCache.hits(), m_cpuCache.misses());
+    m_cpuCache.clear();
+    m_lutCache.clear();
+}
 
-  try {
-      int configIt = selectedConfig;
-      if (ocioSet.ocioConfig >= 0 && ocioSet.ocioConfig < m_configs.size())
-        configIt = ocioSet.ocioConfig;
+//--- Get CPU Processor ---//
+/*
+    Build the optimized CPU processor for the
+    given OCIO Settings, or reuse a cached one.
+    Returns nullptr on failure.
+*/
+OCIO::ConstCPUProcessorRcPtr ocioProcessor::getCPUProcessor(ocioSetting &ocioSet) {
+
+  int configIt = selectedConfig;
+  if (ocioSet.ocioConfig >= 0 && ocioSet.ocioConfig < m_configs.size())
+    configIt = ocioSet.ocioConfig;
 
-      const char *colorspace = m_configs[configIt].config->getColorSpaceNameByIndex(ocioSet.colorspace);
+  processorKey key;
+  key.config = configIt;
+  key.colorspace = ocioSet.colorspace;
+  key.display = ocioSet.display;
+  key.view = ocioSet.view;
+  key.inverse = ocioSet.inverse;
+  key.useDisplay = ocioSet.useDisplay;
+
+  OCIO::ConstCPUProcessorRcPtr cached;
+  if (m_cpuCache.find(key, cached))
+    return cached;
+
+  OCIO::ConstConfigRcPtr config = configAt(configIt);
+  if (!config)
+    return nullptr;
+
+  try {
+      const char *colorspace = config->getColorSpaceNameByIndex(ocioSet.colorspace);
       if (!colorspace && !ocioSet.useDisplay){
-          colorspace = m_configs[configIt].config->getColorSpaceNameByIndex(0);
+          colorspace = config->getColorSpaceNameByIndex(0);
           LOG_WARN("Invald Input Colorspace setting, using default!");
       }
 
-      const char *display = m_configs[configIt].config->getDisplay(ocioSet.display);
+      const char *display = config->getDisplay(ocioSet.display);
       const char *view;
       if (!display && ocioSet.useDisplay){
-          display = m_configs[configIt].config->getDisplay(0);
-          view = m_configs[configIt].config->getView(display, 0);
+          display = config->getDisplay(0);
+          view = config->getView(display, 0);
           LOG_WARN("Invalid input colorspace setting, using default!");
       } else {
-          view = m_configs[configIt].config->getView(display, ocioSet.view);
+          view = config->getView(display, ocioSet.view);
           if (!view) {
-              view = m_configs[configIt].config->getView(display, 0);
+              view = config->getView(display, 0);
               LOG_WARN("Invalid view option, using default!");
           }
       }
@@ -192,7 +342,7 @@ void ocioProcessor::processImage(float *img, unsigned int width,
             transform->setSrc("ACEScg");
             transform->setDst(colorspace);
         }
-      processor = m_configs[configIt].config->getProcessor(transform);
+      processor = config->getProcessor(transform);
     } else {
       OCIO::DisplayViewTransformRcPtr transform =
           OCIO::DisplayViewTransform::Create();
@@ -201,81 +351,86 @@ void ocioProcessor::processImage(float *img, unsigned int width,
       transform->setView(view);
       if (ocioSet.inverse)
         transform->setDirection(OCIO::TRANSFORM_DIR_INVERSE);
-      processor = m_configs[configIt].config->getProcessor(transform);
+      processor = config->getProcessor(transform);
     }
 
-    OCIO::ConstCPUProcessorRcPtr cpu =
-        processor->getOptimizedCPUProcessor(OCIO::OPTIMIZATION_DEFAULT);
-
-    // Get number of hardware threads
-    const unsigned int numThreads = std::thread::hardware_concurrency();
-    const unsigned int rowsPerThread = (height + numThreads - 1) / numThreads;
-
-    std::vector<std::thread> threads;
+    OCIO::ConstCPUProcessorRcPtr cpu = processor->getOptimizedCPUProcessor(OCIO::OPTIMIZATION_DEFAULT);
+    m_cpuCache.insert(key, cpu);
+    return cpu;
 
-    for (unsigned int t = 0; t < numThreads; ++t) {
-      unsigned int yStart = t * rowsPerThread;
-      unsigned int yEnd = height > yStart + rowsPerThread ? yStart + rowsPerThread : height;
-
-      if (yStart >= yEnd)
-        continue;
-
-      threads.emplace_back([=]() {
-        float *threadImg = img + yStart * width * 4; // 4 channels per pixel
-        unsigned int threadHeight = yEnd - yStart;
-
-        OCIO::PackedImageDesc threadDesc(threadImg, width, threadHeight, 4);
-        cpu->apply(threadDesc);
-      });
-    }
-
-    for (auto &t : threads) {
-      t.join();
-    }
+  } catch (OCIO::Exception &e) {
+    LOG_ERROR("Error building OCIO CPU processor: {}", e.what());
+    return nullptr;
+  }
+}
 
+//--- Apply CPU ---//
+/*
+    Apply a prebuilt CPU processor to a
+    contiguous block of RGBA rows in place
+*/
+void ocioProcessor::applyCPU(const OCIO::ConstCPUProcessorRcPtr &cpu, float *img,
+                             unsigned int width, unsigned int height) {
+  try {
+    OCIO::PackedImageDesc desc(img, width, height, 4);
+    cpu->apply(desc);
   } catch (OCIO::Exception &e) {
     LOG_ERROR("Error processing OIIO image!");
-    return;
   }
 }
 
-void ocioProcessor::refGamutCompress(float* img, unsigned int width, unsigned int height) {
-    try {
-      OCIO::ConstProcessorRcPtr processor;
-      OCIO::LookTransformRcPtr lookTransform = OCIO::LookTransform::Create();
-      lookTransform->setLooks("ACES 1.3 Reference Gamut Compression");
-      lookTransform->setSrc("ACEScg");
-      lookTransform->setDst("ACEScg");
-      processor = m_configs[selectedConfig].config->getProcessor(lookTransform);
-
-      OCIO::ConstCPUProcessorRcPtr cpu =
-          processor->getOptimizedCPUProcessor(OCIO::OPTIMIZATION_DEFAULT);
-
-      // Get number of hardware threads
-      const unsigned int numThreads = std::thread::hardware_concurrency();
-      const unsigned int rowsPerThread = (height + numThreads - 1) / numThreads;
+//--- Apply Chunked ---//
+/*
+    Apply over the image in L2 sized row chunks
+    on the shared pool. Concurrent exports queue
+    their chunks on the same workers instead of
+    each starting a thread per core.
+*/
+void ocioProcessor::applyChunked(const OCIO::ConstCPUProcessorRcPtr &cpu, float *img,
+                                 unsigned int width, unsigned int height) {
+  parallelFor(0, height, ocioChunkRows(width), [&](size_t yStart, size_t yEnd) {
+    float *bandImg = img + yStart * width * 4; // 4 channels per pixel
+    applyCPU(cpu, bandImg, width, yEnd - yStart);
+  });
+}
 
-      std::vector<std::thread> threads;
+//--- Process Image ---//
+/*
+    CPU process an image with the given OCIO Settings
+*/
+void ocioProcessor::processImage(float *img, unsigned int width,
+                                 unsigned int height, ocioSetting &ocioSet) {
 
-      for (unsigned int t = 0; t < numThreads; ++t) {
-        unsigned int yStart = t * rowsPerThread;
-        unsigned int yEnd = height > yStart + rowsPerThread ? yStart + rowsPerThread : height;
+  OCIO::ConstCPUProcessorRcPtr cpu = getCPUProcessor(ocioSet);
+  if (!cpu)
+    return;
 
-        if (yStart >= yEnd)
-          continue;
+  applyChunked(cpu, img, width, height);
+}
 
-        threads.emplace_back([=]() {
-          float *threadImg = img + yStart * width * 4; // 4 channels per pixel
-          unsigned int threadHeight = yEnd - yStart;
+void ocioProcessor::refGamutCompress(float* img, unsigned int width, unsigned int height) {
+    try {
+      processorKey key;
+      key.kind = 1;
+      key.config = selectedConfig;
 
-          OCIO::PackedImageDesc threadDesc(threadImg, width, threadHeight, 4);
-          cpu->apply(threadDesc);
-        });
+      OCIO::ConstCPUProcessorRcPtr cpu;
+      if (!m_cpuCache.find(key, cpu)) {
+        OCIO::ConstProcessorRcPtr processor;
+        OCIO::LookTransformRcPtr lookTransform = OCIO::LookTransform::Create();
+        lookTransform->setLooks("ACES 1.3 Reference Gamut Compression");
+        lookTransform->setSrc("ACEScg");
+        lookTransform->setDst("ACEScg");
+        OCIO::ConstConfigRcPtr config = configAt(selectedConfig);
+        if (!config)
+          return;
+        processor = config->getProcessor(lookTransform);
+
+        cpu = processor->getOptimizedCPUProcessor(OCIO::OPTIMIZATION_DEFAULT);
+        m_cpuCache.insert(key, cpu);
       }
 
-      for (auto &t : threads) {
-        t.join();
-      }
+      applyChunked(cpu, img, width, height);
 
     } catch (OCIO::Exception &e) {
       LOG_ERROR("Error processing OIIO Gamut Compression! {}", e.what());
@@ -283,16 +438,64 @@ void ocioProcessor::refGamutCompress(float* img, unsigned int width, unsigned in
     }
 }
 
+//--- Get Display LUT ---//
+/*
+    Bake the CPU processor for these settings
+    into a shaped 3D LUT, once per setting. The
+    log shaper assumes scene-linear ACEScg, so
+    inverse transforms are never baked.
+*/
+std::shared_ptr<const displayLUT> ocioProcessor::getDisplayLUT(ocioSetting &ocioSet) {
+  if (ocioSet.inverse)
+    return nullptr;
+
+  int configIt = selectedConfig;
+  if (ocioSet.ocioConfig >= 0 && ocioSet.ocioConfig < m_configs.size())
+    configIt = ocioSet.ocioConfig;
+
+  processorKey key;
+  key.kind = 2;
+  key.config = configIt;
+  key.colorspace = ocioSet.colorspace;
+  key.display = ocioSet.display;
+  key.view = ocioSet.view;
+  key.useDisplay = ocioSet.useDisplay;
+
+  std::shared_ptr<const displayLUT> cached;
+  if (m_lutCache.find(key, cached))
+    return cached;
+
+  OCIO::ConstCPUProcessorRcPtr cpu = getCPUProcessor(ocioSet);
+  if (!cpu)
+    return nullptr;
+
+  auto start = std::chrono::steady_clock::now();
+  auto lut = std::make_shared<displayLUT>();
+  bakeDisplayLUT(*lut, [&](float *rgba, size_t count) {
+    // The lattice is one long row, chunk it like an image
+    applyChunked(cpu, rgba, DISPLAY_LUT_SIZE, count / DISPLAY_LUT_SIZE);
+  });
+  auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  LOG_INFO("Baked {}^3 display LUT in {}ms", lut->size, dur.count());
+
+  m_lutCache.insert(key, lut);
+  return lut;
+}
+
 //--- Get GL Desc ---//
 /*
     With the given OCIO Settings, create the requisite
     GpuShaderDescRcPtr, and return it
 */
 OCIO::GpuShaderDescRcPtr ocioProcessor::getGLDesc(ocioSetting& ocioSet) {
+    OCIO::ConstConfigRcPtr config = configAt(selectedConfig);
+    if (!config)
+        return nullptr;
+
     try {
-        const char* colorspace = m_configs[selectedConfig].config->getColorSpaceNameByIndex(ocioSet.colorspace);
-        const char* display = m_configs[selectedConfig].config->getDisplay(ocioSet.display);
-        const char* view = m_configs[selectedConfig].config->getView(display, ocioSet.view);
+        const char* colorspace = config->getColorSpaceNameByIndex(ocioSet.colorspace);
+        const char* display = config->getDisplay(ocioSet.display);
+        const char* view = config->getView(display, ocioSet.view);
 
         OCIO::ConstProcessorRcPtr processor;
         if (!ocioSet.useDisplay){
@@ -304,7 +507,7 @@ OCIO::GpuShaderDescRcPtr ocioProcessor::getGLDesc(ocioSetting& ocioSet) {
                 transform->setSrc("ACEScg");
                 transform->setDst(colorspace);
             }
-            processor = m_configs[selectedConfig].config->getProcessor(transform);
+            processor = config->getProcessor(transform);
         } else {
             OCIO::DisplayViewTransformRcPtr transform = OCIO::DisplayViewTransform::Create();
             transform->setSrc("ACEScg");
@@ -312,7 +515,7 @@ OCIO::GpuShaderDescRcPtr ocioProcessor::getGLDesc(ocioSetting& ocioSet) {
             transform->setView(view);
             if (ocioSet.inverse)
               transform->setDirection(OCIO::TRANSFORM_DIR_INVERSE);
-            processor = m_configs[selectedConfig].config->getProcessor(transform);
+            processor = config->getProcessor(transform);
         }
 
         // Step 5: Create GPU shader description
@@ -2,6 +2,13 @@
 #define _ocioprocessor_h
 
 #include "structs.h"
+#include "lruCache.h"
+#include "displayLUT.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <thread>
@@ -13,8 +20,15 @@ namespace OCIO = OCIO_NAMESPACE;
 
 #include "logger.h"
 
+// A registered config. Its text (or file path)
+// is kept until first use, and parsed once.
 struct ocioConfig {
     std::string configName;
+    std::string source;
+    bool fromFile = false;
+    std::shared_ptr<std::once_flag> parsed = std::make_shared<std::once_flag>();
+    bool attempted = false;         // Parse has run, config is null if it failed
+    std::string error;              // Why it failed
     OCIO::ConstConfigRcPtr config;
     std::vector<std::string> colorspaces;
     std::vector<std::string> displays;
@@ -23,24 +37,80 @@ struct ocioConfig {
 
 };
 
+#define OCIO_PROC_CACHE 16      // CPU processors kept
+#define OCIO_CHUNK_BYTES (256 * 1024)   // RGBA rows handed to one apply, sized for L2
+
+// Rows per OCIO apply for an image this wide,
+// at least one however wide the image
+inline size_t ocioChunkRows(unsigned int width) {
+    size_t rowBytes = std::max<size_t>((size_t)width * 4 * sizeof(float), 1);
+    return std::max<size_t>(OCIO_CHUNK_BYTES / rowBytes, 1);
+}
+
+// What a CPU processor is built from. kind 1 is
+// the reference gamut compression look, kind 2 a
+// display LUT baked from the kind 0 processor.
+struct processorKey {
+    int kind = 0;
+    int config = 0;
+    int colorspace = 0;
+    int display = 0;
+    int view = 0;
+    bool inverse = false;
+    bool useDisplay = true;
+
+    bool operator==(const processorKey& other) const {
+        return kind == other.kind && config == other.config &&
+               colorspace == other.colorspace && display == other.display &&
+               view == other.view && inverse == other.inverse &&
+               useDisplay == other.useDisplay;
+    }
+};
+
+struct processorKeyHash {
+    size_t operator()(const processorKey& k) const {
+        size_t h = std::hash<int>()(k.kind);
+        for (int v : {k.config, k.colorspace, k.display, k.view, (int)k.inverse, (int)k.useDisplay})
+            h = h * 31 + std::hash<int>()(v);
+        return h;
+    }
+};
+
 class ocioProcessor {
     public:
     ocioProcessor(){};
     ~ocioProcessor(){};
 
     bool initialize(std::string &configFile);
-    bool addConfig(std::string &configFile, std::string configName);
-    bool initExtConfig(std::string path);
-
-    void setActiveConfig(int id);
-    ocioConfig* activeConfig(){return &m_configs[selectedConfig];}
+    // deferred only registers the config, it is parsed on first use
+    bool addConfig(std::string &configFile, std::string configName, bool deferred = false);
+    bool initExtConfig(std::string path, bool deferred = false);
+    // UI thread only. Once a deferred external config has been parsed,
+    // drop it if it was invalid and return false with the reason
+    bool settleExternalConfig(std::string& error);
+    // Parse every config still waiting, on the pool
+    void preloadConfigs();
+
+    bool setActiveConfig(int id);
+    ocioConfig* activeConfig();
+    size_t configCount() const { return m_configs.size(); }
     std::vector<std::string> getConfigList();
     std::vector<std::string> getConfigNames();
 
     void processImage(float* img, unsigned int width, unsigned int height, ocioSetting &ocioSet);
+    OCIO::ConstCPUProcessorRcPtr getCPUProcessor(ocioSetting &ocioSet);
+    void applyCPU(const OCIO::ConstCPUProcessorRcPtr &cpu, float* img, unsigned int width, unsigned int height);
+    void applyChunked(const OCIO::ConstCPUProcessorRcPtr &cpu, float* img, unsigned int width, unsigned int height);
     void refGamutCompress(float* img, unsigned int width, unsigned int height);
+    // Scene-linear ACEScg in only, nullptr for inverse transforms or on failure
+    std::shared_ptr<const displayLUT> getDisplayLUT(ocioSetting &ocioSet);
     OCIO::GpuShaderDescRcPtr getGLDesc(ocioSetting& ocioSet);
 
+    // CPU processors are cached until the configs change
+    void clearProcessorCache();
+    uint64_t processorHits() const { return m_cpuCache.hits(); }
+    uint64_t processorMisses() const { return m_cpuCache.misses(); }
+
     //std::vector<char*> colorspaces;
     //std::vector<char*> displays;
     //std::vector<std::vector<char*>> views;
@@ -51,8 +121,16 @@ class ocioProcessor {
 
     private:
     void loadNames(ocioConfig& config);
-
-    std::vector<ocioConfig> m_configs;
+    bool loadConfig(ocioConfig& config);
+    OCIO::ConstConfigRcPtr configAt(int id);
+
+    // A deque, so a config being parsed on the pool
+    // stays put while others are added
+    std::deque<ocioConfig> m_configs;
+    std::atomic<int> m_preloading{0};   // Parses still queued by preloadConfigs
+    int m_pendingExternal = -1;         // Deferred external config not yet settled
+    lruCache<processorKey, OCIO::ConstCPUProcessorRcPtr, processorKeyHash> m_cpuCache{OCIO_PROC_CACHE};
+    lruCache<processorKey, std::shared_ptr<const displayLUT>, processorKeyHash> m_lutCache{OCIO_PROC_CACHE};
 
     //bool useExt = false;
     //std::string internalConfig;
@@ -5,6 +5,7 @@
 #include "structs.h"
 #include "threadPool.h"
 #include "updateCheck.h"
+#include "utils.h"
 
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 #include <GLES2/gl2.h>
@@ -12,6 +13,7 @@
 #include <GLFW/glfw3.h> // Will drag system OpenGL headers
 
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -46,6 +48,7 @@ std::string find_key_by_value(const std::map<std::string, int>& my_map, int valu
 
 int mainWindow::openWindow()
 {
+    stageTimer startup;
 
     // Load colorspace mappings
     loadMappings();
@@ -119,6 +122,7 @@ int mainWindow::openWindow()
 
     // Initialize GL Processor
     gpu = new openglGPU();
+    startup.mark("window");
 
     //Font Loading
     auto fs = cmrc::assets::get_filesystem();
@@ -178,19 +182,16 @@ int mainWindow::openWindow()
       return -1;
     }
 
-    // Load in OCIO Configs
-    bool validConfig = false;
+    // Register the OCIO configs. Only the active
+    // one is parsed before the first frame, the
+    // rest load on the pool once it is up.
+    startup.mark("fonts");
     auto ocioConfigFileA = fs.open("assets/studio-config-v3.0.0_aces-v2.0_ocio-v2.4.ocio");
     if (!ocioConfigFileA) {
         LOG_ERROR("Error opening ACES 2.0 OCIO Config!");
     } else {
         std::string configStreamA(static_cast<const char*>(ocioConfigFileA->begin()), int(ocioConfigFileA->size()));
-
-        if (!ocioProc.addConfig(configStreamA, "ACES 2.0")) {
-            LOG_ERROR("Failed to load ACES 2.0 Config!");
-        } else {
-            validConfig = true;
-        }
+        ocioProc.addConfig(configStreamA, "ACES 2.0", true);
     }
 
     auto ocioConfigFileB = fs.open("assets/studio-config-v2.2.0_aces-v1.3_ocio-v2.3.ocio");
@@ -198,12 +199,7 @@ int mainWindow::openWindow()
         LOG_ERROR("Error opening ACES 1.3 OCIO Config!");
     } else {
         std::string configStreamB(static_cast<const char*>(ocioConfigFileB->begin()), int(ocioConfigFileB->size()));
-
-        if (!ocioProc.addConfig(configStreamB, "ACES 1.3")) {
-            LOG_ERROR("Failed to load ACES 1.3 Config!");
-        } else {
-            validConfig = true;
-        }
+        ocioProc.addConfig(configStreamB, "ACES 1.3", true);
     }
 
     // Check Release Notes Popup
@@ -223,12 +219,17 @@ int mainWindow::openWindow()
             }).detach();
     }
 
-    if (!appPrefs.prefs.ocioPath.empty()) {
-        if (ocioProc.initExtConfig(appPrefs.prefs.ocioPath) && appPrefs.prefs.ocioExt == 2) {
-            ocioProc.setActiveConfig(-1);
-            validConfig = true;
-        }
-    }
+    bool extConfig = false;
+    if (!appPrefs.prefs.ocioPath.empty())
+        extConfig = ocioProc.initExtConfig(appPrefs.prefs.ocioPath, true);
+
+    // Parse the preferred config, falling back
+    // to the first one that is valid
+    int activeConfig = appPrefs.prefs.ocioExt == 2 && extConfig ? -1 : appPrefs.prefs.ocioExt;
+    bool validConfig = ocioProc.setActiveConfig(activeConfig);
+    for (int i = 0; !validConfig && i < (int)ocioProc.configCount(); i++)
+        validConfig = ocioProc.setActiveConfig(i);
+    startup.mark("OCIO config");
 
     if (!validConfig) {
         // We were not able to load a config
@@ -239,10 +240,11 @@ int mainWindow::openWindow()
         std::strcpy(ackError, "Filmvert was unable to load in any valid OCIO config.\nThe program will not function properly.");
         ackPopTrig = true;
     } else {
-        ocioProc.setActiveConfig(appPrefs.prefs.ocioExt);
         // Initialize GL Kernels
         gpu->initialize(dispOCIO);
+        ocioProc.preloadConfigs();
     }
+    startup.mark("GPU kernels");
 
     // Load in logo file
     auto logoFile = fs.open("assets/logo.png");
@@ -281,6 +283,8 @@ int mainWindow::openWindow()
 
     // Scale sizes
     ImGui::GetStyle().ScaleAllSizes(imgui_additional_scale);
+    startup.mark("assets");
+    LOG_INFO("Startup: {}", startup.summary());
 
 
     // Main loop
@@ -407,6 +411,18 @@ int mainWindow::openWindow()
             ackPopTrig = true;
         }
 
+        // A custom OCIO config is only parsed on first
+        // use, drop it from the list if that failed
+        std::string ocioError;
+        if (!ocioProc.settleExternalConfig(ocioError)) {
+            std::strcpy(ackMsg, "OCIO Config Error:");
+            std::snprintf(ackError, sizeof(ackError), "Unable to load custom OCIO config:\n%s\n\n%s",
+                          appPrefs.prefs.ocioPath.c_str(), ocioError.c_str());
+            badOcioText = true;
+            ocioSel = ocioProc.selectedConfig;
+            ackPopTrig = true;
+        }
+
         // Popup functions
         importImagePopup();
         importRollPopup();
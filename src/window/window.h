@@ -31,6 +31,7 @@
 #include "logger.h"
 
 #include "gpu.h"
+#include "analysisBatch.h"
 #include "image.h"
 #include "imageMeta.h"
 //#include "metalGPU.h"
@@ -159,6 +160,7 @@ class mainWindow
         bool preferencesPopTrig = false;
         bool ackPopTrig = false;
         bool anaPopTrig = false;
+        bool anaBatchPop = false;
         closeMode closeMd;
         bool shortPopTrig = false;
         bool imMatchPopTrig = false;
@@ -253,6 +255,7 @@ class mainWindow
         int activeRollSize();
         void paramUpdate();
         void clearRoll(filmRoll* roll);
+        void closeSelectedImages();
         void removeRoll();
         void checkForRaw();
         void testFirstRawFile();
@@ -294,6 +297,7 @@ class mainWindow
         void openRolls();
         void exportImages();
         void exportRolls();
+        bool renderForExport(image* img);
 
 
         void clearSelection();
@@ -307,6 +311,9 @@ class mainWindow
         void stateRender();
 
         void analyzeImage();
+        void analyzeImages(const std::vector<image*>& images);
+        void analyzeRolls();
+        analysisBatch anaBatch;
 
 
         // windowIOPopups.cpp
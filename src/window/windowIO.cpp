@@ -360,6 +360,62 @@ void mainWindow::openRolls() {
     }
 }
 
+//--- Render For Export ---//
+/*
+    Queue the full resolution render and wait
+    on its ticket, which settles the moment the
+    pixels are in place. If it stalls past the
+    render timeout it is re-queued at viewer
+    priority once before giving up. The wait is
+    cut short by a cancelled export.
+
+    On false the caller still post-processes the
+    image, so a render that is already running is
+    given the timeout to land before its buffers
+    can go.
+*/
+bool mainWindow::renderForExport(image* img) {
+    renderTicketPtr ticket = gpu->addToRender(img, r_full, exportOCIO);
+    auto start = std::chrono::steady_clock::now();
+    bool retry = false;
+    auto abandon = [&]() {
+        gpu->removeFromQueue(img);
+        uint32_t timeout = img->cpuRender ? 300000 : appPrefs.prefs.renderTimeout;
+        ticket->waitFor(std::chrono::milliseconds(timeout));
+        img->renderReady = false;
+        return false;
+    };
+    while (true) {
+        renderStatus status = ticket->waitFor(std::chrono::milliseconds(250));
+        if (status == rs_done) {
+            img->renderReady = false;
+            return true;
+        }
+        if (status != rs_pending) {
+            LOG_ERROR("Cannot export file {}: {}", img->srcFilename, ticket->error());
+            return false;
+        }
+        if (!isExporting)
+            return abandon();
+
+        auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        uint32_t timeout = img->cpuRender ? 300000 : appPrefs.prefs.renderTimeout;
+        if (dur.count() > timeout) {
+            if (retry) {
+                // Bailing out after waiting 90 seconds for GL to finish rendering..
+                LOG_ERROR("Stuck waiting for GPU render. Cannot export file: {}!", img->srcFilename);
+                return abandon();
+            }
+            // Try to re-queue the render to the front
+            if (!img->cpuRender)
+                ticket = gpu->addToRender(img, r_sdt, exportOCIO);
+            start = std::chrono::steady_clock::now();
+            retry = true;
+        }
+    }
+}
+
 //--- Export Images ---//
 /*
     Exporting individual images. Loop through
@@ -397,29 +453,12 @@ void mainWindow::exportImages() {
                     else
                         getImage(i)->imgParam.cropEnable = false;
                     getImage(i)->exportPreProcess(expSetting.outPath, exportImgCount);
-                    gpu->addToRender(getImage(i), r_full, exportOCIO);
-                    auto start = std::chrono::steady_clock::now();
-                    bool retry = false;
-                    uint32_t timeout = appPrefs.prefs.renderTimeout;
-                    while (!getImage(i)->renderReady) {
-                        auto end = std::chrono::steady_clock::now();
-                        auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-                        timeout = getImage(i)->cpuRender ? 300000 : timeout;
-                        if (dur.count() > timeout) {
-                            if (retry) {
-                                // Bailing out after waiting 90 seconds for GL to finish rendering..
-                                LOG_ERROR("Stuck waiting for GPU render. Cannot export file: {}!", getImage(i)->srcFilename);
-                                return;
-                            }
-                            // Try to re-queue the render to the front
-                            if (!getImage(i)->cpuRender)
-                                gpu->addToRender(getImage(i), r_sdt, exportOCIO);
-                            start = std::chrono::steady_clock::now();
-                            retry = true;
-                        }
-                        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                    getImage(i)->displayProof = expSetting.format == 2;
+                    if (!renderForExport(getImage(i))) {
+                        getImage(i)->exportPostProcess();
+                        getImage(i)->imgParam.cropEnable = prevCrop;
+                        return;
                     }
-                    getImage(i)->renderReady = false;
                     //LOG_INFO("Exporting Image {}: {}", i, getImage(i)->srcFilename);
                     getImage(i)->writeImg(expSetting, exportOCIO);
                     gpu->removeFromQueue(getImage(i));
@@ -484,34 +523,16 @@ void mainWindow::exportRolls() {
                             else
                                 getImage(r, i)->imgParam.cropEnable = false;
                             getImage(r, i)->exportPreProcess(expSetting.outPath + activeRolls[r].rollName, exportImgCount);
+                            getImage(r, i)->displayProof = expSetting.format == 2;
                             if (!std::filesystem::exists(getImage(r, i)->expFullPath)) {
                                 std::filesystem::create_directories(getImage(r, i)->expFullPath);
                             }
 
-                            gpu->addToRender(getImage(r, i), r_full, exportOCIO);
-                            auto start = std::chrono::steady_clock::now();
-                            bool retry = false;
-                            uint32_t timeout = appPrefs.prefs.renderTimeout;
-                            while (!getImage(r, i)->renderReady) {
-                                auto end = std::chrono::steady_clock::now();
-                                auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-                                timeout = getImage(r, i)->cpuRender ? 300000 : timeout;
-                                if (dur.count() > timeout) {
-                                    if (retry) {
-                                        // Bailing out after waiting 90 seconds for GL to finish rendering..
-                                        LOG_ERROR("Stuck waiting for GPU render. Cannot export file: {}!", getImage(r, i)->srcFilename);
-                                        return;
-                                    }
-                                    // Try to re-queue the render to the front
-                                    if (!getImage(r, i)->cpuRender)
-                                        gpu->addToRender(getImage(r, i), r_sdt, exportOCIO);
-                                    start = std::chrono::steady_clock::now();
-                                    retry = true;
-
-                                }
-                                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                            if (!renderForExport(getImage(r, i))) {
+                                getImage(r, i)->exportPostProcess();
+                                getImage(r, i)->imgParam.cropEnable = prevCrop;
+                                return;
                             }
-                            getImage(r, i)->renderReady = false;
                             getImage(r, i)->writeImg(expSetting, exportOCIO);
                             gpu->removeFromQueue(getImage(r, i));
                             getImage(r, i)->exportPostProcess();
@@ -10,6 +10,7 @@
 */
 void mainWindow::imageView() {
     bool calcBaseColor = false;
+    bool liveBaseColor = false;
     ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(appPrefs.prefs.imageBGColor[0], appPrefs.prefs.imageBGColor[1], appPrefs.prefs.imageBGColor[2], appPrefs.prefs.imageBGColor[3]));
     ImGui::SetNextWindowSizeConstraints(ImVec2(500,500), ImVec2(winWidth - 128, winHeight - 128));
     ImGui::SetNextWindowPos(ImVec2(0, menuHeight), ImGuiCond_Always);
@@ -522,6 +523,9 @@ void mainWindow::imageView() {
 
             // Update selection while dragging
             if (isSelecting && ctrlShiftPressed && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+                // Preview the base color whenever the box changes
+                if (mousePosInImage.x != selectionEnd.x || mousePosInImage.y != selectionEnd.y)
+                    liveBaseColor = true;
                 selectionEnd = mousePosInImage;  // This is in original image coordinates
 
                 // Store in sample arrays (in original image coordinates)
@@ -898,13 +902,14 @@ void mainWindow::imageView() {
 
             "Total Rolls:",
             "Total RAM:",
-            "Total VRAM:"
+            "Total VRAM:",
+            "Input Textures:"
         };
-        const int lineCount = 9;
+        const int lineCount = 10;
 
-        static std::string vals[9];
-        static float labelW[9] = {};
-        static float valW[9]   = {};
+        static std::string vals[10];
+        static float labelW[10] = {};
+        static float valW[10]   = {};
         static float maxLabelW = 0.0f;
         static float maxValW   = 0.0f;
         static float panelW    = 0.0f;
@@ -920,6 +925,9 @@ void mainWindow::imageView() {
             uint64_t totalRam = 0;
             uint64_t totalVram = 0;
             for (auto& roll : activeRolls) {
+                // Textures evicted since the last check stop counting
+                for (auto& img : roll.images)
+                    gpu->checkInputTex(&img);
                 totalRam += roll.rollRamUsage();
                 totalVram += roll.rollVramUsage();
             }
@@ -934,6 +942,9 @@ void mainWindow::imageView() {
             vals[6] = fmt::format("{}", activeRolls.size());
             vals[7] = byteFormat(totalRam);
             vals[8] = byteFormat(totalVram + gpu->activeBytes());
+            const auto& inputTex = gpu->inputTexCache();
+            vals[9] = fmt::format("{} / {}, {} evicted", byteFormat(inputTex.bytes()),
+                                  byteFormat(inputTex.budget()), inputTex.evictions());
 
 
             // Measure everything at the actual render font size
@@ -1014,7 +1025,13 @@ void mainWindow::imageView() {
     if (calcBaseColor) {
         if (validIm()) {
             activeImage()->processBaseColor();
+            // 24 bytes a pixel, only worth holding while dragging
+            activeImage()->rawSAT.clear();
             activeRoll()->rollUpState();
         }
+    } else if (liveBaseColor && validIm()) {
+        // Live preview, final value is committed on release
+        activeImage()->processBaseColor(true);
+        renderCall = true;
     }
 }
@@ -105,7 +105,7 @@ void mainWindow::checkHotkeys() {
                     closeMd = c_selIm;
                     unsavedPopTrigger = true;
                 } else {
-                    activeRoll()->closeSelected();
+                    closeSelectedImages();
                 }
             }
         }
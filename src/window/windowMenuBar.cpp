@@ -94,7 +94,7 @@ void mainWindow::menuBar() {
                             closeMd = c_selIm;
                             unsavedPopTrigger = true;
                         } else {
-                            activeRoll()->closeSelected();
+                            closeSelectedImages();
                         }
                     }
                 }
@@ -327,6 +327,11 @@ void mainWindow::menuBar() {
                 }
             }
 
+            if (ImGui::MenuItem("Analyze Roll(s)")) {
+                if (validRoll())
+                    analyzeRolls();
+            }
+
             if (ImGui::MenuItem("Generate Contact Sheet")) {
                 if (validRoll()) {
                     // Set output format to jpeg
@@ -50,8 +50,7 @@ void mainWindow::unsavedRollPopup() {
                     ImGui::CloseCurrentPopup();
                     break;
                 case c_selIm:
-                    if (validRoll())
-                        activeRoll()->closeSelected();
+                    closeSelectedImages();
                     unsavedPopTrigger = false;
                     ImGui::CloseCurrentPopup();
                     break;
@@ -80,7 +79,7 @@ void mainWindow::unsavedRollPopup() {
                 case c_selIm:
                     if (validRoll()) {
                         activeRoll()->saveSelected();
-                        activeRoll()->closeSelected();
+                        closeSelectedImages();
                     }
                     unsavedPopTrigger = false;
                     ImGui::CloseCurrentPopup();
@@ -139,14 +138,34 @@ void mainWindow::ackPopup() {
 //--- Analyze Popup ---//
 /*
     Simple message while waiting for
-    analysis to finish
+    analysis to finish, with progress and
+    cancel for a batch
 */
 void mainWindow::analyzePopup() {
+    if (anaBatchPop && !anaBatch.running()) {
+        // Batch finished or was cancelled
+        anaBatchPop = false;
+        anaPopTrig = false;
+        metaRefresh = true;
+    }
     if (anaPopTrig)
         ImGui::OpenPopup("Analyze");
     if (ImGui::BeginPopupModal("Analyze", NULL, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoResize)) {
 
-        ImGui::Text("Analyzing...");
+        if (anaBatchPop) {
+            ImGui::Text("Analyzing %zu of %zu images...", anaBatch.completed(), anaBatch.total());
+            ImGui::ProgressBar(anaBatch.progress(), ImVec2(0.0f, 0.0f));
+            ImGui::Spacing();
+            if (anaBatch.cancelled()) {
+                ImGui::BeginDisabled();
+                ImGui::Button("Cancelling...");
+                ImGui::EndDisabled();
+            } else if (ImGui::Button("Cancel")) {
+                anaBatch.cancel();
+            }
+        } else {
+            ImGui::Text("Analyzing...");
+        }
 
         if (!anaPopTrig) {
             ImGui::CloseCurrentPopup();
@@ -254,6 +254,18 @@ void mainWindow::preferencesPopup() {
                 tmpPrefs.maxSimExports = tmpPrefs.maxSimExports < 1 ? 1 :
                     tmpPrefs.maxSimExports > THREAD_LIMIT ? THREAD_LIMIT : tmpPrefs.maxSimExports;
 
+                ImGui::Spacing();
+                ImGui::SeparatorText("Rendering");
+                ImGui::Spacing();
+
+                ImGui::Text("Fast CPU Display Transform");
+                ImGui::Checkbox("###clut", &tmpPrefs.cpuLUT);
+                ImGui::SetItemTooltip("CPU renders of previews and JPEG exports use a baked 3D LUT\nof the display transform instead of the exact OCIO processor.\nTIFF, PNG, DPX and EXR exports always use the exact transform.");
+
+                ImGui::Text("Cache Display Shaders on Disk");
+                ImGui::Checkbox("###sdc", &tmpPrefs.shaderDiskCache);
+                ImGui::SetItemTooltip("Save linked display shaders between runs so they load\ninstead of compiling. Shaders left by other drivers are\ncleaned up automatically. Turn off if a driver misbehaves with cached shaders.");
+
                 ImGui::Spacing();
                 ImGui::SeparatorText("OpenColorIO");
                 ImGui::Spacing();
@@ -276,10 +288,10 @@ void mainWindow::preferencesPopup() {
                             //We've supplied a bad config
                             badOcioText = true;
                         } else {
-                            badOcioText = false;
                             tmpPrefs.ocioPath = selection[0];
                             std::strcpy(ocioPath, tmpPrefs.ocioPath.c_str());
-                            ocioProc.setActiveConfig(-1);
+                            badOcioText = !ocioProc.setActiveConfig(-1);
+                            ocioSel = ocioProc.selectedConfig;
                         }
                     }
                 }
@@ -315,21 +327,25 @@ void mainWindow::preferencesPopup() {
         }
         ImGui::SameLine();
         if (ImGui::Button("Save")) {
-            if (ocioSel != ocioProc.selectedConfig) {
-                ocioProc.setActiveConfig(ocioSel);
+            if (ocioSel != ocioProc.selectedConfig && !ocioProc.setActiveConfig(ocioSel)) {
+                // The config didn't parse, keep the current
+                // one and leave the dialog open to show why
+                badOcioText = true;
+                ocioSel = ocioProc.selectedConfig;
+            } else {
+                // The tmpPrefs struct contains unchanged values. Copy the
+                // accepted/changed values into the tmp so when we copy back to
+                // main the values hold with what was selected
+                std::memcpy(tmpPrefs.imageBGColor.data(), appPrefs.prefs.imageBGColor.data(), sizeof(tmpPrefs.imageBGColor));
+                std::memcpy(tmpPrefs.paramBGColor.data(), appPrefs.prefs.paramBGColor.data(), sizeof(tmpPrefs.paramBGColor));
+                std::memcpy(tmpPrefs.thumbBGColor.data(), appPrefs.prefs.thumbBGColor.data(), sizeof(tmpPrefs.thumbBGColor));
+                appPrefs.prefs = tmpPrefs;
+                appPrefs.prefs.ocioExt = ocioSel;
+                std::memset(ocioPath, 0, sizeof(ocioPath));
+                appPrefs.saveToFile();
+                preferencesPopTrig = false;
+                ImGui::CloseCurrentPopup();
             }
-            // The tmpPrefs struct contains unchanged values. Copy the
-            // accepted/changed values into the tmp so when we copy back to
-            // main the values hold with what was selected
-            std::memcpy(tmpPrefs.imageBGColor.data(), appPrefs.prefs.imageBGColor.data(), sizeof(tmpPrefs.imageBGColor));
-            std::memcpy(tmpPrefs.paramBGColor.data(), appPrefs.prefs.paramBGColor.data(), sizeof(tmpPrefs.paramBGColor));
-            std::memcpy(tmpPrefs.thumbBGColor.data(), appPrefs.prefs.thumbBGColor.data(), sizeof(tmpPrefs.thumbBGColor));
-            appPrefs.prefs = tmpPrefs;
-            appPrefs.prefs.ocioExt = ocioSel;
-            std::memset(ocioPath, 0, sizeof(ocioPath));
-            appPrefs.saveToFile();
-            preferencesPopTrig = false;
-            ImGui::CloseCurrentPopup();
         }
         if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
             std::memset(ocioPath, 0, sizeof(ocioPath));
@@ -2,6 +2,7 @@
 //#include "metalGPU.h"
 #include "window.h"
 
+#include <algorithm>
 #include <cstring>
 
 
@@ -47,12 +48,30 @@ void mainWindow::rollRender() {
 */
 void mainWindow::rollRenderCheck() {
 
+    // Images a batch analysis reloaded are kept if their
+    // roll is loaded (or loading) by the time it is done,
+    // otherwise they go back to being unloaded
+    if (!anaBatch.running()) {
+        for (auto& roll : activeRolls) {
+            bool keep = roll.rollLoaded || roll.imagesLoading;
+            for (auto& img : roll.images) {
+                if (!img.analysisReload)
+                    continue;
+                img.analysisReload = false;
+                if (!keep) {
+                    img.clearBuffers();     // Re-rendered when its roll loads
+                    img.needRndr = false;
+                }
+            }
+        }
+    }
+
     // Scan through all images needing GL updates
     // after being rendered (queued by import)
     for (int r = 0; r < activeRolls.size(); r++) {
         for (int i = 0; i < activeRolls[r].rollSize(); i++) {
             image *img = getImage(r, i);
-            if (img && img->imageLoaded && img->needRndr) {
+            if (img && img->imageLoaded && img->needRndr && !img->analysisReload) {
                 imgRender(img);
                 img->needRndr = false;
             }
@@ -67,6 +86,8 @@ void mainWindow::rollRenderCheck() {
         if (!activeRolls[r].rollLoaded || activeRolls[r].imagesLoading) {
             continue; // We don't want to inturrupt unloaded, or active rolls
         }
+        if (anaBatch.running())
+            break; // Or pull buffers out from under a batch analysis
 
         bool imRendering = false;
         for (int i = 0; i < activeRolls[r].rollSize(); i++) {
@@ -118,12 +139,32 @@ void mainWindow::stateRender() {
 
 //--- Analyze Image ---//
 /*
-    Render  the blur pass and run
-    the min/max on the resulting image
+    Run the fused blur and min/max
+    analysis on the active image, or on
+    every selected image when there are several
 */
 void mainWindow::analyzeImage() {
 
     if (validIm()) {
+        if (anaBatch.running()) {
+            std::strcpy(ackMsg, "Analysis is already running!");
+            ackPopTrig = true;
+            return;
+        }
+        std::vector<image*> selectedImages;
+        for (int i = 0; i < activeRollSize(); i++) {
+            if (getImage(i) && getImage(i)->selected)
+                selectedImages.push_back(getImage(i));
+        }
+        if (selectedImages.size() > 1) {
+            // Active image first so it updates soonest
+            auto act = std::find(selectedImages.begin(), selectedImages.end(), activeImage());
+            if (act != selectedImages.end())
+                std::rotate(selectedImages.begin(), act, act + 1);
+            analyzeImages(selectedImages);
+            return;
+        }
+
         if (!activeImage()->imageLoaded) {
             std::strcpy(ackMsg, "Cannot analyze while image is being loaded!\nWait for image to finish loading.");
             ackPopTrig = true;
@@ -133,16 +174,12 @@ void mainWindow::analyzeImage() {
         anaPopTrig = true;
 
     std::thread analyzeThread([this]{
-        if (!activeImage()->blurImgData)
-            activeImage()->allocBlurBuf();
-        activeImage()->blurImage();
-        activeImage()->processMinMax(dispOCIO);
+        activeImage()->analyzeMinMax(dispOCIO);
         if (appPrefs.prefs.cmykSliders)
             activeImage()->imgParam.rgb_to_cmyk();
         anaPopTrig = false;
         activeImage()->needMetaWrite = true;
         metaRefresh = true;
-        activeImage()->delBlurBuf();
         activeImage()->renderBypass = false;
         imgRender();
     });
@@ -151,3 +188,61 @@ void mainWindow::analyzeImage() {
 
     }
 }
+
+//--- Analyze Images ---//
+/*
+    Batch analysis over the given images, in
+    priority order. Images whose buffers were
+    unloaded are reloaded for the analysis and
+    flagged, rollRenderCheck unloads them again
+    once the batch is done unless their roll has
+    been loaded in the meantime.
+*/
+void mainWindow::analyzeImages(const std::vector<image*>& images) {
+    if (images.empty() || anaBatch.running())
+        return;
+    uint64_t budget = (uint64_t)std::max(appPrefs.prefs.analysisRam, 256) << 20;
+    ocioSetting anaOCIO = dispOCIO;
+
+    anaPopTrig = true;
+    bool started = anaBatch.start(images, budget, [anaOCIO](image* img) {
+        if (!img->imageLoaded) {
+            // Flagged first so rollRenderCheck leaves it alone
+            img->analysisReload = true;
+            img->loadBuffers();
+            if (!img->imageLoaded)
+                return false;
+        }
+        img->analyzeMinMax(anaOCIO);
+        if (appPrefs.prefs.cmykSliders)
+            img->imgParam.rgb_to_cmyk();
+        img->needMetaWrite = true;
+        img->renderBypass = false;
+        img->needRndr = true;   // Picked up by rollRenderCheck
+        return true;
+    });
+    anaPopTrig = started;
+    anaBatchPop = started;
+}
+
+//--- Analyze Rolls ---//
+/*
+    Batch analysis of every image in the
+    selected rolls, active roll first
+*/
+void mainWindow::analyzeRolls() {
+    std::vector<image*> rollImages;
+    auto addRoll = [&](int r) {
+        for (int i = 0; i < activeRolls[r].rollSize(); i++) {
+            if (getImage(r, i))
+                rollImages.push_back(getImage(r, i));
+        }
+    };
+    if (validRoll())
+        addRoll(selRoll);
+    for (int r = 0; r < activeRolls.size(); r++) {
+        if (activeRolls[r].selected && r != selRoll)
+            addRoll(r);
+    }
+    analyzeImages(rollImages);
+}
@@ -529,6 +529,26 @@ void mainWindow::paramUpdate() {
     }
  }
 
+//--- Close Selected Images ---//
+/*
+    Close the selected images in the current
+    roll, releasing their GPU textures and any
+    queued renders first so nothing is left
+    pointing at them
+ */
+void mainWindow::closeSelectedImages() {
+    if (!validRoll())
+        return;
+    for (auto& img : activeRoll()->images) {
+        if (!img.selected)
+            continue;
+        gpu->removeFromQueue(&img);
+        gpu->clearImBuffer(&img);
+        gpu->clearSmBuffer(&img);
+    }
+    activeRoll()->closeSelected();
+}
+
 //--- Remove Roll ---//
 /*
     Remove the current roll
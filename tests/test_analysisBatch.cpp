@@ -0,0 +1,181 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "analysisBatch.h"
+#include "image.h"
+#include "threadPool.h"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// Loaded image whose analysis costs w * h * 16 bytes
+static void makeImage(image& img, unsigned int w, unsigned int h, bool loaded = true) {
+    img.width = img.rawWidth = w;
+    img.height = img.rawHeight = h;
+    img.imageLoaded = loaded;
+}
+
+static std::vector<image*> pointers(std::deque<image>& images) {
+    std::vector<image*> out;
+    for (image& img : images)
+        out.push_back(&img);
+    return out;
+}
+
+// Runs with the global pool swapped for the one given (or none)
+struct poolScope {
+    ThreadPool* prev;
+    explicit poolScope(ThreadPool* pool) : prev(tPool) { tPool = pool; }
+    ~poolScope() { tPool = prev; }
+};
+
+// ---------------------------------------------------------------------------
+// analysisBatch
+// ---------------------------------------------------------------------------
+
+TEST_CASE("analysisBatch keeps in-flight buffers inside the budget", "[analysisBatch]") {
+    ThreadPool pool(4);
+    poolScope scope(&pool);
+
+    std::deque<image> images(12);
+    for (image& img : images)
+        makeImage(img, 100, 100);
+    uint64_t each = analysisBatch::analysisBytes(images[0]);
+    REQUIRE(each == 100 * 100 * 16);
+
+    std::mutex lock;
+    int running = 0, maxRunning = 0;
+    analysisBatch batch;
+    REQUIRE(batch.start(pointers(images), each * 5 / 2, [&](image*) {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            maxRunning = std::max(maxRunning, ++running);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        std::lock_guard<std::mutex> l(lock);
+        running--;
+        return true;
+    }));
+    batch.wait();
+
+    CHECK_FALSE(batch.running());
+    CHECK(batch.completed() == 12);
+    CHECK(batch.failed() == 0);
+    CHECK(batch.progress() == 1.0f);
+    CHECK(maxRunning <= 2);
+    CHECK(batch.peakBytes() <= each * 5 / 2);
+}
+
+TEST_CASE("analysisBatch starts loaded images first, then the rest in order", "[analysisBatch]") {
+    poolScope scope(nullptr);
+
+    std::deque<image> images(5);
+    makeImage(images[0], 10, 10, false);
+    makeImage(images[1], 10, 10, true);
+    makeImage(images[2], 10, 10, false);
+    makeImage(images[3], 10, 10, true);
+    makeImage(images[4], 10, 10, false);
+    CHECK(analysisBatch::analysisBytes(images[0]) > analysisBatch::analysisBytes(images[1]));
+
+    std::vector<image*> order;
+    analysisBatch batch;
+    REQUIRE(batch.start(pointers(images), 1 << 20, [&](image* img) {
+        order.push_back(img);
+        return true;
+    }));
+    batch.wait();
+
+    std::vector<image*> expect = {&images[1], &images[3], &images[0], &images[2], &images[4]};
+    CHECK(order == expect);
+}
+
+TEST_CASE("analysisBatch runs an image larger than the budget on its own", "[analysisBatch]") {
+    ThreadPool pool(4);
+    poolScope scope(&pool);
+
+    std::deque<image> images(3);
+    makeImage(images[0], 10, 10);
+    makeImage(images[1], 1000, 1000);
+    makeImage(images[2], 10, 10);
+
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    analysisBatch batch;
+    REQUIRE(batch.start(pointers(images), 1 << 20, [&](image* img) {
+        int now = ++running;
+        if (img == &images[1] && now > 1)
+            overlapped = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (img == &images[1] && running > 1)
+            overlapped = true;
+        running--;
+        return true;
+    }));
+    batch.wait();
+
+    CHECK(batch.completed() == 3);
+    CHECK_FALSE(overlapped);
+}
+
+TEST_CASE("analysisBatch cancel stops admitting and failures are counted", "[analysisBatch]") {
+    poolScope scope(nullptr);
+
+    std::deque<image> images(8);
+    for (image& img : images)
+        makeImage(img, 10, 10);
+
+    analysisBatch batch;
+    REQUIRE(batch.start(pointers(images), 1 << 20, [&](image* img) {
+        if (img == &images[2])
+            batch.cancel();
+        return img != &images[1];
+    }));
+    batch.wait();
+
+    CHECK(batch.cancelled());
+    CHECK(batch.total() == 8);
+    CHECK(batch.completed() == 3);
+    CHECK(batch.failed() == 1);
+
+    // A finished batch can be started again
+    REQUIRE(batch.start(pointers(images), 1 << 20, [](image*) { return true; }));
+    batch.wait();
+    CHECK_FALSE(batch.cancelled());
+    CHECK(batch.completed() == 8);
+}
+
+TEST_CASE("analysisBatch counts an analysis that throws as failed", "[analysisBatch]") {
+    ThreadPool pool(2);
+    poolScope scope(&pool);
+
+    std::deque<image> images(6);
+    for (image& img : images)
+        makeImage(img, 100, 100);
+    uint64_t each = analysisBatch::analysisBytes(images[0]);
+
+    analysisBatch batch;
+    REQUIRE(batch.start(pointers(images), each * 2, [&](image* img) -> bool {
+        if (img == &images[1])
+            throw std::bad_alloc();
+        if (img == &images[4])
+            throw std::runtime_error("unreadable raw");
+        return true;
+    }));
+    batch.wait();
+
+    // The thrown images still release their share of the budget
+    CHECK_FALSE(batch.running());
+    CHECK(batch.completed() == 6);
+    CHECK(batch.failed() == 2);
+
+    REQUIRE(batch.start(pointers(images), each * 2, [](image*) { return true; }));
+    batch.wait();
+    CHECK(batch.failed() == 0);
+}
@@ -0,0 +1,180 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "displayLUT.h"
+#include "threadPool.h"
+
+using Catch::Matchers::WithinAbs;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// A smooth stand-in for a display transform: a little channel
+// crosstalk, a filmic shoulder, then the sRGB curve
+static void filmicDisplay(float* rgba, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float* px = rgba + i * 4;
+        float r = 0.90f * px[0] + 0.07f * px[1] + 0.03f * px[2];
+        float g = 0.05f * px[0] + 0.90f * px[1] + 0.05f * px[2];
+        float b = 0.02f * px[0] + 0.08f * px[1] + 0.90f * px[2];
+        for (float* c : {&r, &g, &b}) {
+            float v = std::max(*c, 0.0f);
+            v = v * (2.51f * v + 0.03f) / (v * (2.43f * v + 0.59f) + 0.14f);
+            v = std::clamp(v, 0.0f, 1.0f);
+            *c = v <= 0.0031308f ? 12.92f * v : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+        }
+        px[0] = r;
+        px[1] = g;
+        px[2] = b;
+    }
+}
+
+// CIE76 between two sRGB encoded colors, D65
+static float deltaE(const float* a, const float* b) {
+    auto lab = [](const float* c, float* out) {
+        float lin[3];
+        for (int i = 0; i < 3; ++i) {
+            float v = std::clamp(c[i], 0.0f, 1.0f);
+            lin[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+        float xyz[3] = {
+            (0.4124f * lin[0] + 0.3576f * lin[1] + 0.1805f * lin[2]) / 0.95047f,
+            (0.2126f * lin[0] + 0.7152f * lin[1] + 0.0722f * lin[2]),
+            (0.0193f * lin[0] + 0.1192f * lin[1] + 0.9505f * lin[2]) / 1.08883f,
+        };
+        for (float& t : xyz)
+            t = t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+        out[0] = 116.0f * xyz[1] - 16.0f;
+        out[1] = 500.0f * (xyz[0] - xyz[1]);
+        out[2] = 200.0f * (xyz[1] - xyz[2]);
+    };
+    float la[3], lb[3];
+    lab(a, la);
+    lab(b, lb);
+    return std::sqrt((la[0] - lb[0]) * (la[0] - lb[0]) + (la[1] - lb[1]) * (la[1] - lb[1]) +
+                     (la[2] - lb[2]) * (la[2] - lb[2]));
+}
+
+// Scene-linear samples spread evenly in stops over the shaper range
+static std::vector<float> sceneSamples(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> stops(DISPLAY_LUT_LOG2_MIN, DISPLAY_LUT_LOG2_MAX);
+    std::vector<float> px(count * 4);
+    for (size_t i = 0; i < count; ++i) {
+        for (int ch = 0; ch < 3; ++ch)
+            px[i * 4 + ch] = std::exp2(stops(rng));
+        px[i * 4 + 3] = 0.5f;
+    }
+    return px;
+}
+
+// ---------------------------------------------------------------------------
+// displayLUT
+// ---------------------------------------------------------------------------
+
+TEST_CASE("display LUT shaper covers the range and inverts", "[displayLUT]") {
+    displayLUT lut;
+    CHECK(displayLUTShaper(lut, std::exp2(DISPLAY_LUT_LOG2_MIN)) == 0.0f);
+    CHECK_THAT(displayLUTShaper(lut, std::exp2(DISPLAY_LUT_LOG2_MAX)), WithinAbs(1.0f, 1e-6));
+    CHECK(displayLUTShaper(lut, 0.0f) == 0.0f);
+    CHECK(displayLUTShaper(lut, -1.0f) == 0.0f);
+    CHECK(displayLUTShaper(lut, NAN) == 0.0f);
+    CHECK(displayLUTShaper(lut, 1e6f) == 1.0f);
+    for (float s : {0.0f, 0.25f, 0.5f, 0.9f, 1.0f})
+        CHECK_THAT(displayLUTShaper(lut, displayLUTUnshaper(lut, s)), WithinAbs(s, 1e-5));
+}
+
+TEST_CASE("display LUT reproduces a transform affine in shaper space", "[displayLUT]") {
+    displayLUT lut;
+    bakeDisplayLUT(lut, [&lut](float* rgba, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            float s[3];
+            for (int ch = 0; ch < 3; ++ch)
+                s[ch] = displayLUTShaper(lut, rgba[i * 4 + ch]);
+            rgba[i * 4 + 0] = 0.7f * s[0] + 0.2f * s[1] + 0.1f * s[2];
+            rgba[i * 4 + 1] = s[1] - 0.3f * s[2];
+            rgba[i * 4 + 2] = 0.25f + 0.5f * s[2];
+        }
+    }, 17);
+    REQUIRE(lut.valid());
+
+    std::vector<float> px = sceneSamples(5000, 7);
+    std::vector<float> expect = px;
+    applyDisplayLUT(lut, px.data(), 5000);
+    for (size_t i = 0; i < 5000; ++i) {
+        float s[3];
+        for (int ch = 0; ch < 3; ++ch)
+            s[ch] = displayLUTShaper(lut, expect[i * 4 + ch]);
+        // Tetrahedral interpolation is exact for affine functions
+        CHECK_THAT(px[i * 4 + 0], WithinAbs(0.7f * s[0] + 0.2f * s[1] + 0.1f * s[2], 1e-5));
+        CHECK_THAT(px[i * 4 + 1], WithinAbs(s[1] - 0.3f * s[2], 1e-5));
+        CHECK_THAT(px[i * 4 + 2], WithinAbs(0.25f + 0.5f * s[2], 1e-5));
+        CHECK(px[i * 4 + 3] == 0.5f);   // alpha untouched
+    }
+}
+
+TEST_CASE("display LUT accuracy against a filmic display transform", "[displayLUT]") {
+    displayLUT lut;
+    bakeDisplayLUT(lut, filmicDisplay);
+    REQUIRE(lut.valid());
+    REQUIRE(lut.size == DISPLAY_LUT_SIZE);
+
+    size_t count = 100000;
+    std::vector<float> fast = sceneSamples(count, 11);
+    std::vector<float> exact = fast;
+    filmicDisplay(exact.data(), count);
+
+    ThreadPool pool(4);
+    ThreadPool* prev = tPool;
+    tPool = &pool;
+    applyDisplayLUT(lut, fast.data(), count);
+    tPool = prev;
+
+    double sum = 0.0;
+    float worst = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float e = deltaE(&fast[i * 4], &exact[i * 4]);
+        sum += e;
+        worst = std::max(worst, e);
+    }
+    float mean = (float)(sum / count);
+    WARN("65^3 display LUT vs exact: mean dE76 " << mean << ", max dE76 " << worst);
+    CHECK(mean < 0.1f);
+    CHECK(worst < 1.0f);
+}
+
+// Not run by default: filmvert_tests "[.lutBench]"
+TEST_CASE("display LUT benchmark", "[.lutBench]") {
+    displayLUT lut;
+    bakeDisplayLUT(lut, filmicDisplay);
+    // Smooth gradients, closer to a photo than random samples
+    unsigned int w = 3000, h = 2000;
+    size_t count = (size_t)w * h;
+    std::vector<float> src(count * 4);
+    for (unsigned int y = 0; y < h; ++y) {
+        for (unsigned int x = 0; x < w; ++x) {
+            float* p = &src[((size_t)y * w + x) * 4];
+            p[0] = std::exp2(-8.0f + 11.0f * x / w);
+            p[1] = std::exp2(-8.0f + 11.0f * y / h);
+            p[2] = 0.5f * (p[0] + p[1]);
+            p[3] = 1.0f;
+        }
+    }
+    std::vector<float> px(src.size());
+
+    BENCHMARK("exact transform") {
+        px = src;
+        filmicDisplay(px.data(), count);
+        return px[0];
+    };
+    BENCHMARK("tetrahedral LUT") {
+        px = src;
+        applyDisplayLUT(lut, px.data(), count);
+        return px[0];
+    };
+}
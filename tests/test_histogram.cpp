@@ -0,0 +1,255 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "histogramKernel.h"
+#include "threadPool.h"
+#include "utils.h"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// The per-pixel binning the span kernel replaced
+static HistogramData referenceHistogram(const float* rgba, int width, int height,
+                                        const unsigned int* xPoints, const unsigned int* yPoints,
+                                        bool cropped) {
+    HistogramData h;
+    for (int i = 0; i < width * height; ++i) {
+        int x = i % width;
+        int y = i / width;
+        if (!cropped && !isPointInBox(x, y, xPoints, yPoints))
+            continue;
+        float c[3];
+        int v[3];
+        for (int ch = 0; ch < 3; ++ch) {
+            c[ch] = std::clamp(rgba[i * 4 + ch], 0.0f, 1.0f);
+            v[ch] = (int)(c[ch] * 255.0f + 0.5f);
+        }
+        int l = (int)((0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2]) * 255.0f + 0.5f);
+        for (int bin : {v[0] * 2, v[0] * 2 + 1}) h.r_hist[bin]++;
+        for (int bin : {v[1] * 2, v[1] * 2 + 1}) h.g_hist[bin]++;
+        for (int bin : {v[2] * 2, v[2] * 2 + 1}) h.b_hist[bin]++;
+        for (int bin : {l * 2, l * 2 + 1}) h.luminance_hist[bin]++;
+    }
+    return h;
+}
+
+static std::vector<float> makeHistImage(int w, int h) {
+    std::vector<float> img(w * h * 4);
+    for (int i = 0; i < w * h * 4; ++i)
+        img[i] = -0.1f + 1.2f * std::fabs(std::sin(i * 0.0137f + (i % 7) * 0.9f));
+    return img;
+}
+
+static bool sameHistogram(const HistogramData& a, const HistogramData& b) {
+    return a.r_hist == b.r_hist && a.g_hist == b.g_hist &&
+           a.b_hist == b.b_hist && a.luminance_hist == b.luminance_hist;
+}
+
+// ---------------------------------------------------------------------------
+// Histogram kernel
+// ---------------------------------------------------------------------------
+
+TEST_CASE("histogram kernel matches per-pixel binning", "[histogram]") {
+    int w = 333, h = 211;
+    std::vector<float> img = makeHistImage(w, h);
+
+    // Rotated crop box, full image, and a box hanging off the edge
+    unsigned int boxes[3][8] = {
+        {40, 300, 280, 20,   10, 50, 200, 160},
+        {0, (unsigned)w, (unsigned)w, 0,   0, 0, (unsigned)h, (unsigned)h},
+        {200, 400, 400, 200,   100, 100, 300, 300},
+    };
+    for (auto& box : boxes) {
+        for (bool cropped : {false, true}) {
+            HistogramData got;
+            calculateHistogramFromRGBA(img.data(), w, h, got, box, box + 4, cropped);
+            CHECK(sameHistogram(got, referenceHistogram(img.data(), w, h, box, box + 4, cropped)));
+        }
+    }
+}
+
+TEST_CASE("histogram kernel counts NaN and out of range values at the ends", "[histogram]") {
+    std::vector<float> img = {NAN, 2.0f, -1.0f, 1.0f,   0.5f, 0.5f, 0.5f, 1.0f};
+    unsigned int box[4] = {0, 2, 2, 0};
+    unsigned int boxY[4] = {0, 0, 1, 1};
+    HistogramData got;
+    calculateHistogramFromRGBA(img.data(), 2, 1, got, box, boxY, true);
+    CHECK(got.r_hist[0] == 1);
+    CHECK(got.g_hist[511] == 1);
+    CHECK(got.b_hist[0] == 1);
+    CHECK(got.r_hist[256] == 1);    // 0.5 rounds to level 128
+    CHECK(got.r_hist[257] == 1);
+
+    calculateHistogramFromRGBA(nullptr, 2, 1, got, box, boxY, true);
+    CHECK(*std::max_element(got.r_hist.begin(), got.r_hist.end()) == 0);
+}
+
+TEST_CASE("histogram kernel is the same on the pool", "[histogram]") {
+    int w = 1024, h = 640;
+    std::vector<float> img = makeHistImage(w, h);
+    unsigned int boxX[4] = {100, 900, 950, 60};
+    unsigned int boxY[4] = {20, 60, 600, 580};
+
+    HistogramData inline_;
+    calculateHistogramFromRGBA(img.data(), w, h, inline_, boxX, boxY, false);
+
+    ThreadPool pool(4);
+    ThreadPool* prev = tPool;
+    tPool = &pool;
+    HistogramData pooled;
+    calculateHistogramFromRGBA(img.data(), w, h, pooled, boxX, boxY, false);
+    tPool = prev;
+    CHECK(sameHistogram(inline_, pooled));
+}
+
+TEST_CASE("sampled histogram bins everything when under budget", "[histogram]") {
+    int w = 200, h = 120;
+    std::vector<float> img = makeHistImage(w, h);
+    std::vector<rowSpan> spans;
+    unsigned int boxX[4] = {0, 0, 0, 0}, boxY[4] = {0, 0, 0, 0};
+    histogramSpans(w, h, boxX, boxY, true, spans);
+
+    HistogramData full, sampled;
+    binHistogramSpans(img.data(), w, spans.data(), spans.size(), full);
+    binHistogramSampled(img.data(), w, spans.data(), spans.size(), 0, sampled);
+    CHECK(sameHistogram(full, sampled));
+    binHistogramSampled(img.data(), w, spans.data(), spans.size(), w * h, sampled);
+    CHECK(sameHistogram(full, sampled));
+}
+
+TEST_CASE("sampled histogram keeps the total and the shape", "[histogram]") {
+    int w = 1200, h = 800;
+    std::vector<float> img(w * h * 4);
+    // Smooth gradient so a decimated grid sees the same distribution
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float* px = &img[(y * w + x) * 4];
+            px[0] = (float)x / w;
+            px[1] = (float)y / h;
+            px[2] = 0.5f * ((float)x / w + (float)y / h);
+            px[3] = 1.0f;
+        }
+    }
+    unsigned int boxX[4] = {60, 1100, 1150, 30};
+    unsigned int boxY[4] = {40, 20, 760, 780};
+    std::vector<rowSpan> spans;
+    histogramSpans(w, h, boxX, boxY, false, spans);
+
+    HistogramData full, sampled;
+    binHistogramSpans(img.data(), w, spans.data(), spans.size(), full);
+    binHistogramSampled(img.data(), w, spans.data(), spans.size(), 40000, sampled);
+
+    auto total = [](const std::array<int, 512>& hist) {
+        long long sum = 0;
+        for (int v : hist)
+            sum += v;
+        return sum;
+    };
+    long long expected = total(full.r_hist);
+    CHECK(std::abs(total(sampled.r_hist) - expected) < expected / 100);
+
+    // Per 32-level band, the sample stays within a few percent of the band
+    for (auto ch : {&HistogramData::r_hist, &HistogramData::g_hist, &HistogramData::luminance_hist}) {
+        for (int band = 0; band < 512; band += 64) {
+            long long f = 0, s = 0;
+            for (int i = band; i < band + 64; ++i) {
+                f += (full.*ch)[i];
+                s += (sampled.*ch)[i];
+            }
+            CHECK(std::abs(s - f) <= f / 20 + 64);
+        }
+    }
+}
+
+TEST_CASE("histogram cache drops the least recently used", "[histogram]") {
+    histogramCache cache(2);
+    HistogramData a, b, c, out;
+    a.r_hist[0] = 1;
+    b.r_hist[0] = 2;
+    c.r_hist[0] = 3;
+
+    CHECK_FALSE(cache.find(1, out));
+    cache.insert(1, a);
+    cache.insert(2, b);
+    REQUIRE(cache.find(1, out));        // 1 is now the most recent
+    CHECK(out.r_hist[0] == 1);
+    cache.insert(3, c);                 // so 2 goes
+    CHECK(cache.size() == 2);
+    CHECK_FALSE(cache.find(2, out));
+    REQUIRE(cache.find(3, out));
+    CHECK(out.r_hist[0] == 3);
+    CHECK(cache.hits() == 2);
+    CHECK(cache.misses() == 2);
+
+    // Re-inserting a key replaces it rather than adding one
+    cache.insert(3, a);
+    CHECK(cache.size() == 2);
+    REQUIRE(cache.find(3, out));
+    CHECK(out.r_hist[0] == 1);
+
+    cache.clear();
+    CHECK(cache.size() == 0);
+    CHECK_FALSE(cache.find(1, out));
+}
+
+TEST_CASE("histogram bar heights scale each channel to its peak", "[histogram]") {
+    HistogramData h;
+    for (int bin = 0; bin < 512; ++bin) {
+        h.r_hist[bin] = bin;
+        h.g_hist[bin] = 1000;
+    }
+    h.b_hist[7] = 1;
+    h.luminance_hist[100] = 1000000;     // one spike
+    for (int bin = 0; bin < 50; ++bin)
+        h.luminance_hist[bin] = 100;
+
+    std::vector<float> heights(512 * 4);
+    histogramBarHeights(h, 246, heights.data());
+
+    CHECK(heights[0 * 4 + 0] == 0.0f);          // empty bins stay empty
+    CHECK(heights[1 * 4 + 0] == 2.0f);          // filled bins are at least 2 tall
+    CHECK(heights[511 * 4 + 0] == 246.0f);      // the peak fills the bar
+    CHECK(heights[300 * 4 + 1] == 246.0f);      // flat channel is full everywhere
+    CHECK(heights[7 * 4 + 2] == 246.0f);
+    CHECK(heights[8 * 4 + 2] == 0.0f);
+
+    // The spike is dampened, so the rest of luma stays visible
+    CHECK(heights[10 * 4 + 3] > 2.0f);
+    CHECK(heights[100 * 4 + 3] > 246.0f);
+}
+
+TEST_CASE("hashBytes chains and tells inputs apart", "[histogram]") {
+    float a[3] = {0.1f, 0.2f, 0.3f};
+    float b[3] = {0.1f, 0.2f, 0.30001f};
+    CHECK(hashBytes(a, sizeof(a)) == hashBytes(a, sizeof(a)));
+    CHECK(hashBytes(a, sizeof(a)) != hashBytes(b, sizeof(b)));
+    uint64_t chained = hashBytes(a + 1, 2 * sizeof(float), hashBytes(a, sizeof(float)));
+    CHECK(chained == hashBytes(a, sizeof(a)));
+}
+
+// Not run by default: filmvert_tests "[.histBench]"
+TEST_CASE("histogram kernel benchmark", "[.histBench]") {
+    int w = 3000, h = 2000;
+    std::vector<float> img = makeHistImage(w, h);
+    unsigned int boxX[4] = {150, 2850, 2900, 100};
+    unsigned int boxY[4] = {80, 120, 1950, 1900};
+
+    BENCHMARK("per-pixel reference") {
+        return referenceHistogram(img.data(), w, h, boxX, boxY, false);
+    };
+    BENCHMARK("span kernel") {
+        HistogramData out;
+        calculateHistogramFromRGBA(img.data(), w, h, out, boxX, boxY, false);
+        return out;
+    };
+    std::vector<rowSpan> spans;
+    histogramSpans(w, h, boxX, boxY, false, spans);
+    BENCHMARK("sampled, 131072 pixels") {
+        HistogramData out;
+        binHistogramSampled(img.data(), w, spans.data(), spans.size(), 131072, out);
+        return out;
+    };
+}
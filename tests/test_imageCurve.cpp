@@ -1,8 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include "imageParams.h"
+#include "curveLUT.h"
 #include <nlohmann/json.hpp>
 #include <array>
+#include <cmath>
+#include <limits>
 
 using Catch::Matchers::WithinAbs;
 
@@ -170,3 +173,108 @@ TEST_CASE("std::array<imageCurve,4> JSON: empty curve entries fall back to ident
     for (int i = 0; i < 4; ++i)
         CHECK(curves[i].isIdentity());
 }
+
+// ---------------------------------------------------------------------------
+// compiled curves (curveLUT.h) against the reference spline
+// ---------------------------------------------------------------------------
+float evalCurve(float v, const float* curve, int n); // imageProcessing.cpp
+
+static void requireCompiledMatches(const float* curve, int n) {
+    compiledCurve c;
+    compileCurve(curve, n, c);
+    // Sweep well past both ends to cover extrapolation
+    for (int i = 0; i <= 4000; ++i) {
+        float v = -0.5f + 2.0f * i / 4000.0f;
+        INFO("n = " << n << ", v = " << v);
+        REQUIRE_THAT(evalCompiledCurve(c, v), WithinAbs(evalCurve(v, curve, n), 2e-5f));
+    }
+    // Exactly on every control point
+    for (int i = 0; i < n; ++i)
+        REQUIRE_THAT(evalCompiledCurve(c, curve[i * 2]),
+                     WithinAbs(evalCurve(curve[i * 2], curve, n), 2e-5f));
+}
+
+TEST_CASE("compiledCurve: matches evalCurve for default and edited curves", "[curveLUT]") {
+    float identity[] = {0.0f, 0.0f, 0.25f, 0.25f, 0.5f, 0.5f, 0.75f, 0.75f, 1.0f, 1.0f};
+    requireCompiledMatches(identity, 5);
+
+    float sCurve[] = {0.0f, 0.05f, 0.2f, 0.12f, 0.5f, 0.55f, 0.8f, 0.92f, 1.0f, 0.97f};
+    requireCompiledMatches(sCurve, 5);
+
+    float twoPoint[] = {0.1f, 0.2f, 0.9f, 0.8f};
+    requireCompiledMatches(twoPoint, 2);
+
+    // Flat section and a near-duplicate point
+    float flat[] = {0.0f, 0.0f, 0.3f, 0.4f, 0.6f, 0.4f, 0.60005f, 0.7f, 1.0f, 1.0f};
+    requireCompiledMatches(flat, 5);
+}
+
+TEST_CASE("compiledCurve: matches evalCurve with the maximum point count", "[curveLUT]") {
+    float curve[CURVE_MAX_PTS * 2];
+    uint32_t state = 99;
+    float x = 0.0f;
+    for (int i = 0; i < CURVE_MAX_PTS; ++i) {
+        state = state * 1664525u + 1013904223u;
+        x += 0.01f + 0.1f * (state >> 8) / float(1u << 24);
+        curve[i * 2]     = x;
+        curve[i * 2 + 1] = (state >> 16) / 65536.0f;
+    }
+    requireCompiledMatches(curve, CURVE_MAX_PTS);
+}
+
+TEST_CASE("compiledCurve: unsorted points fall back to the reference search", "[curveLUT]") {
+    float curve[] = {0.0f, 0.0f, 0.6f, 0.3f, 0.4f, 0.7f, 1.0f, 1.0f};
+    requireCompiledMatches(curve, 4);
+}
+
+TEST_CASE("compiledCurve: fewer than two points passes values through", "[curveLUT]") {
+    float curve[] = {0.5f, 0.2f};
+    compiledCurve c;
+    compileCurve(curve, 1, c);
+    CHECK(evalCompiledCurve(c, 0.3f) == 0.3f);
+}
+
+TEST_CASE("compiledCurve: NaN and infinities behave like evalCurve", "[curveLUT]") {
+    float sCurve[] = {0.0f, 0.05f, 0.2f, 0.12f, 0.5f, 0.55f, 0.8f, 0.92f, 1.0f, 0.97f};
+    float flatEnds[] = {0.0f, 0.2f, 0.1f, 0.2f, 0.9f, 0.8f, 1.0f, 0.8f};
+    for (auto [curve, n] : {std::pair{sCurve, 5}, std::pair{flatEnds, 4}}) {
+        compiledCurve c;
+        compileCurve(curve, n, c);
+        CHECK(std::isnan(evalCompiledCurve(c, std::nanf(""))));
+        for (float v : {std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()}) {
+            float expect = evalCurve(v, curve, n);
+            float got = evalCompiledCurve(c, v);
+            INFO("n = " << n << ", v = " << v);
+            if (std::isnan(expect))
+                CHECK(std::isnan(got));
+            else
+                CHECK(got == expect);
+        }
+    }
+}
+
+TEST_CASE("curveCache: recompiles only when points change", "[curveLUT]") {
+    renderParams p{};
+    imageCurve def;
+    float* dst[4] = {p.curveW, p.curveR, p.curveG, p.curveB};
+    int* n[4] = {&p.curveW_n, &p.curveR_n, &p.curveG_n, &p.curveB_n};
+    for (int ch = 0; ch < 4; ++ch) {
+        *n[ch] = def.n();
+        for (int i = 0; i < def.n(); ++i) {
+            dst[ch][i * 2]     = def.px[i];
+            dst[ch][i * 2 + 1] = def.py[i];
+        }
+    }
+
+    curveCache cache;
+    CHECK(cache.update(p));
+    CHECK_FALSE(cache.update(p));
+
+    // Unused slots past n don't count as a change
+    p.curveG[CURVE_MAX_PTS * 2 - 1] = 0.5f;
+    CHECK_FALSE(cache.update(p));
+
+    p.curveR[5] = 0.6f;
+    CHECK(cache.update(p));
+    CHECK_THAT(evalCompiledCurve(cache.luts().ch[CURVE_R], 0.5f), WithinAbs(0.6f, 1e-6f));
+}
@@ -1,8 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <algorithm>
 #include <cmath>
+#include <mutex>
 #include <vector>
 #include "image.h"         // float4
+#include "gradeKernel.h"   // SIMD grade kernels
+#include "gradeLUT.h"      // baked grade tables
+#include "gaussianBlur.h"  // analysis blur
 #include "renderParams.h"  // renderParams, CURVE_MAX_PTS
 
 using Catch::Matchers::WithinAbs;
@@ -409,3 +414,709 @@ TEST_CASE("getCroppedRotatedUV: 90-degree rotation on a square image", "[cropRot
     REQUIRE_THAT(outU, WithinAbs(1.0f, 1e-5f));
     REQUIRE_THAT(outV, WithinAbs(0.5f, 1e-5f));
 }
+
+// ---------------------------------------------------------------------------
+// renderCPUTiles — fused grade -> display -> curves pipeline
+// ---------------------------------------------------------------------------
+
+// Neutral grade with a film-like base, mild balance, and a non-identity curve
+static renderParams makeGradeParams(int w, int h) {
+    renderParams p = makeBaseParams(w, h);
+    p.bypass      = 0;
+    p.gradeBypass = 0;
+    p.temp        = 0.1f;
+    p.tint        = -0.05f;
+    p.saturation  = 0.2f;
+    for (int i = 0; i < 4; ++i) {
+        p.baseColor[i]    = i == 3 ? 0.0f : 0.8f - 0.1f * i;
+        p.blackPoint[i]   = 0.0f;
+        p.whitePoint[i]   = 1.0f;
+        p.G_blackpoint[i] = 0.0f;
+        p.G_whitepoint[i] = 1.0f;
+        p.G_lift[i]       = 0.0f;
+        p.G_gain[i]       = 1.0f;
+        p.G_mult[i]       = 1.0f;
+        p.G_offset[i]     = 0.0f;
+        p.G_gamma[i]      = 1.0f;
+    }
+    for (int i = 0; i < 3; ++i) {
+        p.G_matrixR[i] = i == 0 ? 1.0f : 0.0f;
+        p.G_matrixG[i] = i == 1 ? 1.0f : 0.0f;
+        p.G_matrixB[i] = i == 2 ? 1.0f : 0.0f;
+    }
+    const float px[5] = {0.00f, 0.25f, 0.50f, 0.75f, 1.00f};
+    const float py[5] = {0.00f, 0.20f, 0.55f, 0.85f, 1.00f};
+    makeCurve(p.curveW, px, py, 5);
+    makeCurve(p.curveR, kIdentityPx, kIdentityPy, kN5);
+    makeCurve(p.curveG, px, py, 5);
+    makeCurve(p.curveB, kIdentityPx, kIdentityPy, kN5);
+    p.curveW_n = p.curveR_n = p.curveG_n = p.curveB_n = 5;
+    return p;
+}
+
+// Smooth gradient so sampling and grading both vary per pixel
+static std::vector<float> makeGradientImage(int w, int h) {
+    std::vector<float> img(w * h * 4);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float* px = &img[(y * w + x) * 4];
+            px[0] = 0.05f + 0.5f * x / w;
+            px[1] = 0.05f + 0.4f * y / h;
+            px[2] = 0.10f + 0.2f * (x + y) / (w + h);
+            px[3] = 1.0f;
+        }
+    }
+    return img;
+}
+
+// Stand-in for the OCIO display transform
+static void fakeDisplay(float* pixels, unsigned int w, unsigned int h) {
+    for (size_t i = 0; i < (size_t)w * h; ++i) {
+        for (int c = 0; c < 3; ++c)
+            pixels[i * 4 + c] = std::pow(std::max(pixels[i * 4 + c], 0.0f) * 0.8f, 1.0f / 2.2f);
+    }
+}
+
+// Render with the given band height into a sentinel-filled buffer
+static std::vector<float> renderBands(cpuRenderJob job, const std::vector<float>& src,
+                                      unsigned int bandRows) {
+    std::vector<float> dst(job.outWidth * job.outHeight * 4, -1.0f);
+    job.src = src.data();
+    job.dst = dst.data();
+    renderCPUTiles(job, fakeDisplay, bandRows);
+    return dst;
+}
+
+static void requireSameImage(const std::vector<float>& a, const std::vector<float>& b) {
+    REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i)
+        REQUIRE_THAT(a[i], WithinAbs(b[i], 1e-6f));
+}
+
+// The unfused pipeline: scalar grade, display transform and
+// spline curves, each run over the whole image in turn
+static std::vector<float> renderSeparatePasses(const renderParams& p, const std::vector<float>& src,
+                                               int w, int h) {
+    std::vector<float> out(src.size());
+    gradePixelsCPU(p, src.data(), out.data(), (size_t)w * h);
+    fakeDisplay(out.data(), w, h);
+    for (size_t i = 0; i < (size_t)w * h; ++i) {
+        float* px = &out[i * 4];
+        px[0] = evalCurve(px[0], p.curveR, p.curveR_n);
+        px[1] = evalCurve(px[1], p.curveG, p.curveG_n);
+        px[2] = evalCurve(px[2], p.curveB, p.curveB_n);
+        for (int c = 0; c < 3; ++c)
+            px[c] = evalCurve(px[c], p.curveW, p.curveW_n);
+    }
+    return out;
+}
+
+TEST_CASE("renderCPUTiles: banded render matches the separate-pass reference", "[cpuRender]") {
+    const int w = 37, h = 29;
+    auto src = makeGradientImage(w, h);
+    cpuRenderJob job;
+    job.srcWidth = job.outWidth = w;
+    job.srcHeight = job.outHeight = h;
+    job.params = makeGradeParams(w, h);
+    job.params.G_lift[0]  = 0.02f;
+    job.params.G_gain[2]  = 1.1f;
+    job.params.G_gamma[1] = 1.2f;
+
+    // The fused path may use a SIMD kernel or the baked grade
+    // and compiled curves, so allow their small errors
+    auto reference = renderSeparatePasses(job.params, src, w, h);
+    for (unsigned int rows : {1u, 3u, 8u, (unsigned int)h, 0u}) {
+        auto out = renderBands(job, src, rows);
+        INFO("band rows " << rows);
+        REQUIRE(out.size() == reference.size());
+        for (size_t i = 0; i < out.size(); ++i) {
+            INFO("value " << i << " pixel " << i / 4);
+            REQUIRE_THAT(out[i], WithinAbs(reference[i], std::max(1e-4f, std::abs(reference[i]) * 5e-4f)));
+        }
+    }
+}
+
+TEST_CASE("renderCPUTiles: banded render matches with crop and rotation", "[cpuRender]") {
+    const int w = 40, h = 32;
+    auto src = makeGradientImage(w, h);
+    cpuRenderJob job;
+    job.srcWidth = w;
+    job.srcHeight = h;
+    job.params = makeGradeParams(w, h);
+    job.params.cropEnable    = 1;
+    job.params.imageCropMinX = 0.1f;  job.params.imageCropMinY = 0.2f;
+    job.params.imageCropMaxX = 0.9f;  job.params.imageCropMaxY = 0.7f;
+    job.params.arbitraryRotation = 0.15f;
+    job.outWidth  = (job.params.imageCropMaxX - job.params.imageCropMinX) * w;
+    job.outHeight = (job.params.imageCropMaxY - job.params.imageCropMinY) * h;
+
+    auto reference = renderBands(job, src, job.outHeight);
+    requireSameImage(renderBands(job, src, 5), reference);
+}
+
+TEST_CASE("renderCPUTiles: bypass skips curves in every band", "[cpuRender]") {
+    const int w = 16, h = 12;
+    auto src = makeGradientImage(w, h);
+    cpuRenderJob job;
+    job.srcWidth = job.outWidth = w;
+    job.srcHeight = job.outHeight = h;
+    job.params = makeGradeParams(w, h);
+    job.params.bypass = 1;
+
+    // Bypassed output is the source run through the display transform only
+    auto out = renderBands(job, src, 4);
+    auto expected = src;
+    fakeDisplay(expected.data(), w, h);
+    requireSameImage(out, expected);
+}
+
+TEST_CASE("renderCPUTiles: display transform sees each row exactly once", "[cpuRender]") {
+    const int w = 10, h = 23;
+    auto src = makeGradientImage(w, h);
+    std::vector<float> dst(w * h * 4);
+    cpuRenderJob job;
+    job.src = src.data();
+    job.dst = dst.data();
+    job.srcWidth = job.outWidth = w;
+    job.srcHeight = job.outHeight = h;
+    job.params = makeGradeParams(w, h);
+
+    std::vector<int> rowHits(h, 0);
+    std::mutex hitLock;
+    renderCPUTiles(job, [&](float* pixels, unsigned int bw, unsigned int bh) {
+        CHECK(bw == (unsigned int)w);
+        size_t row = (pixels - dst.data()) / (w * 4);
+        std::lock_guard lock(hitLock);
+        for (size_t y = row; y < row + bh; ++y)
+            rowHits[y]++;
+    }, 4);
+    for (int hits : rowHits)
+        REQUIRE(hits == 1);
+}
+
+// ---------------------------------------------------------------------------
+// SIMD grade kernels vs the scalar reference
+// ---------------------------------------------------------------------------
+
+// Pseudo-random pixels covering both JPLog segments, plus zero and tiny values
+static std::vector<float> makeNoiseImage(size_t count) {
+    std::vector<float> img(count * 4);
+    uint32_t state = 12345;
+    for (size_t i = 0; i < count * 4; ++i) {
+        state = state * 1664525u + 1013904223u;
+        img[i] = 1.6f * (state >> 8) / float(1u << 24);
+    }
+    img[0] = 0.0f;
+    img[1] = 1e-6f;
+    return img;
+}
+
+static void requireKernelMatches(gradeKernelFn kernel, const renderParams& p,
+                                 const std::vector<float>& src) {
+    size_t count = src.size() / 4;
+    std::vector<float> ref(src.size()), out(src.size(), -1.0f);
+    gradePixelsCPU(p, src.data(), ref.data(), count);
+
+    gradeConsts consts;
+    makeGradeConsts(p, consts);
+    kernel(consts, src.data(), out.data(), count);
+
+    for (size_t i = 0; i < ref.size(); ++i) {
+        INFO("value " << i << " pixel " << i / 4);
+        float tol = std::max(1e-5f, std::abs(ref[i]) * 2e-4f);
+        REQUIRE_THAT(out[i], WithinAbs(ref[i], tol));
+    }
+}
+
+// Every grade control moved away from neutral
+static renderParams makeStrongGradeParams() {
+    renderParams graded = makeGradeParams(1, 1);
+    graded.temp = -0.3f;
+    graded.tint = 0.4f;
+    graded.saturation = -0.25f;
+    for (int i = 0; i < 3; ++i) {
+        graded.blackPoint[i]   = 0.02f * i;
+        graded.whitePoint[i]   = 0.9f + 0.05f * i;
+        graded.G_blackpoint[i] = -0.01f;
+        graded.G_whitepoint[i] = 1.1f;
+        graded.G_lift[i]       = 0.03f - 0.02f * i;
+        graded.G_gain[i]       = 1.2f - 0.1f * i;
+        graded.G_mult[i]       = 0.95f;
+        graded.G_offset[i]     = -0.02f;
+        graded.G_gamma[i]      = 0.8f + 0.2f * i;
+    }
+    graded.G_matrixR[1] = 0.1f;  graded.G_matrixR[0] = 0.9f;
+    graded.G_matrixB[0] = -0.05f; graded.G_matrixB[2] = 1.05f;
+    return graded;
+}
+
+TEST_CASE("grade kernels match the scalar reference", "[gradeKernel]") {
+    // Odd count so every kernel runs a partial tail
+    auto src = makeNoiseImage(1003);
+
+    renderParams neutral = makeGradeParams(1, 1);
+    renderParams graded = makeStrongGradeParams();
+
+    renderParams gradeBypass = graded;
+    gradeBypass.gradeBypass = 1;
+    renderParams bypass = graded;
+    bypass.bypass = 1;
+
+    int tested = 0;
+    for (int isa = GRADE_ISA_SCALAR + 1; isa < GRADE_ISA_COUNT; ++isa) {
+        gradeKernelFn kernel = gradeKernel((gradeIsa)isa);
+        // Only kernels that were built and that this CPU can run
+        if (!kernel || isa > detectGradeIsa())
+            continue;
+        DYNAMIC_SECTION(gradeIsaName((gradeIsa)isa)) {
+            requireKernelMatches(kernel, neutral, src);
+            requireKernelMatches(kernel, graded, src);
+            requireKernelMatches(kernel, gradeBypass, src);
+            requireKernelMatches(kernel, bypass, src);
+        }
+        tested++;
+    }
+    if (tested == 0)
+        SUCCEED("No SIMD grade kernel available on this machine");
+}
+
+TEST_CASE("grade kernels handle an empty span", "[gradeKernel]") {
+    gradeKernelFn kernel = activeGradeKernel();
+    if (!kernel)
+        return;
+    renderParams p = makeGradeParams(1, 1);
+    gradeConsts consts;
+    makeGradeConsts(p, consts);
+    float sentinel[4] = {-1.0f, -1.0f, -1.0f, -1.0f};
+    kernel(consts, sentinel, sentinel, 0);
+    CHECK(sentinel[0] == -1.0f);
+}
+
+// ---------------------------------------------------------------------------
+// Baked grade LUTs vs the exact grade
+// ---------------------------------------------------------------------------
+
+// Same relative measure the baker uses
+static float lutRelError(float approx, float exact) {
+    return std::abs(approx - exact) / std::max(std::abs(exact), 1e-3f);
+}
+
+// Sweep the post stage through both tables and past their ends
+static void requirePostWithin(const bakedGrade& bake, float bound) {
+    for (int ch = 0; ch < 3; ++ch) {
+        const bakedGradeChannel& c = bake.ch[ch];
+        for (float v = -0.6f; v < 1e5f; v = v < 1e-3f ? v + 1e-5f : v * 1.0003f) {
+            float exact = gradePostCPU(v, c.aGrade, c.bGrade, c.gamma);
+            float baked = evalGradePost(bake, ch, v);
+            INFO("channel " << ch << " v " << v << " exact " << exact << " baked " << baked);
+            if (!std::isfinite(exact)) {
+                REQUIRE(baked == exact);
+                continue;
+            }
+            REQUIRE(lutRelError(baked, exact) <= bound);
+        }
+    }
+}
+
+TEST_CASE("compileGradeLUT meets its error bound", "[gradeLUT]") {
+    renderParams neutral = makeGradeParams(1, 1);
+    renderParams graded = makeStrongGradeParams();
+    for (const renderParams* p : {&neutral, &graded}) {
+        bakedGrade bake;
+        REQUIRE(compileGradeLUT(*p, bake));
+        REQUIRE(bake.valid);
+        CHECK(bake.bits >= GRADE_LUT_MIN_BITS);
+        CHECK(bake.bits <= GRADE_LUT_MAX_BITS);
+        CHECK(bake.maxError <= GRADE_LUT_MAX_ERROR);
+        requirePostWithin(bake, GRADE_LUT_MAX_ERROR);
+    }
+}
+
+TEST_CASE("compileGradeLUT grows the table for a tighter bound", "[gradeLUT]") {
+    renderParams p = makeStrongGradeParams();
+    bakedGrade loose, tight;
+    REQUIRE(compileGradeLUT(p, loose, 1e-3f));
+    REQUIRE(compileGradeLUT(p, tight, 2e-5f));
+    CHECK(tight.bits > loose.bits);
+    CHECK(tight.maxError <= 2e-5f);
+    // The bound is measured at probes inside each cell, allow
+    // some slack for the sweep landing between them
+    requirePostWithin(tight, 3e-5f);
+}
+
+TEST_CASE("compileGradeLUT rejects a bound it cannot meet", "[gradeLUT]") {
+    bakedGrade bake;
+    CHECK_FALSE(compileGradeLUT(makeStrongGradeParams(), bake, 1e-9f));
+    CHECK_FALSE(bake.valid);
+}
+
+TEST_CASE("gradePixelsLUT matches the scalar reference", "[gradeLUT]") {
+    auto src = makeNoiseImage(1003);
+    renderParams graded = makeStrongGradeParams();
+    renderParams gradeBypass = graded;
+    gradeBypass.gradeBypass = 1;
+    renderParams bypass = graded;
+    bypass.bypass = 1;
+
+    for (const renderParams* p : {&graded, &gradeBypass, &bypass}) {
+        bakedGrade bake;
+        REQUIRE(compileGradeLUT(*p, bake));
+
+        size_t count = src.size() / 4;
+        std::vector<float> ref(src.size()), out(src.size(), -1.0f);
+        gradePixelsCPU(*p, src.data(), ref.data(), count);
+        gradePixelsLUT(bake, src.data(), out.data(), count);
+        for (size_t i = 0; i < ref.size(); ++i) {
+            INFO("value " << i << " pixel " << i / 4);
+            float tol = std::max(1e-5f, std::abs(ref[i]) * 2e-4f);
+            REQUIRE_THAT(out[i], WithinAbs(ref[i], tol));
+        }
+    }
+}
+
+TEST_CASE("cachedGradeLUT only re-bakes changed grades", "[gradeLUT]") {
+    renderParams graded = makeStrongGradeParams();
+    renderParams other = graded;
+    other.G_gamma[1] *= 1.1f;
+
+    auto first = cachedGradeLUT(graded);
+    REQUIRE(first);
+    CHECK(first->valid);
+    CHECK(cachedGradeLUT(graded) == first);
+
+    auto changed = cachedGradeLUT(other);
+    REQUIRE(changed);
+    CHECK(changed != first);
+    CHECK(changed->ch[1].gamma == other.G_gamma[1]);
+    // Earlier grades stay cached while there's room
+    CHECK(cachedGradeLUT(graded) == first);
+
+    // Settings the grade doesn't read share the bake
+    renderParams cropped = graded;
+    cropped.cropEnable = 1;
+    cropped.arbitraryRotation = 0.3f;
+    CHECK(cachedGradeLUT(cropped) == first);
+}
+
+// ---------------------------------------------------------------------------
+// Recursive Gaussian blur vs the direct kernel
+// ---------------------------------------------------------------------------
+
+// Gradient with grain and a hard-edged bright patch, like a scanned frame
+static std::vector<float> makeScanImage(int w, int h) {
+    auto img = makeGradientImage(w, h);
+    auto grain = makeNoiseImage((size_t)w * h);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float* px = &img[(y * w + x) * 4];
+            bool patch = x > w / 2 && x < w * 3 / 4 && y > h / 3 && y < h * 2 / 3;
+            for (int c = 0; c < 3; ++c)
+                px[c] += 0.05f * grain[(y * w + x) * 4 + c] + (patch ? 0.3f : 0.0f);
+        }
+    }
+    return img;
+}
+
+TEST_CASE("gaussianBlurIIR keeps a constant image constant", "[blur]") {
+    int w = 37, h = 23;
+    std::vector<float> src(w * h * 4, 0.42f), tmp(src.size()), dst(src.size(), -1.0f);
+    for (float sigma : {3.0f, 10.0f, 20.0f}) {
+        gaussianBlurIIR(src.data(), tmp.data(), dst.data(), w, h, sigma);
+        for (size_t i = 0; i < dst.size(); ++i) {
+            INFO("sigma " << sigma << " value " << i);
+            REQUIRE_THAT(dst[i], WithinAbs(0.42f, 1e-5f));
+        }
+    }
+}
+
+TEST_CASE("gaussianBlurIIR matches the direct kernel", "[blur]") {
+    int w = 160, h = 120;
+    auto src = makeScanImage(w, h);
+    std::vector<float> tmp(src.size()), ref(src.size()), out(src.size());
+
+    for (float sigma : {3.0f, 5.0f, 10.0f, 20.0f}) {
+        gaussianBlurDirect(src.data(), tmp.data(), ref.data(), w, h, sigma);
+        gaussianBlurIIR(src.data(), tmp.data(), out.data(), w, h, sigma);
+
+        // Compare what blurImage keeps, the inverted RGB
+        double sumError = 0.0;
+        float maxError = 0.0f;
+        size_t count = 0;
+        for (size_t i = 0; i < ref.size(); ++i) {
+            if (i % 4 == 3)
+                continue;
+            float a = 0.1f / ref[i];
+            float b = 0.1f / out[i];
+            float err = std::abs(a - b) / std::abs(a);
+            sumError += err;
+            maxError = std::max(maxError, err);
+            count++;
+        }
+        INFO("sigma " << sigma);
+        CHECK(sumError / count < 0.005);
+        CHECK(maxError < 0.05f);
+    }
+}
+
+TEST_CASE("gaussianBlur uses the direct kernel for small sigma", "[blur]") {
+    int w = 40, h = 30;
+    auto src = makeScanImage(w, h);
+    std::vector<float> tmp(src.size()), ref(src.size()), out(src.size());
+    float sigma = BLUR_IIR_MIN_SIGMA * 0.5f;
+    gaussianBlurDirect(src.data(), tmp.data(), ref.data(), w, h, sigma);
+    gaussianBlur(src.data(), tmp.data(), out.data(), w, h, sigma);
+    requireSameImage(ref, out);
+}
+
+TEST_CASE("gaussianBlurBlocks hands over the same pixels as gaussianBlur", "[blur]") {
+    int w = 150, h = 40;  // last block is partial
+    auto src = makeScanImage(w, h);
+    for (float sigma : {1.5f, 8.0f}) {
+        std::vector<float> tmp(src.size()), ref(src.size()), out(src.size(), -1.0f);
+        gaussianBlur(src.data(), tmp.data(), ref.data(), w, h, sigma);
+
+        std::mutex lock;
+        std::vector<int> seen((w + BLUR_BLOCK_COLUMNS - 1) / BLUR_BLOCK_COLUMNS, 0);
+        gaussianBlurBlocks(src.data(), tmp.data(), w, h, sigma,
+            [&](size_t block, const float* strip, size_t stride, size_t x0, size_t x1) {
+                std::lock_guard<std::mutex> guard(lock);
+                seen[block]++;
+                for (int y = 0; y < h; ++y)
+                    std::copy_n(strip + y * stride, (x1 - x0) * 4, &out[(y * w + x0) * 4]);
+            });
+        INFO("sigma " << sigma);
+        CHECK(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+        requireSameImage(ref, out);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Luma min/max analysis
+// ---------------------------------------------------------------------------
+
+TEST_CASE("lumaMinMax ties go to the first pixel in row-major order", "[minMax]") {
+    float pix[3] = {0.5f, 0.5f, 0.5f};
+    lumaMinMax a, b;
+    a.add(0.5f, 7, 2, pix);
+    b.add(0.5f, 3, 2, pix);
+    b.add(0.5f, 1, 5, pix);
+
+    lumaMinMax ab = a, ba = b;
+    ab.merge(b);
+    ba.merge(a);
+    for (const lumaMinMax* r : {&ab, &ba}) {
+        CHECK(r->minX == 3);
+        CHECK(r->minY == 2);
+        CHECK(r->maxX == 3);
+        CHECK(r->maxY == 2);
+    }
+}
+
+TEST_CASE("streamed blur analysis matches a scan of the stored blur", "[minMax]") {
+    int w = 150, h = 90;
+    auto src = makeScanImage(w, h);
+    float baseColor[3] = {0.8f, 0.6f, 0.4f};
+    // Skewed crop so some blocks are partly and some fully outside
+    unsigned int cropX[4] = {20, 110, 100, 12};
+    unsigned int cropY[4] = {10, 14, 80, 75};
+
+    for (float sigma : {1.5f, 6.0f}) {
+        // Stored path: blur, invert, scan the full buffer
+        std::vector<float> tmp(src.size()), blur(src.size());
+        gaussianBlur(src.data(), tmp.data(), blur.data(), w, h, sigma);
+        for (size_t i = 0; i < blur.size(); i += 4)
+            for (int ch = 0; ch < 3; ++ch)
+                blur[i + ch] = (baseColor[ch] / blur[i + ch]) * 0.1f;
+        std::vector<rowSpan> spans;
+        cropBoxSpans(cropX, cropY, w, h, spans);
+        lumaMinMax stored = findLumaMinMax(blur.data(), w, spans);
+
+        // Streamed path: per block results merged afterwards
+        std::vector<lumaMinMax> blocks((w + BLUR_BLOCK_COLUMNS - 1) / BLUR_BLOCK_COLUMNS);
+        gaussianBlurBlocks(src.data(), tmp.data(), w, h, sigma,
+            [&](size_t block, const float* strip, size_t stride, size_t x0, size_t x1) {
+                scanLumaMinMax(strip, stride, x0, x1, spans.data(), spans.size(), baseColor, blocks[block]);
+            });
+        lumaMinMax streamed;
+        for (const lumaMinMax& r : blocks)
+            streamed.merge(r);
+
+        INFO("sigma " << sigma);
+        REQUIRE(stored.found);
+        REQUIRE(streamed.found);
+        CHECK(streamed.minX == stored.minX);
+        CHECK(streamed.minY == stored.minY);
+        CHECK(streamed.maxX == stored.maxX);
+        CHECK(streamed.maxY == stored.maxY);
+        for (int ch = 0; ch < 3; ++ch) {
+            CHECK(streamed.minPix[ch] == stored.minPix[ch]);
+            CHECK(streamed.maxPix[ch] == stored.maxPix[ch]);
+        }
+    }
+}
+
+// Plain scan with isPointInBox, the behaviour findLumaMinMax replaces
+static lumaMinMax referenceMinMax(const std::vector<float>& img, int w, int h,
+                                  const unsigned int* cropX, const unsigned int* cropY) {
+    lumaMinMax r;
+    float minLuma = 100.0f, maxLuma = -100.0f;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (!isPointInBox(x, y, cropX, cropY))
+                continue;
+            const float* px = &img[(y * w + x) * 4];
+            float luma = Luma(px[0], px[1], px[2]);
+            if (luma < minLuma) {
+                minLuma = luma;
+                r.minX = x; r.minY = y;
+                std::copy_n(px, 3, r.minPix);
+                r.found = true;
+            }
+            if (luma > maxLuma) {
+                maxLuma = luma;
+                r.maxX = x; r.maxY = y;
+                std::copy_n(px, 3, r.maxPix);
+            }
+        }
+    }
+    return r;
+}
+
+TEST_CASE("findLumaMinMax matches a plain scan of the crop box", "[minMax]") {
+    int w = 203, h = 97;
+    auto img = makeScanImage(w, h);
+    // Quantize so many pixels tie on luma
+    for (float& v : img)
+        v = std::round(v * 16.0f) / 16.0f;
+
+    unsigned int cropX[4] = {20, 180, 170, 12};
+    unsigned int cropY[4] = {10, 4, 90, 80};
+    std::vector<rowSpan> spans;
+    cropBoxSpans(cropX, cropY, w, h, spans);
+
+    lumaMinMax ref = referenceMinMax(img, w, h, cropX, cropY);
+    lumaMinMax got = findLumaMinMax(img.data(), w, spans);
+    REQUIRE(got.found);
+    CHECK(got.minX == ref.minX);
+    CHECK(got.minY == ref.minY);
+    CHECK(got.maxX == ref.maxX);
+    CHECK(got.maxY == ref.maxY);
+    for (int ch = 0; ch < 3; ++ch) {
+        CHECK(got.minPix[ch] == ref.minPix[ch]);
+        CHECK(got.maxPix[ch] == ref.maxPix[ch]);
+    }
+}
+
+TEST_CASE("findLumaMinMax skips NaN and reports an empty crop", "[minMax]") {
+    int w = 20, h = 10;
+    std::vector<float> img(w * h * 4, 0.5f);
+    img[(3 * w + 4) * 4] = NAN;
+    img[(5 * w + 6) * 4 + 1] = 0.9f;
+
+    unsigned int fullX[4] = {0, (unsigned)w, (unsigned)w, 0};
+    unsigned int fullY[4] = {0, 0, (unsigned)h, (unsigned)h};
+    std::vector<rowSpan> spans;
+    cropBoxSpans(fullX, fullY, w, h, spans);
+    lumaMinMax r = findLumaMinMax(img.data(), w, spans);
+    REQUIRE(r.found);
+    CHECK(r.maxX == 6);
+    CHECK(r.maxY == 5);
+    CHECK(r.minX == 0);
+    CHECK(r.minY == 0);
+
+    CHECK_FALSE(findLumaMinMax(img.data(), w, {}).found);
+}
+
+// ---------------------------------------------------------------------------
+// Summed area table
+// ---------------------------------------------------------------------------
+
+static void bruteBoxMean(const std::vector<float>& img, int w,
+                         int x0, int y0, int x1, int y1, double* rgb) {
+    double sum[3] = {0.0, 0.0, 0.0};
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+            for (int ch = 0; ch < 3; ++ch)
+                sum[ch] += img[(y * w + x) * 4 + ch];
+    double count = (double)(x1 - x0 + 1) * (y1 - y0 + 1);
+    for (int ch = 0; ch < 3; ++ch)
+        rgb[ch] = sum[ch] / count;
+}
+
+TEST_CASE("summedAreaTable box means match a direct sum", "[sat]") {
+    int w = 301, h = 157;
+    std::vector<float> img(w * h * 4);
+    for (int i = 0; i < w * h * 4; ++i)
+        img[i] = 0.05f + 0.9f * std::fabs(std::sin(i * 0.37f));
+
+    summedAreaTable sat;
+    CHECK_FALSE(sat.valid());
+    float rgb[3];
+    CHECK_FALSE(sat.boxMean(0, 0, 0, 0, rgb));
+    REQUIRE(sat.update(img.data(), w, h));
+    CHECK_FALSE(sat.update(img.data(), w, h));
+    CHECK(sat.bytes() == (size_t)(w + 1) * (h + 1) * 3 * sizeof(double));
+
+    struct box { int x0, y0, x1, y1; };
+    for (box b : {box{0, 0, w - 1, h - 1}, box{17, 9, 17, 9}, box{0, 0, 0, 0},
+                  box{w - 1, h - 1, w - 1, h - 1}, box{40, 3, 250, 120}, box{5, 100, 6, 156}}) {
+        double ref[3];
+        bruteBoxMean(img, w, b.x0, b.y0, b.x1, b.y1, ref);
+        REQUIRE(sat.boxMean(b.x0, b.y0, b.x1, b.y1, rgb));
+        for (int ch = 0; ch < 3; ++ch)
+            CHECK_THAT(rgb[ch], WithinAbs(ref[ch], 1e-6));
+    }
+
+    // Inverted or out of range boxes are refused
+    CHECK_FALSE(sat.boxMean(10, 0, 9, 0, rgb));
+    CHECK_FALSE(sat.boxMean(0, 0, w, 0, rgb));
+    CHECK_FALSE(sat.boxMean(0, 0, 0, h, rgb));
+}
+
+TEST_CASE("summedAreaTable rebuilds for a new buffer and clears", "[sat]") {
+    std::vector<float> a(8 * 4 * 4, 0.25f);
+    std::vector<float> b(5 * 6 * 4, 0.75f);
+    summedAreaTable sat;
+    REQUIRE(sat.update(a.data(), 8, 4));
+
+    float rgb[3];
+    REQUIRE(sat.update(b.data(), 5, 6));
+    REQUIRE(sat.boxMean(0, 0, 4, 5, rgb));
+    CHECK_THAT(rgb[1], WithinAbs(0.75, 1e-7));
+    CHECK_FALSE(sat.boxMean(0, 0, 7, 3, rgb));
+
+    // Copies share the built table
+    summedAreaTable copy(sat);
+    CHECK(copy.valid());
+    sat.clear();
+    CHECK_FALSE(sat.valid());
+    CHECK(copy.boxMean(1, 1, 2, 2, rgb));
+    CHECK_FALSE(sat.update(nullptr, 5, 6));
+}
+
+TEST_CASE("processBaseColor gives the same result live and direct", "[sat]") {
+    int w = 64, h = 48;
+    std::vector<float> img(w * h * 4);
+    for (int i = 0; i < w * h * 4; ++i)
+        img[i] = 0.1f + 0.8f * std::fabs(std::cos(i * 0.11f));
+
+    image im;
+    im.width = w;
+    im.height = h;
+    im.rawImgData = img.data();
+    im.imgParam.sampleX[0] = 0.8f;
+    im.imgParam.sampleX[1] = 0.2f;
+    im.imgParam.sampleY[0] = 0.1f;
+    im.imgParam.sampleY[1] = 0.6f;
+
+    im.processBaseColor();
+    CHECK_FALSE(im.rawSAT.valid());
+    float direct[3] = {im.imgParam.baseColor[0], im.imgParam.baseColor[1], im.imgParam.baseColor[2]};
+
+    im.processBaseColor(true);
+    CHECK(im.rawSAT.valid());
+    for (int ch = 0; ch < 3; ++ch)
+        CHECK_THAT(im.imgParam.baseColor[ch], WithinAbs(direct[ch], 1e-6));
+
+    im.rawImgData = nullptr;
+}
@@ -0,0 +1,256 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ocioProcessor.h"
+#include "threadPool.h"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// Runs with the global pool swapped for the one given (or none)
+struct poolScope {
+    ThreadPool* prev;
+    explicit poolScope(ThreadPool* pool) : prev(tPool) { tPool = pool; }
+    ~poolScope() { tPool = prev; }
+};
+
+static std::vector<float> makeOcioImage(unsigned int w, unsigned int h) {
+    std::vector<float> img((size_t)w * h * 4);
+    for (size_t i = 0; i < img.size(); ++i)
+        img[i] = (i % 4 == 3) ? 1.0f : std::fabs(std::sin(i * 0.0071f));
+    return img;
+}
+
+// ACEScg to an sRGB texture space from the built-in CG config
+static bool loadBuiltinConfig(ocioProcessor& proc, ocioSetting& set) {
+    if (!proc.initExtConfig("ocio://cg-config-latest"))
+        return false;
+    proc.setActiveConfig(-1);
+    set.ocioConfig = proc.selectedConfig;
+    set.useDisplay = false;
+    set.inverse = false;
+    const auto& spaces = proc.activeConfig()->colorspaces;
+    auto it = std::find(spaces.begin(), spaces.end(), "sRGB - Texture");
+    set.colorspace = it == spaces.end() ? 0 : (int)(it - spaces.begin());
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Chunking
+// ---------------------------------------------------------------------------
+
+TEST_CASE("ocioChunkRows keeps a chunk inside the byte budget", "[ocio]") {
+    for (unsigned int w : {1u, 640u, 3000u, 8000u}) {
+        size_t rows = ocioChunkRows(w);
+        CHECK(rows >= 1);
+        CHECK(rows * w * 4 * sizeof(float) <= OCIO_CHUNK_BYTES);
+        // One more row would not have fit
+        CHECK((rows + 1) * w * 4 * sizeof(float) > OCIO_CHUNK_BYTES);
+    }
+    // Wider than the budget still gets a row
+    CHECK(ocioChunkRows(100000) == 1);
+}
+
+TEST_CASE("chunked OCIO apply matches a single apply", "[ocio]") {
+    ocioProcessor proc;
+    ocioSetting set;
+    if (!loadBuiltinConfig(proc, set)) {
+        WARN("Built-in OCIO config unavailable, skipping");
+        return;
+    }
+    auto cpu = proc.getCPUProcessor(set);
+    REQUIRE(cpu);
+
+    unsigned int w = 1500, h = 700;
+    std::vector<float> whole = makeOcioImage(w, h);
+    std::vector<float> chunked = whole;
+    proc.applyCPU(cpu, whole.data(), w, h);
+
+    ThreadPool pool(4);
+    poolScope scope(&pool);
+    proc.applyChunked(cpu, chunked.data(), w, h);
+    CHECK(whole == chunked);
+
+    // The second lookup is served from the cache
+    uint64_t hits = proc.processorHits();
+    CHECK(proc.getCPUProcessor(set) == cpu);
+    CHECK(proc.processorHits() == hits + 1);
+}
+
+// ---------------------------------------------------------------------------
+// Deferred loading
+// ---------------------------------------------------------------------------
+
+TEST_CASE("deferred OCIO configs parse on first use", "[ocio]") {
+    ocioProcessor proc;
+    std::string bad = "not an ocio config";
+    REQUIRE(proc.addConfig(bad, "Broken", true));
+    REQUIRE(proc.initExtConfig("ocio://cg-config-latest", true));
+    CHECK(proc.configCount() == 2);
+    CHECK(proc.getConfigList()[1] == "cg-config-latest");
+
+    // The broken one only fails once something needs it
+    CHECK_FALSE(proc.setActiveConfig(0));
+    if (!proc.setActiveConfig(1)) {
+        WARN("Built-in OCIO config unavailable, skipping");
+        return;
+    }
+    CHECK(proc.selectedConfig == 1);
+    CHECK_FALSE(proc.activeConfig()->colorspaces.empty());
+
+    ocioSetting set;
+    set.ocioConfig = 0;
+    CHECK_FALSE(proc.getCPUProcessor(set));
+}
+
+// CIE76 between two sRGB encoded colors, D65
+static float deltaE(const float* a, const float* b) {
+    auto lab = [](const float* c, float* out) {
+        float lin[3];
+        for (int i = 0; i < 3; ++i) {
+            float v = std::clamp(c[i], 0.0f, 1.0f);
+            lin[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+        float xyz[3] = {
+            (0.4124f * lin[0] + 0.3576f * lin[1] + 0.1805f * lin[2]) / 0.95047f,
+            (0.2126f * lin[0] + 0.7152f * lin[1] + 0.0722f * lin[2]),
+            (0.0193f * lin[0] + 0.1192f * lin[1] + 0.9505f * lin[2]) / 1.08883f,
+        };
+        for (float& t : xyz)
+            t = t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+        out[0] = 116.0f * xyz[1] - 16.0f;
+        out[1] = 500.0f * (xyz[0] - xyz[1]);
+        out[2] = 200.0f * (xyz[1] - xyz[2]);
+    };
+    float la[3], lb[3];
+    lab(a, la);
+    lab(b, lb);
+    return std::sqrt((la[0] - lb[0]) * (la[0] - lb[0]) + (la[1] - lb[1]) * (la[1] - lb[1]) +
+                     (la[2] - lb[2]) * (la[2] - lb[2]));
+}
+
+// ---------------------------------------------------------------------------
+// Baked display LUT
+// ---------------------------------------------------------------------------
+
+TEST_CASE("baked display LUT accuracy against the exact processor", "[ocio]") {
+    ocioProcessor proc;
+    ocioSetting set;
+    if (!loadBuiltinConfig(proc, set)) {
+        WARN("Built-in OCIO config unavailable, skipping");
+        return;
+    }
+    // ACEScg through the config's default display and view
+    const auto& spaces = proc.activeConfig()->colorspaces;
+    auto it = std::find(spaces.begin(), spaces.end(), "ACEScg");
+    set.colorspace = it == spaces.end() ? 0 : (int)(it - spaces.begin());
+    set.useDisplay = true;
+    set.display = 0;
+    set.view = 0;
+
+    auto lut = proc.getDisplayLUT(set);
+    REQUIRE(lut);
+    CHECK(proc.getDisplayLUT(set) == lut);     // baked once
+    ocioSetting inverse = set;
+    inverse.inverse = true;
+    CHECK_FALSE(proc.getDisplayLUT(inverse));
+
+    // Scene-linear samples over the shaper range. Near-neutral ones
+    // (channels within 3 stops) are reported on their own, the rest
+    // are the saturated extremes the gamut mapping bends hardest.
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> stops(DISPLAY_LUT_LOG2_MIN, DISPLAY_LUT_LOG2_MAX);
+    std::uniform_real_distribution<float> spread(-1.5f, 1.5f);
+    size_t count = 200000;
+    std::vector<float> exact(count * 4);
+    for (size_t i = 0; i < count; ++i) {
+        float base = stops(rng);
+        bool neutral = i % 2 == 0;
+        for (int ch = 0; ch < 3; ++ch)
+            exact[i * 4 + ch] = std::exp2(neutral ? base + spread(rng) : stops(rng));
+        exact[i * 4 + 3] = 1.0f;
+    }
+    std::vector<float> fast = exact;
+    proc.processImage(exact.data(), count, 1, set);
+    applyDisplayLUT(*lut, fast.data(), count);
+
+    double sum[2] = {0.0, 0.0};
+    float worst[2] = {0.0f, 0.0f};
+    for (size_t i = 0; i < count; ++i) {
+        float e = deltaE(&fast[i * 4], &exact[i * 4]);
+        sum[i % 2] += e;
+        worst[i % 2] = std::max(worst[i % 2], e);
+    }
+    float meanNeutral = (float)(sum[0] / (count / 2));
+    float meanSaturated = (float)(sum[1] / (count / 2));
+    WARN("Baked " << lut->size << "^3 display LUT vs OCIO, dE76" <<
+         "\n  near-neutral: mean " << meanNeutral << ", max " << worst[0] <<
+         "\n  saturated:    mean " << meanSaturated << ", max " << worst[1]);
+    CHECK(meanNeutral < 1.0f);
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent export throughput
+// ---------------------------------------------------------------------------
+
+// Not run by default: filmvert_tests "[.ocioBench]"
+TEST_CASE("OCIO throughput with concurrent exports", "[.ocioBench]") {
+    ocioProcessor proc;
+    ocioSetting set;
+    if (!loadBuiltinConfig(proc, set)) {
+        WARN("Built-in OCIO config unavailable, skipping");
+        return;
+    }
+    auto cpu = proc.getCPUProcessor(set);
+    REQUIRE(cpu);
+
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    poolScope scope(&pool);
+
+    unsigned int w = 3000, h = 2000;
+    std::vector<std::vector<float>> images(8, makeOcioImage(w, h));
+
+    // Each export thread runs its whole image, as exportImages does
+    auto runExports = [&](size_t exports, bool oneBandPerCore) {
+        std::vector<std::thread> threads;
+        for (size_t e = 0; e < exports; ++e) {
+            threads.emplace_back([&, e] {
+                float* img = images[e].data();
+                if (!oneBandPerCore) {
+                    proc.applyChunked(cpu, img, w, h);
+                    return;
+                }
+                // What processImage used to do: a thread per core per call
+                unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+                unsigned int band = (h + cores - 1) / cores;
+                std::vector<std::thread> bands;
+                for (unsigned int y = 0; y < h; y += band) {
+                    unsigned int rows = std::min(band, h - y);
+                    bands.emplace_back([&, y, rows] {
+                        proc.applyCPU(cpu, img + (size_t)y * w * 4, w, rows);
+                    });
+                }
+                for (auto& t : bands)
+                    t.join();
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        return exports;
+    };
+
+    for (size_t exports : {1, 4, 8}) {
+        BENCHMARK("pool chunks, " + std::to_string(exports) + " exports") {
+            return runExports(exports, false);
+        };
+        BENCHMARK("band per core, " + std::to_string(exports) + " exports") {
+            return runExports(exports, true);
+        };
+    }
+}
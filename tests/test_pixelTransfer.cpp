@@ -0,0 +1,309 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include "pixelTransfer.h"
+#include "tilePlan.h"
+#include "glslKernels.h"
+#include "threadPool.h"
+#include <GLFW/glfw3.h>
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// A hidden window for its context. Headless CI gets one from
+// Mesa's llvmpipe under a virtual display:
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run filmvert_tests "[gpu]"
+struct glScope {
+    GLFWwindow* window = nullptr;
+
+    glScope() {
+        if (!glfwInit())
+            return;
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(64, 64, "filmvert_tests", nullptr, nullptr);
+        if (!window)
+            return;
+        glfwMakeContextCurrent(window);
+        glewExperimental = GL_TRUE;
+        if (glewInit() != GLEW_OK || !glFenceSync) {
+            glfwDestroyWindow(window);
+            window = nullptr;
+        }
+    }
+    ~glScope() {
+        if (window)
+            glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+};
+
+static GLuint makeTexture(int w, int h) {
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, w, h, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return tex;
+}
+
+static std::vector<float> makePixels(int w, int h) {
+    std::vector<float> px((size_t)w * h * 4);
+    for (size_t i = 0; i < px.size(); ++i)
+        px[i] = std::sin(i * 0.013f) * 4.0f;
+    return px;
+}
+
+static GLuint compileProgram(const std::string& vert, const std::string& frag) {
+    GLuint program = glCreateProgram();
+    for (auto [type, text] : {std::pair{GL_VERTEX_SHADER, &vert}, std::pair{GL_FRAGMENT_SHADER, &frag}}) {
+        GLuint shader = glCreateShader(type);
+        const char* src = text->c_str();
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        GLint ok = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            UNSCOPED_INFO(log);
+        }
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// The kernel's sampling alone, what tiling changes
+static const std::string samplingKernel = "#version 330 core\n" + glsl_sampling + R"(
+    in vec2 texCoord;
+    out vec4 fragColor;
+    void main() {
+        vec4 pixel;
+        fragColor = sampleInput(texCoord, pixel) ? pixel : vec4(0.0, 0.0, 0.0, 1.0);
+    }
+)";
+
+// Draw the sampling kernel into an outW x outH target, reading it back
+// at dst with the given row length
+static void drawSampled(GLuint program, GLuint vao, GLuint input, int outW, int outH,
+                        pixelTransfer& transfer, float* dst, int rowLength) {
+    GLuint target = 0, fbo = 0;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, outW, outH, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, outW, outH);
+    glUseProgram(program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    transfer.readback(target, outW, outH, dst, nullptr, rowLength);
+    transfer.finish();
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &target);
+}
+
+// ---------------------------------------------------------------------------
+// pixelTransfer
+// ---------------------------------------------------------------------------
+
+TEST_CASE("pixel buffer upload and readback round-trip", "[gpu]") {
+    glScope gl;
+    if (!gl.window) {
+        WARN("No OpenGL context available, skipping");
+        return;
+    }
+    ThreadPool pool(4);
+    ThreadPool* prev = tPool;
+    tPool = &pool;
+
+    int w = 301, h = 217;
+    std::vector<float> src = makePixels(w, h);
+    GLuint tex = makeTexture(w, h);
+    {
+        // Small slots so the upload wraps the ring a few times
+        pixelTransfer transfer(3, 64 << 10);
+        REQUIRE(transfer.upload(tex, w, h, src.data()));
+
+        std::vector<float> out(src.size(), -1.0f);
+        bool done = false;
+        REQUIRE(transfer.readback(tex, w, h, out.data(), [&done](bool ok) { done = ok; }));
+        CHECK(transfer.pending() == 1);
+        CHECK(transfer.pendingBytes() == (uint64_t)w * h * 4 * sizeof(float));
+        CHECK_FALSE(done);     // only ever signalled from poll
+
+        auto start = std::chrono::steady_clock::now();
+        while (!done && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+            transfer.poll();
+        REQUIRE(done);
+        CHECK(transfer.pending() == 0);
+        CHECK(out == src);
+        CHECK(glGetError() == GL_NO_ERROR);
+    }
+    glDeleteTextures(1, &tex);
+    tPool = prev;
+}
+
+TEST_CASE("pixel buffer readbacks can be replaced, cancelled and flushed", "[gpu]") {
+    glScope gl;
+    if (!gl.window) {
+        WARN("No OpenGL context available, skipping");
+        return;
+    }
+    int w = 64, h = 48;
+    std::vector<float> src = makePixels(w, h);
+    GLuint tex = makeTexture(w, h);
+    pixelTransfer transfer;
+    REQUIRE(transfer.upload(tex, w, h, src.data()));
+
+    std::vector<float> a(src.size()), b(src.size());
+    int doneA = 0, doneB = 0, failedB = 0;
+    transfer.readback(tex, w, h, a.data(), [&doneA](bool ok) { doneA += ok ? 1 : 100; });
+    transfer.readback(tex, w, h, a.data(), [&doneA](bool ok) { doneA += ok ? 10 : 100; });
+    transfer.readback(tex, w, h, b.data(), [&](bool ok) { (ok ? doneB : failedB)++; });
+    CHECK(transfer.pending() == 2);
+
+    transfer.cancel(b.data());
+    CHECK(transfer.pending() == 1);
+    CHECK(failedB == 1);
+
+    // Tiles land part way into a buffer, cancelling the buffer gets them all
+    std::vector<float> c(src.size() * 2);
+    int failedC = 0;
+    transfer.readback(tex, w, h, c.data() + 4, [&failedC](bool ok) { failedC += !ok; });
+    transfer.readback(tex, w, h, c.data() + src.size(), [&failedC](bool ok) { failedC += !ok; });
+    transfer.cancel(c.data(), c.size() * sizeof(float));
+    CHECK(transfer.pending() == 1);
+    CHECK(failedC == 2);
+
+    transfer.finish();
+    CHECK(transfer.pending() == 0);
+    CHECK(doneA == 11);     // one copy, both waiters told
+    CHECK(doneB == 0);
+    CHECK(a == src);
+
+    transfer.release();
+    glDeleteTextures(1, &tex);
+}
+
+TEST_CASE("tiled renders match a single pass", "[gpu]") {
+    glScope gl;
+    if (!gl.window) {
+        WARN("No OpenGL context available, skipping");
+        return;
+    }
+    GLuint program = compileProgram(glsl_vertex, samplingKernel);
+    REQUIRE(program != 0);
+
+    float quad[] = {-1, -1, 0, 0, 0,   1, -1, 0, 1, 0,   1, 1, 0, 1, 1,   -1, 1, 0, 0, 1};
+    unsigned int indices[] = {0, 1, 2, 2, 3, 0};
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+
+    // Smooth, so bilinear weights at the seams would show any offset
+    int w = 173, h = 131;
+    std::vector<float> src((size_t)w * h * 4);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            for (int c = 0; c < 4; c++)
+                src[((size_t)y * w + x) * 4 + c] = std::sin(x * 0.07f + c) + std::cos(y * 0.05f - c);
+
+    tileMapping map;
+    map.width = w;
+    map.height = h;
+    map.cropEnabled = true;
+    map.cropMin[0] = 0.08f;
+    map.cropMin[1] = 0.12f;
+    map.cropMax[0] = 0.93f;
+    map.cropMax[1] = 0.9f;
+    map.rotation = 7.5f * M_PI / 180.0f;
+    map.outWidth = (unsigned int)((map.cropMax[0] - map.cropMin[0]) * w);
+    map.outHeight = (unsigned int)((map.cropMax[1] - map.cropMin[1]) * h);
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "inputTexture"), 0);
+    glUniform2f(glGetUniformLocation(program, "imageCropMin"), map.cropMin[0], map.cropMin[1]);
+    glUniform2f(glGetUniformLocation(program, "imageCropMax"), map.cropMax[0], map.cropMax[1]);
+    glUniform1f(glGetUniformLocation(program, "arbitraryRotation"), map.rotation);
+    glUniform1i(glGetUniformLocation(program, "cropEnabled"), 1);
+    glUniform1i(glGetUniformLocation(program, "cropVisible"), 0);
+    glUniform2f(glGetUniformLocation(program, "imageSize"), w, h);
+    GLint outputTileLoc = glGetUniformLocation(program, "outputTile");
+    GLint inputTileLoc = glGetUniformLocation(program, "inputTile");
+
+    pixelTransfer transfer;
+    size_t outPixels = (size_t)map.outWidth * map.outHeight * 4;
+
+    // One pass over the whole image
+    std::vector<float> whole(outPixels, -1.0f);
+    GLuint input = makeTexture(w, h);
+    glBindTexture(GL_TEXTURE_2D, input);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    REQUIRE(transfer.upload(input, w, h, src.data()));
+    glUniform4f(outputTileLoc, 0.0f, 0.0f, 1.0f, 1.0f);
+    glUniform4f(inputTileLoc, 0.0f, 0.0f, 1.0f, 1.0f);
+    drawSampled(program, vao, input, map.outWidth, map.outHeight, transfer, whole.data(), 0);
+    glDeleteTextures(1, &input);
+
+    // And in tiles, as if the texture limit were 64
+    auto tiles = planRenderTiles(map, 64, 48);
+    REQUIRE(tiles.size() > 4);
+    std::vector<float> tiled(outPixels, -1.0f);
+    for (const auto& t : tiles) {
+        GLuint tileIn = makeTexture(t.inW, t.inH);
+        glBindTexture(GL_TEXTURE_2D, tileIn);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        REQUIRE(transfer.upload(tileIn, t.inW, t.inH, src.data() + ((size_t)t.inY * w + t.inX) * 4, w));
+
+        float outputTile[4], inputTile[4];
+        renderTileUniforms(map, t, outputTile, inputTile);
+        glUseProgram(program);
+        glUniform4fv(outputTileLoc, 1, outputTile);
+        glUniform4fv(inputTileLoc, 1, inputTile);
+        float* dst = tiled.data() + ((size_t)t.outY * map.outWidth + t.outX) * 4;
+        drawSampled(program, vao, tileIn, t.outW, t.outH, transfer, dst, map.outWidth);
+        glDeleteTextures(1, &tileIn);
+    }
+
+    float maxDiff = 0.0f;
+    for (size_t i = 0; i < outPixels; i++)
+        maxDiff = std::max(maxDiff, std::abs(whole[i] - tiled[i]));
+    CHECK(maxDiff < 2e-3f);
+    CHECK(glGetError() == GL_NO_ERROR);
+
+    transfer.release();
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+}
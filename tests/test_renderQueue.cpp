@@ -0,0 +1,140 @@
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+#include "renderQueue.h"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static gpuQueue job(image* img, renderType type, int colorspace = 0,
+                    renderTicketPtr ticket = nullptr) {
+    ocioSetting set;
+    set.colorspace = colorspace;
+    return gpuQueue(img, type, set, ticket);
+}
+
+static std::vector<image*> drain(renderQueue& queue) {
+    std::vector<image*> order;
+    gpuQueue next = job(nullptr, r_sdt);
+    while (queue.pop(next))
+        order.push_back(next._img);
+    return order;
+}
+
+// ---------------------------------------------------------------------------
+// renderQueue
+// ---------------------------------------------------------------------------
+
+TEST_CASE("render queue serves priority classes in order", "[renderQueue]") {
+    image thumbs[3], exported, viewed;
+    renderQueue queue;
+    for (auto& t : thumbs)
+        queue.push(job(&t, r_bg));
+    queue.push(job(&exported, r_full));
+    queue.push(job(&viewed, r_sdt));
+    CHECK(queue.size() == 5);
+    CHECK(queue.size(p_background) == 3);
+
+    std::vector<image*> expect = {&viewed, &exported, &thumbs[0], &thumbs[1], &thumbs[2]};
+    CHECK(drain(queue) == expect);
+    CHECK(queue.empty());
+}
+
+TEST_CASE("render queue keeps only the newest request per image", "[renderQueue]") {
+    image a, b;
+    renderQueue queue;
+    queue.push(job(&a, r_sdt, 1));
+    queue.push(job(&b, r_sdt, 1));
+    queue.push(job(&a, r_sdt, 2));
+    queue.push(job(&a, r_sdt, 3));
+    REQUIRE(queue.size() == 2);
+
+    gpuQueue next = job(nullptr, r_sdt);
+    REQUIRE(queue.pop(next));
+    CHECK(next._img == &a);                 // kept its place in line
+    CHECK(next._ocioSet.colorspace == 3);   // with the latest settings
+    REQUIRE(queue.pop(next));
+    CHECK(next._img == &b);
+    CHECK_FALSE(queue.pop(next));
+}
+
+TEST_CASE("render queue lets interactive requests cover background ones", "[renderQueue]") {
+    image a, b;
+    renderQueue queue;
+    queue.push(job(&a, r_bg));
+    queue.push(job(&a, r_sdt));
+    CHECK(queue.size() == 1);
+    CHECK(queue.size(p_background) == 0);
+
+    queue.push(job(&a, r_bg));              // already covered
+    CHECK(queue.size() == 1);
+
+    // An export is a different render, both stay
+    queue.push(job(&b, r_full));
+    queue.push(job(&b, r_sdt));
+    CHECK(queue.size() == 3);
+}
+
+TEST_CASE("render queue lookup and removal by image", "[renderQueue]") {
+    image a, b, c;
+    renderQueue queue;
+    queue.push(job(&a, r_bg));
+    queue.push(job(&a, r_full));
+    queue.push(job(&b, r_bg));
+    CHECK(queue.contains(&a));
+    CHECK(queue.contains(&b));
+    CHECK_FALSE(queue.contains(&c));
+
+    queue.remove(&a);
+    CHECK_FALSE(queue.contains(&a));
+    CHECK(queue.size() == 1);
+    queue.remove(&c);                       // nothing queued, no-op
+    CHECK(drain(queue) == std::vector<image*>{&b});
+}
+
+TEST_CASE("render queue chains folded tickets and cancels removed ones", "[renderQueue]") {
+    image a, b;
+    renderQueue queue;
+    auto first = std::make_shared<renderTicket>();
+    auto second = std::make_shared<renderTicket>();
+    auto thumb = std::make_shared<renderTicket>();
+    queue.push(job(&a, r_bg, 0, thumb));
+    queue.push(job(&a, r_sdt, 1, first));
+    queue.push(job(&a, r_sdt, 2, second));
+
+    gpuQueue next = job(nullptr, r_sdt);
+    REQUIRE(queue.pop(next));
+    CHECK(next._ticket == second);
+    next._ticket->complete();
+    CHECK(first->status() == rs_done);
+    CHECK(thumb->status() == rs_done);
+
+    auto exported = std::make_shared<renderTicket>();
+    queue.push(job(&b, r_full, 0, exported));
+    queue.remove(&b);
+    CHECK(exported->status() == rs_cancelled);
+    CHECK(queue.empty());
+}
+
+TEST_CASE("render queue batches a class only while nothing outranks it", "[renderQueue]") {
+    image thumbs[3], viewed;
+    renderQueue queue;
+    for (auto& t : thumbs)
+        queue.push(job(&t, r_bg));
+
+    gpuQueue next = job(nullptr, r_sdt);
+    REQUIRE(queue.pop(p_background, next));
+    CHECK(next._img == &thumbs[0]);
+
+    // An edit comes in mid-batch, the batch yields to it
+    queue.push(job(&viewed, r_sdt));
+    CHECK_FALSE(queue.pop(p_background, next));
+    CHECK_FALSE(queue.pop(p_export, next));
+    REQUIRE(queue.pop(next));
+    CHECK(next._img == &viewed);
+
+    REQUIRE(queue.pop(p_background, next));
+    CHECK(next._img == &thumbs[1]);
+    CHECK_FALSE(queue.contains(&thumbs[1]));
+    CHECK(queue.size() == 1);
+}
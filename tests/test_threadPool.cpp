@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "threadPool.h"
+
+// ---------------------------------------------------------------------------
+// ThreadPool::parallelFor
+// ---------------------------------------------------------------------------
+TEST_CASE("parallelFor visits every index exactly once", "[threadPool]") {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(10007);
+    pool.parallelFor(0, hits.size(), 64, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++)
+            hits[i]++;
+    });
+    for (auto& h : hits)
+        REQUIRE(h == 1);
+}
+
+TEST_CASE("parallelFor respects a non-zero range start", "[threadPool]") {
+    ThreadPool pool(3);
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(100, 200, 7, [&](size_t b, size_t e) {
+        CHECK(b >= 100);
+        CHECK(e <= 200);
+        for (size_t i = b; i < e; i++)
+            sum += i;
+    });
+    CHECK(sum == 14950);
+}
+
+TEST_CASE("parallelFor with an empty range never calls the body", "[threadPool]") {
+    ThreadPool pool(2);
+    bool called = false;
+    pool.parallelFor(5, 5, 1, [&](size_t, size_t) { called = true; });
+    CHECK_FALSE(called);
+}
+
+TEST_CASE("parallelFor rethrows an exception from a chunk", "[threadPool]") {
+    ThreadPool pool(4);
+    REQUIRE_THROWS_AS(pool.parallelFor(0, 100, 1, [](size_t b, size_t) {
+        if (b == 42)
+            throw std::runtime_error("chunk failed");
+    }), std::runtime_error);
+}
+
+TEST_CASE("nested parallelFor inside pool tasks does not deadlock", "[threadPool]") {
+    // More tasks than workers, each running its own parallel loop
+    ThreadPool pool(2);
+    std::vector<std::future<size_t>> futures;
+    for (int t = 0; t < 8; t++) {
+        futures.push_back(pool.submit([&pool]() {
+            std::atomic<size_t> count{0};
+            pool.parallelFor(0, 1000, 10, [&](size_t b, size_t e) { count += e - b; });
+            return count.load();
+        }));
+    }
+    for (auto& f : futures)
+        CHECK(f.get() == 1000);
+}
+
+// ---------------------------------------------------------------------------
+// ThreadPool::parallelForTiles
+// ---------------------------------------------------------------------------
+TEST_CASE("parallelForTiles covers the region with clipped edge tiles", "[threadPool]") {
+    ThreadPool pool(4);
+    const unsigned int w = 130, h = 70;
+    std::vector<std::atomic<int>> hits(w * h);
+    pool.parallelForTiles(w, h, 32, 16, [&](const tileRange& t) {
+        CHECK(t.x1 <= w);
+        CHECK(t.y1 <= h);
+        for (unsigned int y = t.y0; y < t.y1; y++)
+            for (unsigned int x = t.x0; x < t.x1; x++)
+                hits[y * w + x]++;
+    });
+    for (auto& hit : hits)
+        REQUIRE(hit == 1);
+}
+
+// ---------------------------------------------------------------------------
+// Global helpers without a running pool
+// ---------------------------------------------------------------------------
+TEST_CASE("global parallelFor runs inline when no pool is started", "[threadPool]") {
+    ThreadPool* prev = tPool;
+    tPool = nullptr;
+    std::vector<int> v(500, 0);
+    parallelFor(0, v.size(), parallelGrain(v.size()), [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++)
+            v[i] = 1;
+    });
+    CHECK(std::accumulate(v.begin(), v.end(), 0) == 500);
+    tPool = prev;
+}
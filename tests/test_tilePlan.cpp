@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "tilePlan.h"
+
+using Catch::Matchers::WithinAbs;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static tileMapping mapping(unsigned int w, unsigned int h, float degrees = 0.0f,
+                           bool crop = false) {
+    tileMapping map;
+    map.width = w;
+    map.height = h;
+    map.outWidth = w;
+    map.outHeight = h;
+    map.rotation = degrees * M_PI / 180.0f;
+    map.cropVisible = degrees != 0.0f;
+    if (crop) {
+        map.cropEnabled = true;
+        map.cropMin[0] = 0.1f;
+        map.cropMin[1] = 0.15f;
+        map.cropMax[0] = 0.85f;
+        map.cropMax[1] = 0.9f;
+        map.outWidth = (unsigned int)((map.cropMax[0] - map.cropMin[0]) * w);
+        map.outHeight = (unsigned int)((map.cropMax[1] - map.cropMin[1]) * h);
+    }
+    return map;
+}
+
+// Every output pixel covered exactly once
+static bool partitions(const tileMapping& map, const std::vector<renderTile>& tiles) {
+    std::vector<int> hits((size_t)map.outWidth * map.outHeight, 0);
+    for (const auto& t : tiles)
+        for (unsigned int y = t.outY; y < t.outY + t.outH; y++)
+            for (unsigned int x = t.outX; x < t.outX + t.outW; x++)
+                hits[(size_t)y * map.outWidth + x]++;
+    for (int h : hits)
+        if (h != 1)
+            return false;
+    return true;
+}
+
+// Every bilinear tap of every pixel centre the tile samples lies inside
+// its input rectangle, or the pixel falls outside the image entirely
+static bool footprintsContained(const tileMapping& map, const std::vector<renderTile>& tiles) {
+    for (const auto& t : tiles) {
+        for (unsigned int y = t.outY; y < t.outY + t.outH; y++) {
+            for (unsigned int x = t.outX; x < t.outX + t.outW; x++) {
+                float su, sv;
+                mapOutputUV(map, (x + 0.5f) / map.outWidth, (y + 0.5f) / map.outHeight, su, sv);
+                if (su < 0.0f || su > 1.0f || sv < 0.0f || sv > 1.0f)
+                    continue;
+                // Clamped to the image like CLAMP_TO_EDGE would
+                float px = std::clamp(su * map.width - 0.5f, 0.0f, map.width - 1.0f);
+                float py = std::clamp(sv * map.height - 0.5f, 0.0f, map.height - 1.0f);
+                unsigned int x0 = (unsigned int)std::floor(px);
+                unsigned int y0 = (unsigned int)std::floor(py);
+                unsigned int x1 = std::min(x0 + 1, map.width - 1);
+                unsigned int y1 = std::min(y0 + 1, map.height - 1);
+                if (x0 < t.inX || x1 >= t.inX + t.inW || y0 < t.inY || y1 >= t.inY + t.inH)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// planRenderTiles
+// ---------------------------------------------------------------------------
+
+TEST_CASE("tile plan partitions the output", "[tilePlan]") {
+    tileMapping map = mapping(1000, 700);
+    auto tiles = planRenderTiles(map, 512, 256);
+    REQUIRE(tiles.size() == 4 * 3);
+    CHECK(partitions(map, tiles));
+    for (const auto& t : tiles) {
+        CHECK(t.outW <= 256);
+        CHECK(t.outH <= 256);
+        CHECK(t.inW <= 512);
+        CHECK(t.inH <= 512);
+    }
+    // Straight through, the input is the tile plus its apron
+    CHECK(tiles[0].inX == 0);
+    CHECK(tiles[0].inW == 256 + GPU_TILE_APRON);
+    CHECK(tiles[5].inX == 256 - GPU_TILE_APRON);
+    CHECK(tiles[5].inW == 256 + 2 * GPU_TILE_APRON);
+}
+
+TEST_CASE("tile inputs cover every sample with rotation and crop", "[tilePlan]") {
+    for (float degrees : {0.0f, 3.5f, -12.0f, 45.0f, 90.0f}) {
+        for (bool crop : {false, true}) {
+            tileMapping map = mapping(517, 389, degrees, crop);
+            auto tiles = planRenderTiles(map, 200, 128);
+            INFO("rotation " << degrees << " crop " << crop);
+            REQUIRE_FALSE(tiles.empty());
+            CHECK(partitions(map, tiles));
+            CHECK(footprintsContained(map, tiles));
+            for (const auto& t : tiles) {
+                CHECK(t.inX + t.inW <= map.width);
+                CHECK(t.inY + t.inH <= map.height);
+                CHECK(t.inW <= 200);
+                CHECK(t.inH <= 200);
+            }
+        }
+    }
+}
+
+TEST_CASE("tile plan shrinks tiles whose footprint won't fit", "[tilePlan]") {
+    // At 45 degrees a 128 tile reads a ~181 texel diagonal
+    tileMapping map = mapping(600, 600, 45.0f);
+    auto tiles = planRenderTiles(map, 150, 128);
+    REQUIRE_FALSE(tiles.empty());
+    CHECK(tiles[0].outW == 64);
+    for (const auto& t : tiles) {
+        CHECK(t.inW <= 150);
+        CHECK(t.inH <= 150);
+    }
+    CHECK(planRenderTiles(tileMapping(), 150).empty());
+}
+
+TEST_CASE("tile uniforms map tile UVs back to image UVs", "[tilePlan]") {
+    tileMapping map = mapping(1000, 700);
+    auto tiles = planRenderTiles(map, 512, 256);
+    const renderTile& t = tiles[5];
+    float outputTile[4], inputTile[4];
+    renderTileUniforms(map, t, outputTile, inputTile);
+
+    // The tile's far corner in its own viewport is its far corner in the output
+    CHECK_THAT(outputTile[0] + outputTile[2], WithinAbs((t.outX + t.outW) / 1000.0, 1e-6));
+    CHECK_THAT(outputTile[1] + outputTile[3], WithinAbs((t.outY + t.outH) / 700.0, 1e-6));
+    // And the input rectangle's corners are 0 and 1 in the tile's texture
+    float u = (float)t.inX / map.width;
+    CHECK_THAT((u - inputTile[0]) * inputTile[2], WithinAbs(0.0, 1e-6));
+    u = (float)(t.inX + t.inW) / map.width;
+    CHECK_THAT((u - inputTile[0]) * inputTile[2], WithinAbs(1.0, 1e-5));
+}
@@ -2,6 +2,13 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <vector>
 #include <cmath>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "lruCache.h"
+#include "renderTicket.h"
+#include "residencyCache.h"
 #include "utils.h"
 
 using Catch::Matchers::WithinAbs;
@@ -158,3 +165,210 @@ TEST_CASE("computeKernels weights are non-negative", "[utils]") {
     for (int i = 0; i < ks; ++i)
         CHECK(kernels[i] >= 0.0f);
 }
+
+// ---------------------------------------------------------------------------
+// cropBoxSpans — scanline form of isPointInBox
+// ---------------------------------------------------------------------------
+static void requireSpansMatchBox(const unsigned int* xs, const unsigned int* ys,
+                                 unsigned int w, unsigned int h) {
+    std::vector<rowSpan> spans;
+    cropBoxSpans(xs, ys, w, h, spans);
+
+    std::vector<uint8_t> covered(w * h, 0);
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const rowSpan& s = spans[i];
+        REQUIRE(s.y < h);
+        REQUIRE(s.x0 < s.x1);
+        REQUIRE(s.x1 <= w);
+        if (i > 0)
+            REQUIRE((spans[i - 1].y < s.y || spans[i - 1].x1 < s.x0));
+        for (unsigned int x = s.x0; x < s.x1; ++x)
+            covered[s.y * w + x] = 1;
+    }
+    for (unsigned int y = 0; y < h; ++y) {
+        for (unsigned int x = 0; x < w; ++x) {
+            INFO("pixel " << x << "," << y);
+            REQUIRE((covered[y * w + x] != 0) == isPointInBox(x, y, xs, ys));
+        }
+    }
+}
+
+TEST_CASE("cropBoxSpans covers exactly the pixels isPointInBox accepts", "[utils]") {
+    SECTION("axis aligned") {
+        unsigned int xs[4] = {10, 90, 90, 10};
+        unsigned int ys[4] = {5, 5, 60, 60};
+        requireSpansMatchBox(xs, ys, 100, 70);
+    }
+    SECTION("rotated, counter-clockwise") {
+        unsigned int xs[4] = {50, 95, 45, 3};
+        unsigned int ys[4] = {2, 40, 69, 30};
+        requireSpansMatchBox(xs, ys, 100, 70);
+    }
+    SECTION("rotated, clockwise") {
+        unsigned int xs[4] = {3, 45, 95, 50};
+        unsigned int ys[4] = {30, 69, 40, 2};
+        requireSpansMatchBox(xs, ys, 100, 70);
+    }
+    SECTION("extends past the image") {
+        unsigned int xs[4] = {0, 400, 380, 0};
+        unsigned int ys[4] = {0, 30, 300, 250};
+        requireSpansMatchBox(xs, ys, 120, 90);
+    }
+    SECTION("self-crossing bow tie") {
+        unsigned int xs[4] = {5, 80, 80, 5};
+        unsigned int ys[4] = {5, 60, 5, 60};
+        requireSpansMatchBox(xs, ys, 90, 70);
+    }
+    SECTION("degenerate") {
+        unsigned int xs[4] = {20, 20, 20, 20};
+        unsigned int ys[4] = {10, 10, 40, 40};
+        requireSpansMatchBox(xs, ys, 50, 50);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// lruCache — shared processor / result cache
+// ---------------------------------------------------------------------------
+TEST_CASE("lruCache drops the least recently used entry", "[utils]") {
+    lruCache<int, std::string> cache(2);
+    std::string out;
+    CHECK_FALSE(cache.find(1, out));
+    cache.insert(1, "one");
+    cache.insert(2, "two");
+    REQUIRE(cache.find(1, out));
+    CHECK(out == "one");
+    cache.insert(3, "three");       // 2 is now the oldest
+    CHECK(cache.size() == 2);
+    CHECK_FALSE(cache.find(2, out));
+    CHECK(cache.find(1, out));
+    CHECK(cache.find(3, out));
+    CHECK(cache.hits() == 3);
+    CHECK(cache.misses() == 2);
+}
+
+TEST_CASE("lruCache insert replaces an existing key", "[utils]") {
+    lruCache<int, std::shared_ptr<int>> cache(4);
+    cache.insert(7, std::make_shared<int>(1));
+    cache.insert(7, std::make_shared<int>(2));
+    std::shared_ptr<int> out;
+    CHECK(cache.size() == 1);
+    REQUIRE(cache.find(7, out));
+    CHECK(*out == 2);
+
+    cache.clear();
+    CHECK(cache.size() == 0);
+    CHECK_FALSE(cache.find(7, out));
+}
+
+TEST_CASE("lruCache is safe to share between threads", "[utils]") {
+    lruCache<int, int> cache(8);
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&cache, &wrong, t] {
+            for (int i = 0; i < 2000; i++) {
+                int key = (i + t) % 12;
+                int value;
+                if (!cache.find(key, value))
+                    cache.insert(key, key * 10);
+                else if (value != key * 10)
+                    wrong++;
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    CHECK(wrong == 0);
+    CHECK(cache.size() <= 8);
+    CHECK(cache.hits() + cache.misses() == 8000);
+}
+
+TEST_CASE("stageTimer lists each stage then the total", "[utils]") {
+    stageTimer timer;
+    timer.mark("first");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    timer.mark("second");
+    std::string summary = timer.summary();
+    size_t first = summary.find("first ");
+    size_t second = summary.find("second ");
+    size_t total = summary.find("total ");
+    REQUIRE(first != std::string::npos);
+    REQUIRE(second != std::string::npos);
+    REQUIRE(total != std::string::npos);
+    CHECK(first < second);
+    CHECK(second < total);
+    CHECK(summary.back() == 's');
+}
+
+TEST_CASE("residencyCache evicts the least recent past its byte budget", "[utils]") {
+    residencyCache<int, int> cache(300);
+    CHECK(cache.insert(1, 10, 100).empty());
+    CHECK(cache.insert(2, 20, 100).empty());
+    CHECK(cache.insert(3, 30, 100).empty());
+    CHECK(cache.bytes() == 300);
+
+    REQUIRE(cache.find(1));             // 1 is now most recent
+    CHECK(*cache.find(1) == 10);
+    std::vector<int> evicted = cache.insert(4, 40, 150);
+    CHECK(evicted == std::vector<int>{20, 30});
+    CHECK(cache.bytes() == 250);
+    CHECK(cache.evictions() == 2);
+    CHECK_FALSE(cache.find(2));
+    CHECK(cache.misses() == 1);
+
+    // Shrinking the budget hands back the oldest first
+    CHECK(cache.setBudget(150) == std::vector<int>{10});
+    CHECK(cache.size() == 1);
+}
+
+TEST_CASE("residencyCache keeps the newest entry even over budget", "[utils]") {
+    residencyCache<int, int> cache(100);
+    cache.insert(1, 10, 50);
+    CHECK(cache.insert(2, 20, 500) == std::vector<int>{10});
+    CHECK(cache.size() == 1);
+    CHECK(cache.bytes() == 500);
+
+    // Replacing a key hands the old value back without counting an eviction
+    CHECK(cache.insert(2, 21, 80) == std::vector<int>{20});
+    CHECK(cache.evictions() == 1);
+    int value = 0;
+    CHECK(cache.erase(2, value));
+    CHECK(value == 21);
+    CHECK(cache.bytes() == 0);
+    CHECK_FALSE(cache.erase(2, value));
+}
+
+TEST_CASE("renderTicket settles once and wakes a waiter", "[utils]") {
+    auto ticket = std::make_shared<renderTicket>();
+    CHECK(ticket->waitFor(std::chrono::milliseconds(1)) == rs_pending);
+
+    std::thread worker([ticket] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ticket->complete();
+        ticket->fail("too late");           // first outcome sticks
+    });
+    CHECK(ticket->wait() == rs_done);
+    worker.join();
+    CHECK(ticket->status() == rs_done);
+    CHECK(ticket->error().empty());
+}
+
+TEST_CASE("renderTicket chains settle with the one they follow", "[utils]") {
+    auto newer = std::make_shared<renderTicket>();
+    auto older = std::make_shared<renderTicket>();
+    auto last = std::make_shared<renderTicket>();
+    newer->chain(older);
+    older->chain(last);
+    newer->fail("no shaders");
+    CHECK(older->status() == rs_failed);
+    CHECK(last->error() == "no shaders");
+
+    // Chained after the fact, it settles right away
+    auto late = std::make_shared<renderTicket>();
+    newer->chain(late);
+    CHECK(late->status() == rs_failed);
+
+    auto cancelled = std::make_shared<renderTicket>();
+    cancelled->cancel();
+    CHECK(cancelled->wait() == rs_cancelled);
+}